@@ -0,0 +1,396 @@
+/*
+ * imagecache.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imagecache.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageReader>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+namespace {
+
+struct CacheEntry
+{
+    QDateTime lastModified;
+    qint64 size;
+    quint64 lastUsed;
+    QImage image;
+    QPixmap pixmap;
+};
+
+qint64 imageCost(const QImage &image)
+{
+    return image.byteCount();
+}
+
+qint64 pixmapCost(const QPixmap &pixmap)
+{
+    return qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+/**
+ * Pixmaps may only be released on the GUI thread.
+ */
+bool isGuiThread()
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    return !app || app->thread() == QThread::currentThread();
+}
+
+/**
+ * Identifies the version of a file, to be able to tell whether a cached
+ * image is still up to date.
+ */
+struct FileVersion
+{
+    explicit FileVersion(const QString &fileName)
+    {
+        const QFileInfo fileInfo(fileName);
+        path = fileInfo.canonicalFilePath();
+        lastModified = fileInfo.lastModified();
+        size = fileInfo.size();
+    }
+
+    bool exists() const { return !path.isEmpty(); }
+
+    QString path;
+    QDateTime lastModified;
+    qint64 size;
+};
+
+struct ImageCacheData
+{
+    ImageCacheData()
+        : maximumCost(256 * 1024 * 1024)
+        , totalCost(0)
+        , usageCounter(0)
+    {}
+
+    CacheEntry *find(const FileVersion &version);
+    CacheEntry &findOrInsert(const FileVersion &version);
+    void remove(const QString &path);
+    bool releaseUnreferenced(CacheEntry &entry, bool releasePixmap);
+    void trim();
+
+    QMutex mutex;
+    QHash<QString, CacheEntry> entries;
+    QVector<QPixmap> stalePixmaps;
+    qint64 maximumCost;
+    qint64 totalCost;
+    quint64 usageCounter;
+};
+
+/**
+ * Returns the entry for the given file, or null when the file is not cached
+ * or has changed since it was cached.
+ */
+CacheEntry *ImageCacheData::find(const FileVersion &version)
+{
+    auto it = entries.find(version.path);
+    if (it == entries.end())
+        return nullptr;
+
+    if (it->lastModified != version.lastModified || it->size != version.size) {
+        remove(version.path);
+        return nullptr;
+    }
+
+    it->lastUsed = ++usageCounter;
+    return &it.value();
+}
+
+CacheEntry &ImageCacheData::findOrInsert(const FileVersion &version)
+{
+    if (CacheEntry *entry = find(version))
+        return *entry;
+
+    CacheEntry &entry = entries[version.path];
+    entry.lastModified = version.lastModified;
+    entry.size = version.size;
+    entry.lastUsed = ++usageCounter;
+    return entry;
+}
+
+void ImageCacheData::remove(const QString &path)
+{
+    auto it = entries.find(path);
+    if (it == entries.end())
+        return;
+
+    totalCost -= imageCost(it->image);
+
+    // Off the GUI thread, the pixmap is kept until the next trim() on the GUI
+    // thread, and still counts towards the total cost until then
+    if (isGuiThread())
+        totalCost -= pixmapCost(it->pixmap);
+    else if (!it->pixmap.isNull())
+        stalePixmaps.append(it->pixmap);
+
+    entries.erase(it);
+}
+
+/**
+ * Releases the image and, when \a releasePixmap is true, the pixmap of the
+ * given \a entry that are not referenced outside of the cache. Returns
+ * whether the entry is now empty.
+ */
+bool ImageCacheData::releaseUnreferenced(CacheEntry &entry, bool releasePixmap)
+{
+    if (!entry.image.isNull() && entry.image.isDetached()) {
+        totalCost -= imageCost(entry.image);
+        entry.image = QImage();
+    }
+    if (releasePixmap && !entry.pixmap.isNull() && entry.pixmap.isDetached()) {
+        totalCost -= pixmapCost(entry.pixmap);
+        entry.pixmap = QPixmap();
+    }
+
+    return entry.image.isNull() && entry.pixmap.isNull();
+}
+
+/**
+ * Evicts the least recently used images that are not referenced outside of
+ * the cache, until the total cost is within the maximum cost.
+ */
+void ImageCacheData::trim()
+{
+    const bool evictPixmaps = isGuiThread();
+
+    if (evictPixmaps && !stalePixmaps.isEmpty()) {
+        for (const QPixmap &pixmap : stalePixmaps)
+            totalCost -= pixmapCost(pixmap);
+        stalePixmaps.clear();
+    }
+
+    if (totalCost <= maximumCost)
+        return;
+
+    QVector<QPair<quint64, QString>> candidates;
+
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        const CacheEntry &entry = it.value();
+        if ((!entry.image.isNull() && entry.image.isDetached()) ||
+                (evictPixmaps && !entry.pixmap.isNull() && entry.pixmap.isDetached())) {
+            candidates.append(qMakePair(entry.lastUsed, it.key()));
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto &candidate : candidates) {
+        if (totalCost <= maximumCost)
+            break;
+
+        if (releaseUnreferenced(entries[candidate.second], evictPixmaps))
+            entries.remove(candidate.second);
+    }
+}
+
+Q_GLOBAL_STATIC(ImageCacheData, cacheData)
+
+/**
+ * Decodes the image. Should be called without holding the lock, so other
+ * images can be loaded in parallel.
+ */
+QImage readImage(const FileVersion &version)
+{
+    QImageReader reader(version.path);
+    return reader.read();
+}
+
+QImage loadImage(const FileVersion &version)
+{
+    ImageCacheData *d = cacheData();
+
+    {
+        QMutexLocker locker(&d->mutex);
+        if (CacheEntry *entry = d->find(version))
+            if (!entry->image.isNull())
+                return entry->image;
+    }
+
+    const QImage image = readImage(version);
+    if (image.isNull())
+        return image;
+
+    QMutexLocker locker(&d->mutex);
+
+    // Another thread may have loaded the same image in the meantime
+    CacheEntry &entry = d->findOrInsert(version);
+    if (entry.image.isNull()) {
+        entry.image = image;
+        d->totalCost += imageCost(image);
+    }
+
+    const QImage result = entry.image;
+    d->trim();
+    return result;
+}
+
+} // anonymous namespace
+
+
+QImage ImageCache::loadImage(const QString &fileName)
+{
+    const FileVersion version(fileName);
+    if (!version.exists())
+        return QImage();
+
+    return ::loadImage(version);
+}
+
+QPixmap ImageCache::loadPixmap(const QString &fileName)
+{
+    const FileVersion version(fileName);
+    if (!version.exists())
+        return QPixmap();
+
+    ImageCacheData *d = cacheData();
+    QImage image;
+
+    {
+        QMutexLocker locker(&d->mutex);
+        if (CacheEntry *entry = d->find(version)) {
+            if (!entry->pixmap.isNull())
+                return entry->pixmap;
+            image = entry->image;
+        }
+    }
+
+    // Only the pixmap is cached, since the image isn't needed once it is
+    // converted
+    if (image.isNull())
+        image = readImage(version);
+    if (image.isNull())
+        return QPixmap();
+
+    const QPixmap pixmap = QPixmap::fromImage(image);
+    image = QImage();
+
+    QMutexLocker locker(&d->mutex);
+
+    CacheEntry &entry = d->findOrInsert(version);
+    if (entry.pixmap.isNull()) {
+        entry.pixmap = pixmap;
+        d->totalCost += pixmapCost(pixmap);
+    }
+
+    // A cached image, for example a prefetched one, is no longer needed
+    // unless it is used elsewhere
+    if (!entry.image.isNull() && entry.image.isDetached()) {
+        d->totalCost -= imageCost(entry.image);
+        entry.image = QImage();
+    }
+
+    const QPixmap result = entry.pixmap;
+    d->trim();
+    return result;
+}
+
+void ImageCache::insert(const QString &fileName, const QImage &image)
+{
+    const FileVersion version(fileName);
+    if (!version.exists() || image.isNull())
+        return;
+
+    ImageCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+
+    CacheEntry &entry = d->findOrInsert(version);
+    if (entry.image.isNull()) {
+        entry.image = image;
+        d->totalCost += imageCost(image);
+    }
+
+    d->trim();
+}
+
+void ImageCache::remove(const QString &fileName)
+{
+    const QString path = QFileInfo(fileName).canonicalFilePath();
+    if (path.isEmpty())
+        return;
+
+    ImageCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+    d->remove(path);
+}
+
+void ImageCache::release(const QString &fileName)
+{
+    const QString path = QFileInfo(fileName).canonicalFilePath();
+    if (path.isEmpty())
+        return;
+
+    ImageCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+
+    auto it = d->entries.find(path);
+    if (it != d->entries.end() && d->releaseUnreferenced(it.value(), isGuiThread()))
+        d->entries.erase(it);
+}
+
+void ImageCache::clear()
+{
+    ImageCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+    d->entries.clear();
+    d->stalePixmaps.clear();
+    d->totalCost = 0;
+}
+
+void ImageCache::setMaximumCost(qint64 bytes)
+{
+    ImageCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+    d->maximumCost = bytes;
+    d->trim();
+}
+
+qint64 ImageCache::maximumCost()
+{
+    ImageCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+    return d->maximumCost;
+}
+
+qint64 ImageCache::totalCost()
+{
+    ImageCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+    return d->totalCost;
+}
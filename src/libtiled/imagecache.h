@@ -0,0 +1,107 @@
+/*
+ * imagecache.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QImage>
+#include <QPixmap>
+#include <QString>
+
+namespace Tiled {
+
+/**
+ * A process-wide cache of images loaded from files, so that images used by
+ * several tilesets, tiles or image layers are only loaded once.
+ *
+ * Images are keyed by their canonical path and are reloaded when the file's
+ * modification time or size has changed. Since QImage and QPixmap are
+ * implicitly shared, the returned handles share their data with the cache.
+ *
+ * When the total size of the cached images exceeds the maximum cost, the
+ * least recently used images that are no longer referenced outside of the
+ * cache are evicted.
+ *
+ * Loading images is thread-safe, but pixmaps may only be requested from the
+ * GUI thread. Pixmaps of files that changed are only released once the cache
+ * is used on the GUI thread again.
+ */
+class TILEDSHARED_EXPORT ImageCache
+{
+public:
+    /**
+     * Returns the image stored in \a fileName, loading it when it is not
+     * cached yet. Returns a null image when the file could not be loaded.
+     */
+    static QImage loadImage(const QString &fileName);
+
+    /**
+     * Returns the image stored in \a fileName as a pixmap, which is shared
+     * by everybody requesting the same file. The image it was converted from
+     * is not kept in the cache.
+     */
+    static QPixmap loadPixmap(const QString &fileName);
+
+    /**
+     * Stores an \a image that was obtained for \a fileName by other means,
+     * like from the TilesetCache, so that it does not need to be decoded.
+     * Does nothing when the image for this file is already cached.
+     */
+    static void insert(const QString &fileName, const QImage &image);
+
+    /**
+     * Removes the given file from the cache. Used when the file is known to
+     * have changed.
+     */
+    static void remove(const QString &fileName);
+
+    /**
+     * Releases the cached image and pixmap of the given file right away,
+     * when they are not referenced outside of the cache. Used by callers
+     * that keep track of their own memory budget.
+     */
+    static void release(const QString &fileName);
+
+    static void clear();
+
+    /**
+     * Sets the maximum number of bytes used by the cached images. Images in
+     * use are never evicted, so this limit can be exceeded. Defaults to
+     * 256 MB.
+     */
+    static void setMaximumCost(qint64 bytes);
+    static qint64 maximumCost();
+
+    /**
+     * Returns the number of bytes used by the cached images.
+     */
+    static qint64 totalCost();
+};
+
+} // namespace Tiled
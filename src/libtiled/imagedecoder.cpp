@@ -0,0 +1,260 @@
+/*
+ * imagedecoder.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imagedecoder.h"
+
+#include <QMutex>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+namespace Tiled {
+
+/**
+ * Shared between the decoder and its jobs, so that jobs finishing after the
+ * decoder has been deleted don't try to deliver their result.
+ */
+struct ImageDecoderState
+{
+    QMutex mutex;
+    ImageDecoder *decoder;
+};
+
+} // namespace Tiled
+
+using namespace Tiled;
+
+namespace {
+
+class DecodeJob : public QRunnable
+{
+public:
+    DecodeJob(const ImageReference &reference,
+              const QString &key,
+              int id,
+              const QSharedPointer<QAtomicInt> &canceled,
+              const QSharedPointer<ImageDecoderState> &state)
+        : mReference(reference)
+        , mKey(key)
+        , mId(id)
+        , mCanceled(canceled)
+        , mState(state)
+    {}
+
+    void run() override
+    {
+        if (mCanceled->load())
+            return;
+
+        const QImage image = ImageDecoder::decode(mReference);
+
+        QMutexLocker locker(&mState->mutex);
+        if (mState->decoder && !mCanceled->load()) {
+            QMetaObject::invokeMethod(mState->decoder, "jobFinished",
+                                      Qt::QueuedConnection,
+                                      Q_ARG(QString, mKey),
+                                      Q_ARG(int, mId),
+                                      Q_ARG(QImage, image));
+        }
+    }
+
+private:
+    const ImageReference mReference;
+    const QString mKey;
+    const int mId;
+    const QSharedPointer<QAtomicInt> mCanceled;
+    const QSharedPointer<ImageDecoderState> mState;
+};
+
+/**
+ * Decodes images until there are none left, taking the index of the next
+ * image from a shared counter.
+ */
+void decodeRemaining(const QVector<ImageReference> &references,
+                     QImage *images,
+                     QAtomicInt &next)
+{
+    int index;
+    while ((index = next.fetchAndAddRelaxed(1)) < references.size())
+        images[index] = ImageDecoder::decode(references.at(index));
+}
+
+class DecodeAllJob : public QRunnable
+{
+public:
+    DecodeAllJob(const QVector<ImageReference> &references,
+                 QImage *images,
+                 QAtomicInt &next,
+                 QSemaphore &done)
+        : mReferences(references)
+        , mImages(images)
+        , mNext(next)
+        , mDone(done)
+    {}
+
+    void run() override
+    {
+        decodeRemaining(mReferences, mImages, mNext);
+        mDone.release();
+    }
+
+private:
+    const QVector<ImageReference> &mReferences;
+    QImage *mImages;
+    QAtomicInt &mNext;
+    QSemaphore &mDone;
+};
+
+} // anonymous namespace
+
+
+ImageDecoder::ImageDecoder(QObject *parent)
+    : QObject(parent)
+    , mState(new ImageDecoderState)
+    , mNextJobId(0)
+{
+    mState->decoder = this;
+}
+
+ImageDecoder::~ImageDecoder()
+{
+    for (const Job &job : mJobs)
+        job.canceled->store(1);
+
+    QMutexLocker locker(&mState->mutex);
+    mState->decoder = nullptr;
+}
+
+QString ImageDecoder::request(const ImageReference &reference)
+{
+    QString key = reference.source;
+
+    if (key.isEmpty()) {
+        // Embedded images are not shared
+        key = QLatin1String("#embedded-") + QString::number(mNextJobId);
+    } else {
+        auto it = mJobs.find(key);
+        if (it != mJobs.end()) {
+            ++it->references;
+            return key;
+        }
+    }
+
+    Job job;
+    job.id = mNextJobId++;
+    job.references = 1;
+    job.canceled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    mJobs.insert(key, job);
+
+    QThreadPool::globalInstance()->start(new DecodeJob(reference, key, job.id,
+                                                       job.canceled, mState));
+    return key;
+}
+
+void ImageDecoder::release(const QString &key)
+{
+    auto it = mJobs.find(key);
+    if (it == mJobs.end())
+        return;
+
+    if (--it->references > 0)
+        return;
+
+    it->canceled->store(1);
+    mJobs.erase(it);
+}
+
+QImage ImageDecoder::decode(const ImageReference &reference)
+{
+    return reference.create();
+}
+
+QVector<QImage> ImageDecoder::decodeAll(const QVector<ImageReference> &references)
+{
+    // Combine references to the same file
+    QVector<ImageReference> unique;
+    QVector<int> uniqueIndexes(references.size());
+    QHash<QString, int> indexForFile;
+
+    for (int i = 0; i < references.size(); ++i) {
+        const ImageReference &reference = references.at(i);
+
+        if (!reference.source.isEmpty()) {
+            auto it = indexForFile.constFind(reference.source);
+            if (it != indexForFile.constEnd()) {
+                uniqueIndexes[i] = it.value();
+                continue;
+            }
+            indexForFile.insert(reference.source, unique.size());
+        }
+
+        uniqueIndexes[i] = unique.size();
+        unique.append(reference);
+    }
+
+    QVector<QImage> decoded(unique.size());
+    QImage *decodedData = decoded.data();
+    QAtomicInt next(0);
+    QSemaphore done;
+    int helpers = 0;
+
+    // Only idle threads are used, since waiting for queued jobs could take
+    // arbitrarily long
+    QThreadPool *threadPool = QThreadPool::globalInstance();
+    const int maxHelpers = qMin(unique.size(), QThread::idealThreadCount()) - 1;
+
+    for (int i = 0; i < maxHelpers; ++i) {
+        DecodeAllJob *job = new DecodeAllJob(unique, decodedData, next, done);
+        if (!threadPool->tryStart(job)) {
+            delete job;
+            break;
+        }
+        ++helpers;
+    }
+
+    decodeRemaining(unique, decodedData, next);
+    done.acquire(helpers);
+
+    QVector<QImage> images(references.size());
+    for (int i = 0; i < references.size(); ++i)
+        images[i] = decoded.at(uniqueIndexes.at(i));
+
+    return images;
+}
+
+void ImageDecoder::jobFinished(const QString &key, int jobId, const QImage &image)
+{
+    // Ignore results for requests that have been released
+    auto it = mJobs.find(key);
+    if (it == mJobs.end() || it->id != jobId)
+        return;
+
+    mJobs.erase(it);
+    emit imageDecoded(key, image);
+}
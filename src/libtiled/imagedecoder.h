@@ -0,0 +1,118 @@
+/*
+ * imagedecoder.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "imagereference.h"
+#include "tiled_global.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+
+namespace Tiled {
+
+struct ImageDecoderState;
+
+/**
+ * A queue of images to decode on the global thread pool.
+ *
+ * Requests for the same image file are combined, so that an image used by
+ * several tilesets or maps is only decoded once. The decoded images are
+ * delivered by the imageDecoded() signal, on the thread the decoder lives in.
+ * An image that failed to load is delivered as a null image.
+ *
+ * The TilesetManager owns the decoder shared by everything that loads images
+ * in the background.
+ */
+class TILEDSHARED_EXPORT ImageDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageDecoder(QObject *parent = nullptr);
+    ~ImageDecoder();
+
+    /**
+     * Queues the image referenced by \a reference for decoding. Returns the
+     * key by which the decoded image will be delivered. For image files,
+     * this is the file name.
+     *
+     * When the image is already queued, no new job is created. The request
+     * is done once the image has been delivered.
+     */
+    QString request(const ImageReference &reference);
+
+    /**
+     * Releases a request made with request(). When nobody is waiting for the
+     * image anymore, it is not decoded if decoding hasn't started yet.
+     */
+    void release(const QString &key);
+
+    /**
+     * Returns the number of images that are queued or being decoded.
+     */
+    int pendingCount() const { return mJobs.size(); }
+
+    /**
+     * Decodes the given image on the calling thread.
+     */
+    static QImage decode(const ImageReference &reference);
+
+    /**
+     * Decodes the given images in parallel, returning when all of them have
+     * been decoded. Images referenced more than once are decoded only once.
+     *
+     * The calling thread takes part in decoding, so this is also safe to use
+     * from a thread pool thread.
+     */
+    static QVector<QImage> decodeAll(const QVector<ImageReference> &references);
+
+signals:
+    void imageDecoded(const QString &key, const QImage &image);
+
+private slots:
+    void jobFinished(const QString &key, int jobId, const QImage &image);
+
+private:
+    struct Job
+    {
+        int id;
+        int references;
+        QSharedPointer<QAtomicInt> canceled;
+    };
+
+    QHash<QString, Job> mJobs;
+    QSharedPointer<ImageDecoderState> mState;
+    int mNextJobId;
+};
+
+} // namespace Tiled
@@ -31,6 +31,7 @@
 
 #include "tiled_global.h"
 
+#include "imagecache.h"
 #include "layer.h"
 
 #include <QColor>
@@ -134,7 +135,7 @@ private:
 
 inline bool ImageLayer::loadFromImage(const QString &fileName)
 {
-    return loadFromImage(QImage(fileName), fileName);
+    return loadFromImage(ImageCache::loadImage(fileName), fileName);
 }
 
 } // namespace Tiled
@@ -20,8 +20,47 @@
 
 #include "imagereference.h"
 
+#include "compression.h"
+#include "imagecache.h"
+
+#include <QBuffer>
+#include <QImageWriter>
+
 namespace Tiled {
 
+// The format name of images embedded as raw premultiplied RGBA pixels
+static const char PixelDataFormat[] = "rgba-premultiplied";
+
+// Embedded pixel data is rejected when its size would exceed this amount of
+// bytes, to avoid huge allocations when reading a broken or malicious file
+static const qint64 MaximumPixelDataSize = 256 * 1024 * 1024;
+
+/**
+ * Creates an image from tightly packed premultiplied RGBA pixels. Returns a
+ * null image when the amount of data does not match the \a size.
+ */
+static QImage fromPixelData(const QByteArray &data, QSize size)
+{
+    if (size.isEmpty())
+        return QImage();
+
+    const int bytesPerLine = size.width() * 4;
+    if (qint64(bytesPerLine) * size.height() != data.size())
+        return QImage();
+
+    QImage image(size, QImage::Format_RGBA8888_Premultiplied);
+    if (image.isNull())
+        return QImage();
+
+    for (int y = 0; y < size.height(); ++y) {
+        memcpy(image.scanLine(y),
+               data.constData() + y * bytesPerLine,
+               bytesPerLine);
+    }
+
+    return image;
+}
+
 bool ImageReference::hasImage() const
 {
     return !source.isEmpty() || !data.isEmpty();
@@ -30,11 +69,87 @@ bool ImageReference::hasImage() const
 QImage Tiled::ImageReference::create() const
 {
     if (!source.isEmpty())
-        return QImage(source);
-    else if (!data.isEmpty())
-        return QImage::fromData(data, format);
+        return ImageCache::loadImage(source);
+    if (data.isEmpty())
+        return QImage();
+
+    if (format == PixelDataFormat) {
+        if (compression != "zlib")
+            return QImage();
+
+        if (size.isEmpty())
+            return QImage();
+
+        const qint64 expectedSize = qint64(size.width()) * size.height() * 4;
+        if (expectedSize > MaximumPixelDataSize)
+            return QImage();
+
+        return fromPixelData(decompress(data, qMax(int(expectedSize), 1024)), size);
+    }
+
+    if (!compression.isEmpty())
+        return QImage();
+
+    return QImage::fromData(data, format);
+}
+
+/**
+ * Returns a reference holding the given \a image as embedded data, stored in
+ * the requested \a format.
+ *
+ * Pixel data is the fastest to load, since it only needs to be decompressed,
+ * whereas PNG and WebP are more compact.
+ */
+ImageReference ImageReference::embed(const QImage &image,
+                                     EmbeddedImageFormat format)
+{
+    ImageReference reference;
+    reference.size = image.size();
+
+    switch (format) {
+    case EmbedPixelData: {
+        const QImage pixels =
+                image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+        const int bytesPerLine = pixels.width() * 4;
+
+        QByteArray data;
+        data.reserve(bytesPerLine * pixels.height());
+        for (int y = 0; y < pixels.height(); ++y)
+            data.append(reinterpret_cast<const char*>(pixels.constScanLine(y)),
+                        bytesPerLine);
+
+        reference.format = PixelDataFormat;
+        reference.compression = "zlib";
+        reference.data = compress(data, Zlib);
+        return reference;
+    }
+    case EmbedWebP:
+        if (QImageWriter::supportedImageFormats().contains("webp")) {
+            QBuffer buffer(&reference.data);
+            buffer.open(QIODevice::WriteOnly);
+
+            // The Qt WebP plugin switches to lossless compression at 100
+            QImageWriter writer(&buffer, "webp");
+            writer.setQuality(100);
+
+            if (writer.write(image)) {
+                reference.format = "webp";
+                return reference;
+            }
+
+            reference.data.clear();
+        }
+        break;
+    case EmbedPng:
+        break;
+    }
+
+    QBuffer buffer(&reference.data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "png");
+    reference.format = "png";
 
-    return QImage();
+    return reference;
 }
 
 } // namespace Tiled
@@ -26,6 +26,15 @@
 
 namespace Tiled {
 
+/**
+ * The ways in which images can be embedded in a map or tileset file.
+ */
+enum EmbeddedImageFormat {
+    EmbedPng,
+    EmbedPixelData,     // Raw premultiplied RGBA, zlib compressed
+    EmbedWebP           // Lossless WebP, falls back to PNG when unsupported
+};
+
 class ImageReference
 {
 public:
@@ -35,11 +44,15 @@ public:
     QColor transparentColor;
     QSize size;
     QByteArray format;
+    QByteArray compression;
     QByteArray data;
     bool loaded;
 
     bool hasImage() const;
     QImage create() const;
+
+    static ImageReference embed(const QImage &image,
+                                EmbeddedImageFormat format);
 };
 
 } // namespace Tiled
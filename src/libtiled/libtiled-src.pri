@@ -6,12 +6,16 @@ SOURCES += $$PWD/compression.cpp \
     $$PWD/grouplayer.cpp \
     $$PWD/hex.cpp \
     $$PWD/hexagonalrenderer.cpp \
+    $$PWD/imagecache.cpp \
+    $$PWD/imagedecoder.cpp \
     $$PWD/imagelayer.cpp \
     $$PWD/imagereference.cpp \
     $$PWD/isometricrenderer.cpp \
     $$PWD/layer.cpp \
     $$PWD/map.cpp \
     $$PWD/mapobject.cpp \
+    $$PWD/mapobjectindex.cpp \
+    $$PWD/mappedxmlfile.cpp \
     $$PWD/mapreader.cpp \
     $$PWD/maprenderer.cpp \
     $$PWD/maptovariantconverter.cpp \
@@ -25,8 +29,11 @@ SOURCES += $$PWD/compression.cpp \
     $$PWD/staggeredrenderer.cpp \
     $$PWD/tile.cpp \
     $$PWD/tileanimationdriver.cpp \
+    $$PWD/tileimageloader.cpp \
     $$PWD/tilelayer.cpp \
+    $$PWD/tilemask.cpp \
     $$PWD/tileset.cpp \
+    $$PWD/tilesetcache.cpp \
     $$PWD/tilesetformat.cpp \
     $$PWD/tilesetmanager.cpp \
     $$PWD/varianttomapconverter.cpp
@@ -36,6 +43,8 @@ HEADERS += $$PWD/compression.h \
     $$PWD/grouplayer.h \
     $$PWD/hex.h \
     $$PWD/hexagonalrenderer.h \
+    $$PWD/imagecache.h \
+    $$PWD/imagedecoder.h \
     $$PWD/imagelayer.h \
     $$PWD/imagereference.h \
     $$PWD/isometricrenderer.h \
@@ -44,6 +53,8 @@ HEADERS += $$PWD/compression.h \
     $$PWD/map.h \
     $$PWD/mapformat.h \
     $$PWD/mapobject.h \
+    $$PWD/mapobjectindex.h \
+    $$PWD/mappedxmlfile.h \
     $$PWD/mapreader.h \
     $$PWD/maprenderer.h \
     $$PWD/maptovariantconverter.h \
@@ -61,8 +72,11 @@ HEADERS += $$PWD/compression.h \
     $$PWD/tileanimationdriver.h \
     $$PWD/tiled.h \
     $$PWD/tiled_global.h \
+    $$PWD/tileimageloader.h \
     $$PWD/tilelayer.h \
+    $$PWD/tilemask.h \
     $$PWD/tileset.h \
+    $$PWD/tilesetcache.h \
     $$PWD/tilesetformat.h \
     $$PWD/tilesetmanager.h \
     $$PWD/varianttomapconverter.h
@@ -130,6 +130,13 @@ public:
      *         occurred. The error can be retrieved by errorString().
      */
     virtual bool write(const Map *map, const QString &fileName) = 0;
+
+    /**
+     * Returns a new instance of this format, which allows writing maps on
+     * multiple threads at once, or nullptr when this format does not
+     * support this. The caller takes ownership of the returned instance.
+     */
+    virtual MapFormat *clone() const { return nullptr; }
 };
 
 } // namespace Tiled
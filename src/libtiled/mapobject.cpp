@@ -143,6 +143,16 @@ QRectF MapObject::boundsUseTile() const
     return bounds();
 }
 
+/**
+ * Lets the object group know the area covered by this object has changed,
+ * so that it can keep its spatial index up to date.
+ */
+void MapObject::geometryChanged()
+{
+    if (mObjectGroup)
+        mObjectGroup->objectGeometryChanged(this);
+}
+
 /*
  * This is somewhat of a workaround for dealing with the ways different objects
  * align.
@@ -184,6 +184,8 @@ public:
     MapObject *clone() const;
 
 private:
+    void geometryChanged();
+
     void flipRectObject(const QTransform &flipTransform);
     void flipPolygonObject(const QTransform &flipTransform);
     void flipTileObject(const QTransform &flipTransform);
@@ -258,7 +260,7 @@ inline const QPointF &MapObject::position() const
  * Sets the position of this object.
  */
 inline void MapObject::setPosition(const QPointF &pos)
-{ mPos = pos; }
+{ mPos = pos; geometryChanged(); }
 
 /**
  * Returns the x position of this object.
@@ -270,7 +272,7 @@ inline qreal MapObject::x() const
  * Sets the x position of this object.
  */
 inline void MapObject::setX(qreal x)
-{ mPos.setX(x); }
+{ mPos.setX(x); geometryChanged(); }
 
 /**
  * Returns the y position of this object.
@@ -282,7 +284,7 @@ inline qreal MapObject::y() const
  * Sets the x position of this object.
  */
 inline void MapObject::setY(qreal y)
-{ mPos.setY(y); }
+{ mPos.setY(y); geometryChanged(); }
 
 /**
  * Returns the size of this object.
@@ -294,7 +296,7 @@ inline const QSizeF &MapObject::size() const
  * Sets the size of this object.
  */
 inline void MapObject::setSize(const QSizeF &size)
-{ mSize = size; }
+{ mSize = size; geometryChanged(); }
 
 inline void MapObject::setSize(qreal width, qreal height)
 { setSize(QSizeF(width, height)); }
@@ -309,7 +311,7 @@ inline qreal MapObject::width() const
  * Sets the width of this object.
  */
 inline void MapObject::setWidth(qreal width)
-{ mSize.setWidth(width); }
+{ mSize.setWidth(width); geometryChanged(); }
 
 /**
  * Returns the height of this object.
@@ -321,7 +323,7 @@ inline qreal MapObject::height() const
  * Sets the height of this object.
  */
 inline void MapObject::setHeight(qreal height)
-{ mSize.setHeight(height); }
+{ mSize.setHeight(height); geometryChanged(); }
 
 /**
  * Sets the position and size of this object.
@@ -330,6 +332,7 @@ inline void MapObject::setBounds(const QRectF &bounds)
 {
     mPos = bounds.topLeft();
     mSize = bounds.size();
+    geometryChanged();
 }
 
 /**
@@ -352,7 +355,7 @@ inline const QPolygonF &MapObject::polygon() const
  * \sa setShape()
  */
 inline void MapObject::setPolygon(const QPolygonF &polygon)
-{ mPolygon = polygon; }
+{ mPolygon = polygon; geometryChanged(); }
 
 /**
  * Returns the shape of the object.
@@ -364,7 +367,7 @@ inline MapObject::Shape MapObject::shape() const
  * Sets the shape of the object.
  */
 inline void MapObject::setShape(MapObject::Shape shape)
-{ mShape = shape; }
+{ mShape = shape; geometryChanged(); }
 
 /**
  * Returns true if this is a Polygon or a Polyline.
@@ -391,7 +394,7 @@ inline const Cell &MapObject::cell() const
  * \warning The object shape is ignored for tile objects!
  */
 inline void MapObject::setCell(const Cell &cell)
-{ mCell = cell; }
+{ mCell = cell; geometryChanged(); }
 
 /**
  * Returns the object group this object belongs to.
@@ -416,7 +419,7 @@ inline qreal MapObject::rotation() const
  * Sets the rotation of the object in degrees clockwise.
  */
 inline void MapObject::setRotation(qreal rotation)
-{ mRotation = rotation; }
+{ mRotation = rotation; geometryChanged(); }
 
 inline bool MapObject::isVisible() const
 { return mVisible; }
@@ -0,0 +1,332 @@
+/*
+ * mapobjectindex.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mapobjectindex.h"
+
+#include <QPair>
+#include <QSet>
+#include <QtMath>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+/**
+ * Returns whether the rectangles intersect, also when they only touch. This
+ * differs from QRectF::intersects(), which never considers empty rectangles
+ * to intersect.
+ */
+static bool overlaps(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() &&
+            a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+static int cellCoordinate(qreal value, qreal cellSize)
+{
+    // Avoid overflowing int for objects placed very far away
+    const qreal limit = 1 << 30;
+    return qFloor(qBound(-limit, value / cellSize, limit));
+}
+
+MapObjectIndex::MapObjectIndex(qreal cellSize)
+    : mCellSize(cellSize)
+    , mNextOrder(0)
+{
+    Q_ASSERT(cellSize > 0);
+}
+
+void MapObjectIndex::insert(MapObject *object, const QRectF &bounds)
+{
+    Q_ASSERT(!mEntries.contains(object));
+
+    Entry entry;
+    entry.bounds = bounds.normalized();
+    entry.cells = cellsFor(entry.bounds);
+    entry.order = mNextOrder++;
+
+    if (qint64(entry.cells.width()) * entry.cells.height() > MaxCellsPerObject) {
+        entry.cells = QRect();
+        mLargeObjects.append(object);
+    } else {
+        addToCells(object, entry.cells);
+    }
+
+    mEntries.insert(object, entry);
+}
+
+void MapObjectIndex::update(MapObject *object, const QRectF &bounds)
+{
+    auto it = mEntries.find(object);
+    Q_ASSERT(it != mEntries.end());
+
+    Entry &entry = it.value();
+    entry.bounds = bounds.normalized();
+
+    QRect cells = cellsFor(entry.bounds);
+    if (qint64(cells.width()) * cells.height() > MaxCellsPerObject)
+        cells = QRect();
+
+    if (cells == entry.cells)
+        return;
+
+    if (entry.cells.isNull())
+        mLargeObjects.removeOne(object);
+    else
+        removeFromCells(object, entry.cells);
+
+    if (cells.isNull())
+        mLargeObjects.append(object);
+    else
+        addToCells(object, cells);
+
+    entry.cells = cells;
+}
+
+void MapObjectIndex::remove(MapObject *object)
+{
+    const auto it = mEntries.find(object);
+    if (it == mEntries.end())
+        return;
+
+    if (it.value().cells.isNull())
+        mLargeObjects.removeOne(object);
+    else
+        removeFromCells(object, it.value().cells);
+
+    mEntries.erase(it);
+}
+
+void MapObjectIndex::clear()
+{
+    mEntries.clear();
+    mCells.clear();
+    mLargeObjects.clear();
+    mNextOrder = 0;
+}
+
+void MapObjectIndex::reorder(const QList<MapObject*> &objects,
+                             MapObject *previous, MapObject *next)
+{
+    if (!next) {
+        for (MapObject *object : objects)
+            mEntries[object].order = mNextOrder++;
+        return;
+    }
+
+    // Spread the objects evenly over the space between their neighbors
+    const qreal upper = mEntries.value(next).order;
+    const qreal lower = previous ? mEntries.value(previous).order
+                                 : upper - objects.size() - 1;
+    const qreal step = (upper - lower) / (objects.size() + 1);
+
+    QVector<qreal> orders(objects.size());
+    qreal order = lower;
+    for (int i = 0; i < objects.size(); ++i) {
+        const qreal nextOrder = lower + step * (i + 1);
+
+        // Renumber all objects when running out of precision, which only
+        // happens after many objects were moved between the same neighbors
+        if (!(nextOrder > order && nextOrder < upper)) {
+            renumber(objects, previous);
+            return;
+        }
+
+        orders[i] = order = nextOrder;
+    }
+
+    for (int i = 0; i < objects.size(); ++i)
+        mEntries[objects.at(i)].order = orders.at(i);
+}
+
+QList<MapObject*> MapObjectIndex::intersecting(const QRectF &rect) const
+{
+    const QRectF queryRect = rect.normalized();
+    const QRect queryCells = cellsFor(queryRect);
+
+    QVector<QPair<qreal, MapObject*>> found;
+
+    // An object is found in each cell it shares with the query, so it is
+    // only reported for the first of those cells.
+    auto consider = [&] (MapObject *object, int x, int y) {
+        const Entry &entry = mEntries.constFind(object).value();
+        if (x == qMax(entry.cells.left(), queryCells.left()) &&
+                y == qMax(entry.cells.top(), queryCells.top()) &&
+                overlaps(entry.bounds, queryRect)) {
+            found.append(qMakePair(entry.order, object));
+        }
+    };
+
+    const qint64 queryCellCount = qint64(queryCells.width()) * queryCells.height();
+
+    if (queryCellCount <= mCells.size()) {
+        for (int y = queryCells.top(); y <= queryCells.bottom(); ++y) {
+            for (int x = queryCells.left(); x <= queryCells.right(); ++x) {
+                const auto it = mCells.constFind(cellKey(x, y));
+                if (it == mCells.constEnd())
+                    continue;
+
+                for (MapObject *object : it.value())
+                    consider(object, x, y);
+            }
+        }
+    } else {
+        // For large queries it is cheaper to go over the occupied cells
+        for (auto it = mCells.constBegin(), end = mCells.constEnd(); it != end; ++it) {
+            const int x = int(quint32(it.key()));
+            const int y = int(quint32(it.key() >> 32));
+            if (!queryCells.contains(x, y))
+                continue;
+
+            for (MapObject *object : it.value())
+                consider(object, x, y);
+        }
+    }
+
+    for (MapObject *object : mLargeObjects) {
+        const Entry &entry = mEntries.constFind(object).value();
+        if (overlaps(entry.bounds, queryRect))
+            found.append(qMakePair(entry.order, object));
+    }
+
+    std::sort(found.begin(), found.end());
+
+    QList<MapObject*> objects;
+    objects.reserve(found.size());
+    for (const auto &pair : found)
+        objects.append(pair.second);
+
+    return objects;
+}
+
+QRectF MapObjectIndex::boundingRect() const
+{
+    QRect cells;
+    for (auto it = mCells.constBegin(), end = mCells.constEnd(); it != end; ++it) {
+        const int x = int(quint32(it.key()));
+        const int y = int(quint32(it.key() >> 32));
+        cells |= QRect(x, y, 1, 1);
+    }
+
+    bool empty = cells.isEmpty();
+    QRectF rect(cells.x() * mCellSize, cells.y() * mCellSize,
+                cells.width() * mCellSize, cells.height() * mCellSize);
+
+    // Not using QRectF::united, since it ignores rectangles without size
+    for (MapObject *object : mLargeObjects) {
+        const QRectF &bounds = mEntries.constFind(object).value().bounds;
+        if (empty) {
+            rect = bounds;
+            empty = false;
+        } else {
+            rect = QRectF(QPointF(qMin(rect.left(), bounds.left()),
+                                  qMin(rect.top(), bounds.top())),
+                          QPointF(qMax(rect.right(), bounds.right()),
+                                  qMax(rect.bottom(), bounds.bottom())));
+        }
+    }
+
+    return empty ? QRectF() : rect;
+}
+
+/**
+ * Assigns consecutive orders to all objects, placing \a objects right after
+ * \a previous, or at the start when it is null.
+ */
+void MapObjectIndex::renumber(const QList<MapObject*> &objects,
+                              MapObject *previous)
+{
+    QSet<MapObject*> moving;
+    for (MapObject *object : objects)
+        moving.insert(object);
+
+    QVector<QPair<qreal, MapObject*>> others;
+    others.reserve(mEntries.size());
+    for (auto it = mEntries.constBegin(), end = mEntries.constEnd(); it != end; ++it)
+        if (!moving.contains(it.key()))
+            others.append(qMakePair(it.value().order, it.key()));
+
+    std::sort(others.begin(), others.end());
+
+    mNextOrder = 0;
+
+    auto insertObjects = [&] {
+        for (MapObject *object : objects)
+            mEntries[object].order = mNextOrder++;
+    };
+
+    if (!previous)
+        insertObjects();
+
+    for (const auto &pair : others) {
+        mEntries[pair.second].order = mNextOrder++;
+        if (pair.second == previous)
+            insertObjects();
+    }
+}
+
+QRect MapObjectIndex::cellsFor(const QRectF &rect) const
+{
+    return QRect(QPoint(cellCoordinate(rect.left(), mCellSize),
+                        cellCoordinate(rect.top(), mCellSize)),
+                 QPoint(cellCoordinate(rect.right(), mCellSize),
+                        cellCoordinate(rect.bottom(), mCellSize)));
+}
+
+void MapObjectIndex::addToCells(MapObject *object, const QRect &cells)
+{
+    for (int y = cells.top(); y <= cells.bottom(); ++y)
+        for (int x = cells.left(); x <= cells.right(); ++x)
+            mCells[cellKey(x, y)].append(object);
+}
+
+void MapObjectIndex::removeFromCells(MapObject *object, const QRect &cells)
+{
+    for (int y = cells.top(); y <= cells.bottom(); ++y) {
+        for (int x = cells.left(); x <= cells.right(); ++x) {
+            const auto it = mCells.find(cellKey(x, y));
+            Q_ASSERT(it != mCells.end());
+
+            QVector<MapObject*> &objects = it.value();
+            const int index = objects.indexOf(object);
+            Q_ASSERT(index != -1);
+
+            // The order within a cell doesn't matter
+            objects[index] = objects.last();
+            objects.removeLast();
+
+            if (objects.isEmpty())
+                mCells.erase(it);
+        }
+    }
+}
+
+quint64 MapObjectIndex::cellKey(int x, int y)
+{
+    return (quint64(quint32(y)) << 32) | quint32(x);
+}
@@ -0,0 +1,132 @@
+/*
+ * mapobjectindex.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QHash>
+#include <QList>
+#include <QPointF>
+#include <QRect>
+#include <QRectF>
+#include <QVector>
+
+namespace Tiled {
+
+class MapObject;
+
+/**
+ * A spatial index for looking up map objects by their bounding rectangle.
+ *
+ * The objects are kept in buckets of a uniform grid. Objects covering a lot
+ * of grid cells are kept in a separate list instead, which is checked for
+ * every query.
+ *
+ * Query results are returned in the order in which the objects were
+ * inserted, unless this order was changed using reorder(). Updating the
+ * bounds of an object keeps its place in this order.
+ */
+class TILEDSHARED_EXPORT MapObjectIndex
+{
+public:
+    explicit MapObjectIndex(qreal cellSize = 256);
+
+    bool isEmpty() const { return mEntries.isEmpty(); }
+    int size() const { return mEntries.size(); }
+    bool contains(MapObject *object) const { return mEntries.contains(object); }
+
+    qreal cellSize() const { return mCellSize; }
+
+    /**
+     * Adds \a object with the given \a bounds to the index.
+     */
+    void insert(MapObject *object, const QRectF &bounds);
+
+    /**
+     * Changes the bounds of an object in the index.
+     */
+    void update(MapObject *object, const QRectF &bounds);
+
+    void remove(MapObject *object);
+    void clear();
+
+    /**
+     * Moves \a objects to between \a previous and \a next in the order of
+     * query results, keeping their relative order. Either \a previous or
+     * \a next may be null, to move the objects to the start or the end.
+     */
+    void reorder(const QList<MapObject*> &objects,
+                 MapObject *previous, MapObject *next);
+
+    /**
+     * Returns the objects whose bounds intersect \a rect. Rectangles that
+     * only touch are considered to intersect, so that objects without size
+     * can be found as well.
+     */
+    QList<MapObject*> intersecting(const QRectF &rect) const;
+
+    /**
+     * Returns the objects whose bounds contain \a point.
+     */
+    QList<MapObject*> at(const QPointF &point) const
+    { return intersecting(QRectF(point, QSizeF(0, 0))); }
+
+    /**
+     * Returns a rectangle covering the bounds of all objects. It is derived
+     * from the occupied grid cells, so it can be larger than needed by up to
+     * a cell on each side.
+     */
+    QRectF boundingRect() const;
+
+private:
+    enum { MaxCellsPerObject = 64 };
+
+    struct Entry
+    {
+        QRectF bounds;
+        QRect cells;        // null for objects in the list of large objects
+        qreal order;
+    };
+
+    void renumber(const QList<MapObject*> &objects, MapObject *previous);
+
+    QRect cellsFor(const QRectF &rect) const;
+    void addToCells(MapObject *object, const QRect &cells);
+    void removeFromCells(MapObject *object, const QRect &cells);
+
+    static quint64 cellKey(int x, int y);
+
+    qreal mCellSize;
+    qreal mNextOrder;
+    QHash<MapObject*, Entry> mEntries;
+    QHash<quint64, QVector<MapObject*>> mCells;
+    QVector<MapObject*> mLargeObjects;
+};
+
+} // namespace Tiled
@@ -0,0 +1,237 @@
+/*
+ * mappedxmlfile.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "mappedxmlfile.h"
+
+#include <QFile>
+#include <QStringRef>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace Tiled;
+
+namespace {
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool startsWith(const char *p, const char *end, const char *prefix)
+{
+    const size_t length = std::strlen(prefix);
+    return size_t(end - p) >= length && std::memcmp(p, prefix, length) == 0;
+}
+
+/**
+ * Returns the position right after the first occurrence of \a terminator
+ * starting at \a p, or \a end when it was not found.
+ */
+const char *skipPast(const char *p, const char *end, const char *terminator)
+{
+    const size_t length = std::strlen(terminator);
+    const char *found = std::search(p, end, terminator, terminator + length);
+    return found == end ? end : found + length;
+}
+
+/**
+ * Parses the attributes of a <data> start tag, starting right after the
+ * element name. Returns the position of the closing '>', or null when the
+ * tag is malformed.
+ */
+const char *parseDataTag(const char *p, const char *end, bool *base64)
+{
+    *base64 = false;
+
+    while (p < end) {
+        while (p < end && isSpace(*p))
+            ++p;
+        if (p == end)
+            return nullptr;
+        if (*p == '>')
+            return p;
+        if (*p == '/')
+            return (p + 1 < end && p[1] == '>') ? p + 1 : nullptr;
+
+        const char *nameBegin = p;
+        while (p < end && *p != '=' && !isSpace(*p) && *p != '>')
+            ++p;
+        const char *nameEnd = p;
+
+        while (p < end && isSpace(*p))
+            ++p;
+        if (p == end || *p != '=')
+            return nullptr;
+        ++p;
+        while (p < end && isSpace(*p))
+            ++p;
+        if (p == end || (*p != '"' && *p != '\''))
+            return nullptr;
+
+        const char quote = *p++;
+        const char *valueBegin = p;
+        p = static_cast<const char*>(std::memchr(p, quote, end - p));
+        if (!p)
+            return nullptr;
+
+        const QByteArray name = QByteArray::fromRawData(nameBegin, nameEnd - nameBegin);
+        const QByteArray value = QByteArray::fromRawData(valueBegin, p - valueBegin);
+        if (name == "encoding")
+            *base64 = value == "base64";
+
+        ++p;
+    }
+
+    return nullptr;
+}
+
+} // anonymous namespace
+
+MappedXmlFile::MappedXmlFile(QFile *file)
+    : mFile(file)
+    , mMapped(false)
+{
+    const qint64 size = file->size();
+    if (size <= 0 || size > std::numeric_limits<int>::max())
+        return;
+
+    const uchar *data = file->map(0, size);
+    if (!data)
+        return;
+
+    mMapped = true;
+    separatePayloads(reinterpret_cast<const char*>(data), int(size));
+
+    mBuffer.setData(mDocument);
+    mBuffer.open(QIODevice::ReadOnly);
+}
+
+QIODevice *MappedXmlFile::device()
+{
+    if (mMapped)
+        return &mBuffer;
+    return mFile;
+}
+
+QByteArray MappedXmlFile::payload(const QStringRef &text) const
+{
+    const QStringRef trimmed = text.trimmed();
+    if (trimmed.size() < 2 || trimmed.at(0) != QLatin1Char('#'))
+        return QByteArray();
+
+    bool ok;
+    const int index = trimmed.mid(1).toInt(&ok);
+    if (!ok || index < 0 || index >= mPayloads.size())
+        return QByteArray();
+
+    return mPayloads.at(index);
+}
+
+/**
+ * Looks for <data> elements with base64 encoded contents and replaces their
+ * contents with placeholders. Anything that isn't clearly such an element is
+ * left to the XML reader.
+ */
+void MappedXmlFile::separatePayloads(const char *data, int size)
+{
+    const char *end = data + size;
+    const char *copied = data;  // Everything before this is in mDocument
+
+    // Only documents in an ASCII-compatible encoding are rewritten
+    const bool asciiCompatible = !std::memchr(data, '\0', std::min(size, 4)) &&
+            !startsWith(data, end, "\xfe\xff") &&
+            !startsWith(data, end, "\xff\xfe");
+
+    const char *p = data;
+    while (asciiCompatible && p < end) {
+        p = static_cast<const char*>(std::memchr(p, '<', end - p));
+        if (!p)
+            break;
+
+        if (startsWith(p, end, "<!--")) {
+            p = skipPast(p + 4, end, "-->");
+            continue;
+        }
+        if (startsWith(p, end, "<![CDATA[")) {
+            p = skipPast(p + 9, end, "]]>");
+            continue;
+        }
+        if (startsWith(p, end, "<?")) {
+            p = skipPast(p + 2, end, "?>");
+            continue;
+        }
+        if (!startsWith(p, end, "<data") || p + 5 == end ||
+                !(isSpace(p[5]) || p[5] == '>' || p[5] == '/')) {
+            ++p;
+            continue;
+        }
+
+        bool base64;
+        const char *tagEnd = parseDataTag(p + 5, end, &base64);
+        if (!tagEnd)
+            break;
+
+        p = tagEnd + 1;
+        if (!base64 || tagEnd[-1] == '/')
+            continue;
+
+        const char *contentBegin = p;
+        const char *contentEnd = static_cast<const char*>(std::memchr(p, '<', end - p));
+        if (!contentEnd)
+            break;
+
+        p = contentEnd;
+
+        // Contents with entity references are left to the XML reader
+        if (!startsWith(contentEnd, end, "</data") ||
+                std::memchr(contentBegin, '&', contentEnd - contentBegin))
+            continue;
+
+        const int length = int(contentEnd - contentBegin);
+        const int lineBreaks = int(std::count(contentBegin, contentEnd, '\n'));
+
+        if (mDocument.isEmpty())
+            mDocument.reserve(size / 4);
+
+        mDocument.append(copied, int(contentBegin - copied));
+        mDocument.append('#');
+        mDocument.append(QByteArray::number(mPayloads.size()));
+        mDocument.append(QByteArray(lineBreaks, '\n'));
+
+        mPayloads.append(QByteArray::fromRawData(contentBegin, length));
+        copied = contentEnd;
+    }
+
+    if (mPayloads.isEmpty()) {
+        mDocument = QByteArray::fromRawData(data, size);
+        return;
+    }
+
+    mDocument.append(copied, int(end - copied));
+}
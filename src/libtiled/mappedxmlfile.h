@@ -0,0 +1,92 @@
+/*
+ * mappedxmlfile.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QVector>
+
+class QFile;
+class QStringRef;
+
+namespace Tiled {
+
+/**
+ * Provides the contents of an XML file through a memory mapping, with the
+ * base64 encoded contents of its <data> elements separated out.
+ *
+ * The XML reader only gets to see a short placeholder in place of each of
+ * these contents, which avoids converting large layer data and embedded
+ * images to UTF-16 and back. The original bytes can be looked up by the
+ * placeholder, and refer directly to the mapped file. The placeholders keep
+ * the line breaks of the contents they replace, so that line numbers
+ * reported by the XML reader remain correct.
+ *
+ * When the file can't be mapped, the file itself is used as device and no
+ * contents are separated.
+ */
+class TILEDSHARED_EXPORT MappedXmlFile
+{
+public:
+    /**
+     * Maps the given \a file, which needs to be open and needs to stay open
+     * for the lifetime of this object.
+     */
+    explicit MappedXmlFile(QFile *file);
+
+    bool isMapped() const { return mMapped; }
+
+    /**
+     * Returns the device from which the XML document should be read.
+     */
+    QIODevice *device();
+
+    /**
+     * Returns the base64 encoded contents replaced by the given placeholder
+     * \a text, or a null byte array when \a text is not a placeholder.
+     *
+     * The returned byte array refers to the mapped file, so it should not be
+     * used after this object has been destroyed.
+     */
+    QByteArray payload(const QStringRef &text) const;
+
+    int payloadCount() const { return mPayloads.size(); }
+
+private:
+    void separatePayloads(const char *data, int size);
+
+    QFile *mFile;
+    bool mMapped;
+    QByteArray mDocument;
+    QBuffer mBuffer;
+    QVector<QByteArray> mPayloads;
+};
+
+} // namespace Tiled
@@ -33,12 +33,16 @@
 #include "compression.h"
 #include "gidmapper.h"
 #include "grouplayer.h"
+#include "imagecache.h"
+#include "imagedecoder.h"
 #include "imagelayer.h"
 #include "objectgroup.h"
 #include "map.h"
 #include "mapobject.h"
+#include "mappedxmlfile.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tilesetcache.h"
 #include "tilesetmanager.h"
 #include "terrain.h"
 
@@ -64,7 +68,9 @@ class MapReaderPrivate
 public:
     MapReaderPrivate(MapReader *mapReader):
         p(mapReader),
-        mReadingExternalTileset(false)
+        mReadingExternalTileset(false),
+        mImageLoadingEnabled(true),
+        mMappedFile(nullptr)
     {}
 
     Map *readMap(QIODevice *device, const QString &path);
@@ -76,6 +82,12 @@ public:
 
 private:
     void readUnknownElement();
+    QByteArray base64Text(const QStringRef &text) const;
+    SharedTileset readCachedTileset(const QString &fileName);
+
+    void addPendingImage(Tileset *tileset, int tileId, ImageLayer *imageLayer,
+                         const ImageReference &reference);
+    bool loadPendingImages();
 
     Map *readMap();
 
@@ -127,6 +139,11 @@ private:
     QScopedPointer<Map> mMap;
     GidMapper mGidMapper;
     bool mReadingExternalTileset;
+    bool mImageLoadingEnabled;
+    QVector<MapReader::PendingImage> mPendingImages;
+
+    // Set while reading from a memory-mapped file
+    const MappedXmlFile *mMappedFile;
 
     QXmlStreamReader xml;
 };
@@ -138,6 +155,7 @@ Map *MapReaderPrivate::readMap(QIODevice *device, const QString &path)
 {
     mError.clear();
     mPath = path;
+    mPendingImages.clear();
     Map *map = nullptr;
 
     xml.setDevice(device);
@@ -156,6 +174,7 @@ SharedTileset MapReaderPrivate::readTileset(QIODevice *device, const QString &pa
 {
     mError.clear();
     mPath = path;
+    mPendingImages.clear();
     SharedTileset tileset;
     mReadingExternalTileset = true;
 
@@ -166,10 +185,34 @@ SharedTileset MapReaderPrivate::readTileset(QIODevice *device, const QString &pa
     else
         xml.raiseError(tr("Not a tileset file."));
 
+    if (tileset && mImageLoadingEnabled && !loadPendingImages())
+        tileset.reset();
+
     mReadingExternalTileset = false;
     return tileset;
 }
 
+/**
+ * Loads the tileset from the TilesetCache. When image loading is disabled,
+ * the tileset image is added to the pending images, which can then be
+ * decoded quickly since the cache already provided its pixels.
+ */
+SharedTileset MapReaderPrivate::readCachedTileset(const QString &fileName)
+{
+    mError.clear();
+    mPendingImages.clear();
+
+    SharedTileset tileset = TilesetCache::load(fileName, mImageLoadingEnabled);
+    if (!tileset || mImageLoadingEnabled)
+        return tileset;
+
+    // The images of tiles in collection tilesets are loaded once used
+    if (!tileset->isCollection())
+        addPendingImage(tileset.data(), -1, nullptr, tileset->imageReference());
+
+    return tileset;
+}
+
 QString MapReaderPrivate::errorString() const
 {
     if (!mError.isEmpty()) {
@@ -195,6 +238,21 @@ bool MapReaderPrivate::openFile(QFile *file)
     return true;
 }
 
+/**
+ * Returns the base64 encoded \a text of a <data> element. When reading from
+ * a memory-mapped file, this refers directly to the contents of the file.
+ */
+QByteArray MapReaderPrivate::base64Text(const QStringRef &text) const
+{
+    if (mMappedFile) {
+        const QByteArray payload = mMappedFile->payload(text);
+        if (!payload.isNull())
+            return payload;
+    }
+
+    return text.toLatin1();
+}
+
 void MapReaderPrivate::readUnknownElement()
 {
     qDebug().nospace() << "Unknown element (fixme): " << xml.name()
@@ -203,6 +261,65 @@ void MapReaderPrivate::readUnknownElement()
     xml.skipCurrentElement();
 }
 
+void MapReaderPrivate::addPendingImage(Tileset *tileset, int tileId,
+                                       ImageLayer *imageLayer,
+                                       const ImageReference &reference)
+{
+    MapReader::PendingImage pendingImage;
+    pendingImage.tileset = tileset;
+    pendingImage.tileId = tileId;
+    pendingImage.imageLayer = imageLayer;
+    pendingImage.reference = reference;
+    mPendingImages.append(pendingImage);
+}
+
+/**
+ * Decodes the pending images in parallel and applies them to the tilesets,
+ * tiles and image layers using them. Images that fail to load are left
+ * missing, except for embedded tile images, which fail the read operation.
+ */
+bool MapReaderPrivate::loadPendingImages()
+{
+    QVector<ImageReference> references;
+    references.reserve(mPendingImages.size());
+    for (const MapReader::PendingImage &pendingImage : mPendingImages)
+        references.append(pendingImage.reference);
+
+    const QVector<QImage> images = ImageDecoder::decodeAll(references);
+
+    for (int i = 0; i < mPendingImages.size(); ++i) {
+        const MapReader::PendingImage &pendingImage = mPendingImages.at(i);
+        const ImageReference &reference = pendingImage.reference;
+        const QImage &image = images.at(i);
+
+        if (Tileset *tileset = pendingImage.tileset) {
+            if (pendingImage.tileId == -1) {
+                tileset->loadFromImage(image, reference.source);
+                continue;
+            }
+
+            if (image.isNull() && reference.source.isEmpty()) {
+                mError = tr("Error reading embedded image for tile %1")
+                        .arg(pendingImage.tileId);
+                return false;
+            }
+
+            // Tile images loaded from files are shared through the cache
+            const QPixmap pixmap = reference.source.isEmpty()
+                    ? QPixmap::fromImage(image)
+                    : ImageCache::loadPixmap(reference.source);
+
+            Tile *tile = tileset->findTile(pendingImage.tileId);
+            tileset->setTileImage(tile, pixmap, reference.source);
+        } else if (ImageLayer *imageLayer = pendingImage.imageLayer) {
+            imageLayer->loadFromImage(image, reference.source);
+        }
+    }
+
+    mPendingImages.clear();
+    return true;
+}
+
 Map *MapReaderPrivate::readMap()
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("map"));
@@ -269,11 +386,10 @@ Map *MapReaderPrivate::readMap()
     if (xml.hasError()) {
         mMap.reset();
     } else {
-        // Try to load the tileset images
-        auto tilesets = mMap->tilesets();
-        for (SharedTileset &tileset : tilesets) {
-            if (!tileset->isCollection() && tileset->fileName().isEmpty())
-                tileset->loadImage();
+        // Load the images used by the tilesets and image layers
+        if (mImageLoadingEnabled && !loadPendingImages()) {
+            mMap.reset();
+            return nullptr;
         }
 
         // Fix up sizes of tile objects
@@ -417,14 +533,12 @@ void MapReaderPrivate::readTilesetTile(Tileset &tileset)
             tile->mergeProperties(readProperties());
         } else if (xml.name() == QLatin1String("image")) {
             ImageReference imageReference = readImage();
-            if (imageReference.hasImage()) {
-                QImage image = imageReference.create();
-                if (image.isNull()) {
-                    if (imageReference.source.isEmpty())
-                        xml.raiseError(tr("Error reading embedded image for tile %1").arg(id));
-                }
-                tileset.setTileImage(tile, QPixmap::fromImage(image),
-                                     imageReference.source);
+            if (!imageReference.source.isEmpty()) {
+                // Images of tiles are only loaded once they are used
+                tileset.setDeferredTileImage(tile, imageReference.source,
+                                             imageReference.size);
+            } else if (imageReference.hasImage()) {
+                addPendingImage(&tileset, id, nullptr, imageReference);
             }
         } else if (xml.name() == QLatin1String("objectgroup")) {
             tile->setObjectGroup(readObjectGroup());
@@ -480,7 +594,12 @@ void MapReaderPrivate::readTilesetImage(Tileset &tileset)
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("image"));
 
-    tileset.setImageReference(readImage());
+    const ImageReference reference = readImage();
+    tileset.setImageReference(reference);
+
+    // Tilesets without an image source are image collection tilesets
+    if (!reference.source.isEmpty())
+        addPendingImage(&tileset, -1, nullptr, reference);
 }
 
 ImageReference MapReaderPrivate::readImage()
@@ -508,10 +627,14 @@ ImageReference MapReaderPrivate::readImage()
             if (xml.name() == QLatin1String("data")) {
                 const QXmlStreamAttributes atts = xml.attributes();
                 QStringRef encoding = atts.value(QLatin1String("encoding"));
+                image.compression = atts.value(QLatin1String("compression")).toLatin1();
 
-                image.data = xml.readElementText().toLatin1();
+                // Decompressing and decoding is left to the ImageDecoder
+                const QString text = xml.readElementText();
                 if (encoding == QLatin1String("base64"))
-                    image.data = QByteArray::fromBase64(image.data);
+                    image.data = QByteArray::fromBase64(base64Text(QStringRef(&text)));
+                else
+                    image.data = text.toLatin1();
             } else {
                 readUnknownElement();
             }
@@ -673,7 +796,7 @@ void MapReaderPrivate::readTileLayerData(TileLayer &tileLayer)
         } else if (xml.isCharacters() && !xml.isWhitespace()) {
             if (encoding == QLatin1String("base64")) {
                 decodeBinaryLayerData(tileLayer,
-                                      xml.text().toLatin1(),
+                                      base64Text(xml.text()),
                                       layerDataFormat);
             } else if (encoding == QLatin1String("csv")) {
                 decodeCSVLayerData(tileLayer, xml.text());
@@ -829,7 +952,11 @@ void MapReaderPrivate::readImageLayerImage(ImageLayer &imageLayer)
 
     source = p->resolveReference(source, mPath);
 
-    imageLayer.loadFromImage(source);
+    imageLayer.setSource(source);
+
+    ImageReference reference;
+    reference.source = source;
+    addPendingImage(nullptr, -1, &imageLayer, reference);
 
     xml.skipCurrentElement();
 }
@@ -1104,28 +1231,46 @@ Map *MapReader::readMap(const QString &fileName)
     if (!d->openFile(&file))
         return nullptr;
 
-    return readMap(&file, QFileInfo(fileName).absolutePath());
+    MappedXmlFile mappedFile(&file);
+
+    d->mMappedFile = &mappedFile;
+    Map *map = readMap(mappedFile.device(), QFileInfo(fileName).absolutePath());
+    d->mMappedFile = nullptr;
+
+    return map;
 }
 
 SharedTileset MapReader::readTileset(QIODevice *device, const QString &path)
 {
-    SharedTileset tileset = d->readTileset(device, path);
-    if (tileset && !tileset->isCollection())
-        tileset->loadImage();
-
-    return tileset;
+    return d->readTileset(device, path);
 }
 
 SharedTileset MapReader::readTileset(const QString &fileName)
 {
+    if (TilesetCache::isEnabled())
+        if (SharedTileset tileset = d->readCachedTileset(fileName))
+            return tileset;
+
     QFile file(fileName);
     if (!d->openFile(&file))
         return SharedTileset();
 
-    SharedTileset tileset = readTileset(&file, QFileInfo(fileName).absolutePath());
-    if (tileset)
+    MappedXmlFile mappedFile(&file);
+
+    d->mMappedFile = &mappedFile;
+    SharedTileset tileset = readTileset(mappedFile.device(),
+                                        QFileInfo(fileName).absolutePath());
+    d->mMappedFile = nullptr;
+    if (tileset) {
         tileset->setFileName(fileName);
 
+        // Storing needs the pixels of the images, so it is only done when they
+        // were already decoded by loadPendingImages(). Otherwise it would
+        // decode them here, defeating the point of deferring them.
+        if (TilesetCache::isEnabled() && d->mImageLoadingEnabled)
+            TilesetCache::store(*tileset, fileName);
+    }
+
     return tileset;
 }
 
@@ -1134,6 +1279,21 @@ QString MapReader::errorString() const
     return d->errorString();
 }
 
+void MapReader::setImageLoadingEnabled(bool enabled)
+{
+    d->mImageLoadingEnabled = enabled;
+}
+
+bool MapReader::isImageLoadingEnabled() const
+{
+    return d->mImageLoadingEnabled;
+}
+
+const QVector<MapReader::PendingImage> &MapReader::pendingImages() const
+{
+    return d->mPendingImages;
+}
+
 QString MapReader::resolveReference(const QString &reference,
                                     const QString &mapPath)
 {
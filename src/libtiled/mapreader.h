@@ -37,6 +37,7 @@ class QFile;
 
 namespace Tiled {
 
+class ImageLayer;
 class Map;
 
 namespace Internal {
@@ -94,6 +95,36 @@ public:
      */
     QString errorString() const;
 
+    /**
+     * An image that was not loaded while reading, because image loading was
+     * disabled. It is used by either a tileset, a tile or an image layer.
+     */
+    struct PendingImage
+    {
+        Tileset *tileset;           // the tileset using the image, if any
+        int tileId;                 // the tile using the image, or -1
+        ImageLayer *imageLayer;     // the image layer using the image, if any
+        ImageReference reference;
+    };
+
+    /**
+     * Sets whether the images used by tilesets, tiles and image layers are
+     * loaded while reading. Enabled by default, in which case the images are
+     * decoded in parallel once the file has been read.
+     *
+     * When disabled, only the references to the images are read, and the
+     * images are listed by pendingImages() instead. This allows reading on a
+     * worker thread, since no pixmaps are created, and loading the images
+     * afterwards. Tilesets read this way are not stored in the TilesetCache.
+     */
+    void setImageLoadingEnabled(bool enabled);
+    bool isImageLoadingEnabled() const;
+
+    /**
+     * Returns the images that were not loaded by the last read operation.
+     */
+    const QVector<PendingImage> &pendingImages() const;
+
 protected:
     /**
      * Called for each \a reference to an external file. Should return the path
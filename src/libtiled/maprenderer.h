@@ -201,6 +201,14 @@ public:
     qreal objectLineWidth() const { return mObjectLineWidth; }
     void setObjectLineWidth(qreal lineWidth) { mObjectLineWidth = lineWidth; }
 
+    /**
+     * Returns how far objects may be drawn outside of their shape, for their
+     * outline and for the marker of objects without a size. The part that
+     * depends on the line width is divided by \a painterScale.
+     */
+    qreal objectMargin(qreal painterScale = 1) const
+    { return 11 + mObjectLineWidth * 5 / painterScale; }
+
     void setFlag(RenderFlag flag, bool enabled = true);
     bool testFlag(RenderFlag flag) const
     { return mFlags.testFlag(flag); }
@@ -38,7 +38,17 @@ struct TextData;
 class TILEDSHARED_EXPORT MapToVariantConverter
 {
 public:
-    MapToVariantConverter() {}
+    MapToVariantConverter()
+        : mTileDataAsVector(false)
+    {}
+
+    /**
+     * Sets whether the tile data of layers using the XML or CSV layer data
+     * format is stored as a QVector<unsigned> of global tile IDs, rather
+     * than as a QVariantList. This avoids creating a QVariant for each tile,
+     * but is only understood by writers that expect it.
+     */
+    void setTileDataAsVector(bool enabled) { mTileDataAsVector = enabled; }
 
     /**
      * Converts the given \s map to a QVariant. The \a mapDir is used to
@@ -71,6 +81,7 @@ private:
 
     QDir mMapDir;
     GidMapper mGidMapper;
+    bool mTileDataAsVector;
 };
 
 } // namespace Tiled
@@ -43,7 +43,6 @@
 #include "tileset.h"
 #include "terrain.h"
 
-#include <QBuffer>
 #include <QCoreApplication>
 #include <QDir>
 #include <QXmlStreamWriter>
@@ -78,6 +77,7 @@ public:
 
     QString mError;
     Map::LayerDataFormat mLayerDataFormat;
+    EmbeddedImageFormat mEmbeddedImageFormat;
     bool mDtdEnabled;
 
 private:
@@ -91,6 +91,7 @@ private:
     void writeObject(QXmlStreamWriter &w, const MapObject &mapObject);
     void writeObjectText(QXmlStreamWriter &w, const TextData &textData);
     void writeImageLayer(QXmlStreamWriter &w, const ImageLayer &imageLayer);
+    void writeEmbeddedImage(QXmlStreamWriter &w, const QImage &image);
     void writeGroupLayer(QXmlStreamWriter &w, const GroupLayer &groupLayer);
     void writeProperties(QXmlStreamWriter &w,
                          const Properties &properties);
@@ -106,6 +107,7 @@ private:
 
 MapWriterPrivate::MapWriterPrivate()
     : mLayerDataFormat(Map::Base64Zlib)
+    , mEmbeddedImageFormat(EmbedPng)
     , mDtdEnabled(false)
     , mUseAbsolutePaths(false)
 {
@@ -386,17 +388,7 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
                 }
 
                 if (tile->imageSource().isEmpty()) {
-                    w.writeAttribute(QLatin1String("format"),
-                                     QLatin1String("png"));
-
-                    w.writeStartElement(QLatin1String("data"));
-                    w.writeAttribute(QLatin1String("encoding"),
-                                     QLatin1String("base64"));
-
-                    QBuffer buffer;
-                    tile->image().save(&buffer, "png");
-                    w.writeCharacters(QString::fromLatin1(buffer.data().toBase64()));
-                    w.writeEndElement(); // </data>
+                    writeEmbeddedImage(w, tile->image().toImage());
                 } else {
                     QString source = tile->imageSource();
                     if (!mUseAbsolutePaths)
@@ -720,6 +712,29 @@ void MapWriterPrivate::writeImageLayer(QXmlStreamWriter &w,
     w.writeEndElement();
 }
 
+/**
+ * Writes the format attribute and the data element of an embedded image.
+ */
+void MapWriterPrivate::writeEmbeddedImage(QXmlStreamWriter &w,
+                                          const QImage &image)
+{
+    const ImageReference reference = ImageReference::embed(image,
+                                                           mEmbeddedImageFormat);
+
+    w.writeAttribute(QLatin1String("format"),
+                     QString::fromLatin1(reference.format));
+
+    w.writeStartElement(QLatin1String("data"));
+    w.writeAttribute(QLatin1String("encoding"), QLatin1String("base64"));
+    if (!reference.compression.isEmpty()) {
+        w.writeAttribute(QLatin1String("compression"),
+                         QString::fromLatin1(reference.compression));
+    }
+
+    w.writeCharacters(QString::fromLatin1(reference.data.toBase64()));
+    w.writeEndElement(); // </data>
+}
+
 void MapWriterPrivate::writeGroupLayer(QXmlStreamWriter &w,
                                        const GroupLayer &groupLayer)
 {
@@ -846,3 +861,13 @@ bool MapWriter::isDtdEnabled() const
 {
     return d->mDtdEnabled;
 }
+
+void MapWriter::setEmbeddedImageFormat(EmbeddedImageFormat format)
+{
+    d->mEmbeddedImageFormat = format;
+}
+
+EmbeddedImageFormat MapWriter::embeddedImageFormat() const
+{
+    return d->mEmbeddedImageFormat;
+}
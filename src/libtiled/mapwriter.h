@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include "imagereference.h"
 #include "map.h"
 #include "tiled_global.h"
 
@@ -103,6 +104,13 @@ public:
     void setDtdEnabled(bool enabled);
     bool isDtdEnabled() const;
 
+    /**
+     * Sets the format in which embedded tile images are stored. Images are
+     * stored as PNG by default. The format is detected when reading.
+     */
+    void setEmbeddedImageFormat(EmbeddedImageFormat format);
+    EmbeddedImageFormat embeddedImageFormat() const;
+
 private:
     Q_DISABLE_COPY(MapWriter)
 
@@ -30,11 +30,15 @@
 
 #include "objectgroup.h"
 
+#include "isometricrenderer.h"
 #include "layer.h"
 #include "map.h"
 #include "mapobject.h"
+#include "mapobjectindex.h"
 #include "tile.h"
 
+#include <QTransform>
+
 #include <cmath>
 
 using namespace Tiled;
@@ -42,18 +46,23 @@ using namespace Tiled;
 ObjectGroup::ObjectGroup()
     : Layer(ObjectGroupType, QString(), 0, 0)
     , mDrawOrder(TopDownOrder)
+    , mObjectIndex(nullptr)
+    , mIndexOrientation(-1)
 {
 }
 
 ObjectGroup::ObjectGroup(const QString &name, int x, int y)
     : Layer(ObjectGroupType, name, x, y)
     , mDrawOrder(TopDownOrder)
+    , mObjectIndex(nullptr)
+    , mIndexOrientation(-1)
 {
 }
 
 ObjectGroup::~ObjectGroup()
 {
     qDeleteAll(mObjects);
+    delete mObjectIndex;
 }
 
 void ObjectGroup::addObject(MapObject *object)
@@ -62,6 +71,10 @@ void ObjectGroup::addObject(MapObject *object)
     object->setObjectGroup(this);
     if (mMap && object->id() == 0)
         object->setId(mMap->takeNextObjectId());
+
+    // Appended objects come last in the index as well
+    if (mObjectIndex)
+        mObjectIndex->insert(object, indexBounds(object));
 }
 
 void ObjectGroup::insertObject(int index, MapObject *object)
@@ -70,6 +83,13 @@ void ObjectGroup::insertObject(int index, MapObject *object)
     object->setObjectGroup(this);
     if (mMap && object->id() == 0)
         object->setId(mMap->takeNextObjectId());
+
+    if (mObjectIndex) {
+        mObjectIndex->insert(object, indexBounds(object));
+        mObjectIndex->reorder(QList<MapObject*>() << object,
+                              mObjects.value(index - 1),
+                              mObjects.value(index + 1));
+    }
 }
 
 int ObjectGroup::removeObject(MapObject *object)
@@ -79,6 +99,10 @@ int ObjectGroup::removeObject(MapObject *object)
 
     mObjects.removeAt(index);
     object->setObjectGroup(nullptr);
+
+    if (mObjectIndex)
+        mObjectIndex->remove(object);
+
     return index;
 }
 
@@ -86,6 +110,9 @@ void ObjectGroup::removeObjectAt(int index)
 {
     MapObject *object = mObjects.takeAt(index);
     object->setObjectGroup(nullptr);
+
+    if (mObjectIndex)
+        mObjectIndex->remove(object);
 }
 
 void ObjectGroup::moveObjects(int from, int to, int count)
@@ -108,6 +135,12 @@ void ObjectGroup::moveObjects(int from, int to, int count)
 
     for (int i = 0; i < count; ++i)
         mObjects.insert(to + i, movingObjects.at(i));
+
+    // The index returns objects in the order of this group
+    if (mObjectIndex)
+        mObjectIndex->reorder(movingObjects,
+                              mObjects.value(to - 1),
+                              mObjects.value(to + count));
 }
 
 QRectF ObjectGroup::objectsBoundingRect() const
@@ -118,6 +151,32 @@ QRectF ObjectGroup::objectsBoundingRect() const
     return boundingRect;
 }
 
+QList<MapObject*> ObjectGroup::objectsInRect(const QRectF &rect) const
+{
+    return objectIndex().intersecting(rect);
+}
+
+QList<MapObject*> ObjectGroup::objectsAt(const QPointF &pos) const
+{
+    return objectIndex().at(pos);
+}
+
+QRectF ObjectGroup::indexedBounds() const
+{
+    return objectIndex().boundingRect();
+}
+
+void ObjectGroup::buildObjectIndex() const
+{
+    objectIndex();
+}
+
+void ObjectGroup::invalidateObjectIndex()
+{
+    delete mObjectIndex;
+    mObjectIndex = nullptr;
+}
+
 bool ObjectGroup::isEmpty() const
 {
     return mObjects.isEmpty();
@@ -241,6 +300,116 @@ ObjectGroup *ObjectGroup::initializeClone(ObjectGroup *clone) const
     return clone;
 }
 
+/**
+ * Called by MapObject when its position, size or shape has changed.
+ */
+void ObjectGroup::objectGeometryChanged(MapObject *object)
+{
+    if (mObjectIndex)
+        mObjectIndex->update(object, indexBounds(object));
+}
+
+/**
+ * Returns the spatial index, creating it when necessary.
+ */
+const MapObjectIndex &ObjectGroup::objectIndex() const
+{
+    // The bounds depend on the orientation and tile size of the map
+    const int orientation = mMap ? mMap->orientation() : -1;
+    const QSize tileSize = mMap ? QSize(mMap->tileWidth(), mMap->tileHeight()) : QSize();
+
+    if (mObjectIndex && (orientation != mIndexOrientation ||
+                         tileSize != mIndexTileSize)) {
+        delete mObjectIndex;
+        mObjectIndex = nullptr;
+    }
+
+    if (!mObjectIndex) {
+        mObjectIndex = new MapObjectIndex;
+        mIndexOrientation = orientation;
+        mIndexTileSize = tileSize;
+
+        for (MapObject *object : mObjects)
+            mObjectIndex->insert(object, indexBounds(object));
+    }
+
+    return *mObjectIndex;
+}
+
+/**
+ * Returns a rectangle in pixel coordinates that covers both the geometry of
+ * the given \a object and the area in which it is drawn.
+ */
+QRectF ObjectGroup::indexBounds(const MapObject *object) const
+{
+    // On isometric maps, objects are projected and tile objects are drawn
+    // upright, so the bounds are determined in screen orientation.
+    const bool isometric = mMap && mMap->orientation() == Map::Isometric &&
+            mMap->tileWidth() > 0 && mMap->tileHeight() > 0;
+
+    // The projection is applied relative to the object position, so the
+    // origin of the renderer is left out.
+    const IsometricRenderer renderer(mMap);
+    const QPointF origin = isometric ? renderer.pixelToScreenCoords(QPointF())
+                                     : QPointF();
+
+    auto toScreen = [&] (const QPointF &p) {
+        return renderer.pixelToScreenCoords(p) - origin;
+    };
+    auto toPixel = [&] (const QPointF &p) {
+        return renderer.screenToPixelCoords(p + origin);
+    };
+
+    // The area relative to the object position
+    QPolygonF area;
+
+    if (const Tile *tile = object->cell().tile()) {
+        QSizeF size = object->size();
+        if (size.isEmpty())
+            size = tile->size();
+
+        QPointF offset = tile->offset();
+        if (!tile->size().isEmpty()) {
+            offset.rx() *= size.width() / tile->width();
+            offset.ry() *= size.height() / tile->height();
+        }
+
+        QRectF rect(offset.x(), offset.y() - size.height(),
+                    size.width(), size.height());
+
+        if (object->alignment() == Bottom)
+            rect.translate(-size.width() / 2, 0);
+
+        area = QPolygonF(rect);
+    } else {
+        const QRectF rect = object->isPolyShape() ? object->polygon().boundingRect()
+                                                  : QRectF(QPointF(), object->size());
+        area = QPolygonF(rect);
+
+        if (isometric)
+            for (QPointF &point : area)
+                point = toScreen(point);
+    }
+
+    if (object->rotation() != 0)
+        area = QTransform().rotate(object->rotation()).map(area);
+
+    if (isometric)
+        for (QPointF &point : area)
+            point = toPixel(point);
+
+    const QRectF drawnBounds = area.boundingRect().translated(object->position());
+
+    // Also include the unrotated bounds, as used by the AutoMapper
+    const QRectF bounds = object->boundsUseTile().normalized();
+
+    // Not using QRectF::united, since it ignores rectangles without size
+    return QRectF(QPointF(qMin(drawnBounds.left(), bounds.left()),
+                          qMin(drawnBounds.top(), bounds.top())),
+                  QPointF(qMax(drawnBounds.right(), bounds.right()),
+                          qMax(drawnBounds.bottom(), bounds.bottom())));
+}
+
 
 QString Tiled::drawOrderToString(ObjectGroup::DrawOrder drawOrder)
 {
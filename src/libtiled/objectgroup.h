@@ -37,10 +37,12 @@
 #include <QColor>
 #include <QList>
 #include <QMetaType>
+#include <QSize>
 
 namespace Tiled {
 
 class MapObject;
+class MapObjectIndex;
 
 /**
  * A group of objects on a map.
@@ -133,6 +135,49 @@ public:
      */
     QRectF objectsBoundingRect() const;
 
+    /**
+     * Returns the objects that may overlap the given \a rect, in the order
+     * in which they appear in this group. The rectangle is in pixel
+     * coordinates, not including the offset of the layer.
+     *
+     * The objects are looked up in a spatial index, which is created on
+     * first use. It is based on a bounding rectangle that covers both the
+     * geometry of each object and the area where it is drawn, not including
+     * any outline. Callers that need an exact result should check the
+     * returned objects themselves.
+     */
+    QList<MapObject*> objectsInRect(const QRectF &rect) const;
+
+    /**
+     * Returns the objects that may overlap the given \a pos.
+     *
+     * \sa objectsInRect()
+     */
+    QList<MapObject*> objectsAt(const QPointF &pos) const;
+
+    /**
+     * Returns a rectangle covering the area in which the objects may be
+     * drawn, not including any outline. It is derived from the spatial index
+     * and can be larger than needed.
+     *
+     * \sa objectsInRect()
+     */
+    QRectF indexedBounds() const;
+
+    /**
+     * Creates the spatial index right away, rather than on first use. This
+     * is needed before the objects are looked up from several threads at
+     * once, since creating the index is not thread-safe.
+     */
+    void buildObjectIndex() const;
+
+    /**
+     * Makes sure the spatial index is updated on its next use. Should be
+     * called when something other than the objects themselves changed the
+     * area in which they are drawn, like the tile offset of a tileset.
+     */
+    void invalidateObjectIndex();
+
     /**
      * Returns whether this object group contains any objects.
      */
@@ -191,9 +236,21 @@ protected:
     ObjectGroup *initializeClone(ObjectGroup *clone) const;
 
 private:
+    friend class MapObject;
+
+    void objectGeometryChanged(MapObject *object);
+
+    const MapObjectIndex &objectIndex() const;
+    QRectF indexBounds(const MapObject *object) const;
+
     QList<MapObject*> mObjects;
     QColor mColor;
     DrawOrder mDrawOrder;
+
+    // The spatial index, along with the map properties it depends on
+    mutable MapObjectIndex *mObjectIndex;
+    mutable int mIndexOrientation;
+    mutable QSize mIndexTileSize;
 };
 
 
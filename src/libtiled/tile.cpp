@@ -28,15 +28,22 @@
 
 #include "tile.h"
 
+#include "imagecache.h"
 #include "objectgroup.h"
+#include "tileimageloader.h"
 #include "tileset.h"
 
+#include <QCoreApplication>
+#include <QThread>
+
 using namespace Tiled;
 
 Tile::Tile(int id, Tileset *tileset):
     Object(TileType),
     mId(id),
     mTileset(tileset),
+    mImageDeferred(false),
+    mImageLastUsed(0),
     mTerrain(-1),
     mProbability(1.f),
     mObjectGroup(nullptr),
@@ -49,6 +56,9 @@ Tile::Tile(const QPixmap &image, int id, Tileset *tileset):
     mId(id),
     mTileset(tileset),
     mImage(image),
+    mImageSize(image.size()),
+    mImageDeferred(false),
+    mImageLastUsed(0),
     mTerrain(-1),
     mProbability(1.f),
     mObjectGroup(nullptr),
@@ -58,9 +68,84 @@ Tile::Tile(const QPixmap &image, int id, Tileset *tileset):
 
 Tile::~Tile()
 {
+    if (mImageDeferred && !mImage.isNull())
+        TileImageLoader::imageReleased(this);
+
     delete mObjectGroup;
 }
 
+/**
+ * Sets the image of this tile.
+ */
+void Tile::setImage(const QPixmap &image)
+{
+    if (mImageDeferred && !mImage.isNull())
+        TileImageLoader::imageReleased(this);
+
+    mImage = image;
+    mImageSize = image.size();
+    mImageDeferred = false;
+}
+
+/**
+ * Sets this tile to load its image from \a imageSource when it is first
+ * needed. The \a size of the image is used until then.
+ *
+ * \sa Tileset::setDeferredTileImage()
+ */
+void Tile::setDeferredImage(const QString &imageSource, const QSize &size)
+{
+    setImage(QPixmap());
+
+    mImageSource = imageSource;
+    mImageSize = size;
+    mImageDeferred = true;
+}
+
+/**
+ * Releases the image of this tile when it is a deferred image, after which
+ * it will be loaded again on its next use.
+ */
+void Tile::releaseDeferredImage()
+{
+    if (!mImageDeferred || mImage.isNull())
+        return;
+
+    TileImageLoader::imageReleased(this);
+    mImage = QPixmap();
+
+    // The cache would otherwise keep the pixmap until its own limit is hit
+    ImageCache::release(mImageSource);
+}
+
+void Tile::loadDeferredImage() const
+{
+    // The images are tracked by the TileImageLoader, which is not thread-safe
+    Q_ASSERT(!QCoreApplication::instance() ||
+             QCoreApplication::instance()->thread() == QThread::currentThread());
+
+    mImageLastUsed = TileImageLoader::nextUsage();
+
+    if (!mImage.isNull())
+        return;
+
+    mImage = ImageCache::loadPixmap(mImageSource);
+
+    if (mImage.isNull()) {
+        // Don't keep trying, the tile is now known to be missing its image
+        mImageDeferred = false;
+        return;
+    }
+
+    TileImageLoader::imageLoaded(this);
+
+    // The size we were told may be out of date
+    if (mImage.size() != mImageSize) {
+        mImageSize = mImage.size();
+        mTileset->updateTileSize();
+    }
+}
+
 /**
  * Returns the tileset that this tile is part of as a shared pointer.
  */
@@ -199,9 +284,14 @@ bool Tile::advanceAnimation(int ms)
  */
 Tile *Tile::clone(Tileset *tileset) const
 {
-    Tile *c = new Tile(mImage, mId, tileset);
+    Tile *c = new Tile(mId, tileset);
     c->setProperties(properties());
 
+    if (mImageDeferred)
+        c->setDeferredImage(mImageSource, mImageSize);
+    else
+        c->setImage(mImage);
+
     c->mImageSource = mImageSource;
     c->mTerrain = mTerrain;
     c->mProbability = mProbability;
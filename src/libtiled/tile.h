@@ -104,6 +104,11 @@ public:
     const QPixmap &image() const;
     void setImage(const QPixmap &image);
 
+    void setDeferredImage(const QString &imageSource, const QSize &size);
+    bool isImageDeferred() const;
+    bool hasDeferredImage() const;
+    void releaseDeferredImage();
+
     const Tile *currentFrameTile() const;
 
     const QString &imageSource() const;
@@ -146,8 +151,13 @@ public:
 
 private:
     int mId;
+    void loadDeferredImage() const;
+
     Tileset *mTileset;
-    QPixmap mImage;
+    mutable QPixmap mImage;
+    mutable QSize mImageSize;
+    mutable bool mImageDeferred;
+    mutable quint64 mImageLastUsed;
     QString mImageSource;
     QString mType;
     unsigned mTerrain;
@@ -159,6 +169,7 @@ private:
     int mUnusedTime;
 
     friend class Tileset; // To allow changing the tile id
+    friend class TileImageLoader;
 };
 
 /**
@@ -178,19 +189,32 @@ inline Tileset *Tile::tileset() const
 }
 
 /**
- * Returns the image of this tile.
+ * Returns the image of this tile. A deferred image is loaded when it is
+ * first requested, which may only happen on the GUI thread.
  */
 inline const QPixmap &Tile::image() const
 {
+    if (mImageDeferred)
+        loadDeferredImage();
     return mImage;
 }
 
 /**
- * Sets the image of this tile.
+ * Returns whether the image of this tile is loaded from its image source on
+ * first use.
+ */
+inline bool Tile::isImageDeferred() const
+{
+    return mImageDeferred;
+}
+
+/**
+ * Returns whether this tile has a deferred image that is currently not in
+ * memory.
  */
-inline void Tile::setImage(const QPixmap &image)
+inline bool Tile::hasDeferredImage() const
 {
-    mImage = image;
+    return mImageDeferred && mImage.isNull();
 }
 
 /**
@@ -213,7 +237,7 @@ inline void Tile::setImageSource(const QString &imageSource)
  */
 inline int Tile::width() const
 {
-    return mImage.width();
+    return mImageSize.width();
 }
 
 /**
@@ -221,7 +245,7 @@ inline int Tile::width() const
  */
 inline int Tile::height() const
 {
-    return mImage.height();
+    return mImageSize.height();
 }
 
 /**
@@ -229,7 +253,7 @@ inline int Tile::height() const
  */
 inline QSize Tile::size() const
 {
-    return mImage.size();
+    return mImageSize;
 }
 
 /**
@@ -316,11 +340,12 @@ inline int Tile::currentFrameIndex() const
 }
 
 /**
- * Returns whether the image referenced by this tile was loaded.
+ * Returns whether the image referenced by this tile was loaded. Deferred
+ * images count as loaded until loading them has failed.
  */
 inline bool Tile::imageLoaded() const
 {
-    return !mImage.isNull();
+    return mImageDeferred || !mImage.isNull();
 }
 
 } // namespace Tiled
@@ -0,0 +1,196 @@
+/*
+ * tileimageloader.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tileimageloader.h"
+
+#include "imagecache.h"
+#include "tile.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+namespace {
+
+struct TileImageLoaderData
+{
+    TileImageLoaderData()
+        : maximumCost(128 * 1024 * 1024)
+        , totalCost(0)
+        , usageCounter(0)
+        , releaseScheduled(false)
+    {}
+
+    // Only accessed from the GUI thread
+    QSet<const Tile*> loadedTiles;
+    qint64 maximumCost;
+    qint64 totalCost;
+    quint64 usageCounter;
+    bool releaseScheduled;
+
+    // Protects the files being prefetched
+    QMutex mutex;
+    QSet<QString> prefetching;
+};
+
+Q_GLOBAL_STATIC(TileImageLoaderData, loaderData)
+
+qint64 imageCost(const QPixmap &pixmap)
+{
+    return qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+class PrefetchJob : public QRunnable
+{
+public:
+    explicit PrefetchJob(const QString &fileName)
+        : mFileName(fileName)
+    {}
+
+    void run() override
+    {
+        // The decoded image is kept by the ImageCache
+        ImageCache::loadImage(mFileName);
+
+        if (TileImageLoaderData *d = loaderData()) {
+            QMutexLocker locker(&d->mutex);
+            d->prefetching.remove(mFileName);
+        }
+    }
+
+private:
+    const QString mFileName;
+};
+
+} // anonymous namespace
+
+
+void TileImageLoader::prefetch(const QList<Tile*> &tiles)
+{
+    TileImageLoaderData *d = loaderData();
+    QMutexLocker locker(&d->mutex);
+
+    for (const Tile *tile : tiles) {
+        if (!tile->hasDeferredImage())
+            continue;
+
+        const QString &fileName = tile->imageSource();
+        if (d->prefetching.contains(fileName))
+            continue;
+
+        d->prefetching.insert(fileName);
+        QThreadPool::globalInstance()->start(new PrefetchJob(fileName));
+    }
+}
+
+void TileImageLoader::setMaximumCost(qint64 bytes)
+{
+    loaderData()->maximumCost = bytes;
+    releaseUnusedImages();
+}
+
+qint64 TileImageLoader::maximumCost()
+{
+    return loaderData()->maximumCost;
+}
+
+qint64 TileImageLoader::totalCost()
+{
+    return loaderData()->totalCost;
+}
+
+void TileImageLoader::releaseUnusedImages()
+{
+    TileImageLoaderData *d = loaderData();
+    d->releaseScheduled = false;
+
+    if (d->totalCost <= d->maximumCost)
+        return;
+
+    QVector<const Tile*> tiles;
+    tiles.reserve(d->loadedTiles.size());
+    for (const Tile *tile : d->loadedTiles)
+        tiles.append(tile);
+
+    std::sort(tiles.begin(), tiles.end(), [] (const Tile *a, const Tile *b) {
+        return a->mImageLastUsed < b->mImageLastUsed;
+    });
+
+    // Release a bit more than necessary, to avoid having to do this again
+    // for each newly loaded image
+    const qint64 targetCost = d->maximumCost * 3 / 4;
+
+    for (const Tile *tile : tiles) {
+        if (d->totalCost <= targetCost)
+            break;
+
+        const_cast<Tile*>(tile)->releaseDeferredImage();
+    }
+}
+
+void TileImageLoader::imageLoaded(const Tile *tile)
+{
+    TileImageLoaderData *d = loaderData();
+
+    d->loadedTiles.insert(tile);
+    d->totalCost += imageCost(tile->mImage);
+
+    if (d->totalCost <= d->maximumCost || d->releaseScheduled)
+        return;
+
+    // Releasing images is delayed until control returns to the event loop,
+    // since images that were just returned may still be in use
+    if (QCoreApplication::instance()) {
+        d->releaseScheduled = true;
+        QTimer::singleShot(0, [] { TileImageLoader::releaseUnusedImages(); });
+    }
+}
+
+void TileImageLoader::imageReleased(const Tile *tile)
+{
+    // May be called while the application shuts down
+    TileImageLoaderData *d = loaderData();
+    if (!d)
+        return;
+
+    if (d->loadedTiles.remove(tile))
+        d->totalCost -= imageCost(tile->mImage);
+}
+
+quint64 TileImageLoader::nextUsage()
+{
+    return ++loaderData()->usageCounter;
+}
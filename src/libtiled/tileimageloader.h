@@ -0,0 +1,93 @@
+/*
+ * tileimageloader.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QList>
+
+namespace Tiled {
+
+class Tile;
+
+/**
+ * Keeps track of the deferred tile images that are in memory.
+ *
+ * Tiles in image collection tilesets only refer to their image file until
+ * the image is first needed. The images loaded this way are released again
+ * when they exceed the maximum cost, starting with the least recently used
+ * ones. Released images are loaded again on their next use. They are also
+ * released from the ImageCache unless still used elsewhere, so that the
+ * maximum cost limits the memory taken by these images.
+ *
+ * Views can prefetch the images of the tiles they are about to show, which
+ * decodes them in the background and makes them available through the
+ * ImageCache.
+ *
+ * Apart from the decoding done for prefetching, all of this happens on the
+ * GUI thread.
+ */
+class TILEDSHARED_EXPORT TileImageLoader
+{
+public:
+    /**
+     * Starts decoding the deferred images of the given \a tiles that are
+     * not in memory.
+     */
+    static void prefetch(const QList<Tile*> &tiles);
+
+    /**
+     * Sets the maximum number of bytes used by deferred tile images.
+     * Defaults to 128 MB.
+     */
+    static void setMaximumCost(qint64 bytes);
+    static qint64 maximumCost();
+
+    /**
+     * Returns the number of bytes used by the deferred tile images that are
+     * currently in memory.
+     */
+    static qint64 totalCost();
+
+    /**
+     * Releases the least recently used images until the total cost is
+     * within the maximum cost. This is done automatically shortly after
+     * the maximum cost was exceeded.
+     */
+    static void releaseUnusedImages();
+
+private:
+    friend class Tile;
+
+    static void imageLoaded(const Tile *tile);
+    static void imageReleased(const Tile *tile);
+    static quint64 nextUsage();
+};
+
+} // namespace Tiled
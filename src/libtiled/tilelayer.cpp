@@ -32,6 +32,8 @@
 #include "tile.h"
 #include "hex.h"
 
+#include <cstring>
+
 using namespace Tiled;
 
 TileLayer::TileLayer(const QString &name, int x, int y, int width, int height)
@@ -86,25 +88,26 @@ QMargins TileLayer::drawMargins() const
 
 QRegion TileLayer::region(std::function<bool (const Cell &)> condition) const
 {
-    QRegion region;
+    return mask(condition).toRegion();
+}
+
+TileMask TileLayer::mask(std::function<bool (const Cell &)> condition) const
+{
+    TileMask mask;
 
     for (int y = 0; y < mHeight; ++y) {
         for (int x = 0; x < mWidth; ++x) {
             if (condition(cellAt(x, y))) {
                 const int rangeStart = x;
-                for (++x; x <= mWidth; ++x) {
-                    if (x == mWidth || !condition(cellAt(x, y))) {
-                        const int rangeEnd = x;
-                        region += QRect(rangeStart + mX, y + mY,
-                                        rangeEnd - rangeStart, 1);
-                        break;
-                    }
-                }
+                while (x + 1 < mWidth && condition(cellAt(x + 1, y)))
+                    ++x;
+
+                mask.addSpan(y + mY, rangeStart + mX, x + mX);
             }
         }
     }
 
-    return region;
+    return mask;
 }
 
 /**
@@ -392,7 +395,7 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
     mHeight = newHeight;
     mGrid = newGrid;
 
-    QRect filledRect = region().boundingRect();
+    QRect filledRect = mask().boundingRect();
 
     if (staggerAxis == Map::StaggerY) {
         if (filledRect.y() & 1)
@@ -591,6 +594,22 @@ TileLayer *TileLayer::clone() const
     return initializeClone(new TileLayer(mName, mX, mY, mWidth, mHeight));
 }
 
+QByteArray TileLayer::takeCells()
+{
+    const QByteArray data(reinterpret_cast<const char*>(mGrid.constData()),
+                          mGrid.size() * int(sizeof(Cell)));
+    mGrid = QVector<Cell>();
+    return data;
+}
+
+void TileLayer::restoreCells(const QByteArray &data)
+{
+    Q_ASSERT(data.size() == mWidth * mHeight * int(sizeof(Cell)));
+
+    mGrid.resize(mWidth * mHeight);
+    memcpy(mGrid.data(), data.constData(), data.size());
+}
+
 TileLayer *TileLayer::initializeClone(TileLayer *clone) const
 {
     Layer::initializeClone(clone);
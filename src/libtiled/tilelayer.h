@@ -35,6 +35,7 @@
 #include "layer.h"
 #include "tiled.h"
 #include "tile.h"
+#include "tilemask.h"
 #include "tileset.h"
 
 #include <QMargins>
@@ -203,6 +204,13 @@ public:
      */
     QRegion region() const;
 
+    /**
+     * Like region(), but returns a TileMask, which is cheaper to compute and
+     * to combine for irregular shapes.
+     */
+    TileMask mask(std::function<bool (const Cell &)> condition) const;
+    TileMask mask() const;
+
     const Cell &cellAt(int x, int y) const;
     const Cell &cellAt(const QPoint &point) const;
 
@@ -331,6 +339,18 @@ public:
 
     TileLayer *clone() const override;
 
+    /**
+     * Moves the cells out of this layer, as raw bytes. Until they are put
+     * back with restoreCells(), the layer keeps its size but has no cells,
+     * so its cells may not be accessed.
+     *
+     * This allows reducing the memory held by layers that are not part of a
+     * map, like the ones kept by undo commands. Since cells refer to their
+     * tileset by pointer, the data is only valid within the same process.
+     */
+    QByteArray takeCells();
+    void restoreCells(const QByteArray &data);
+
     // Enable easy iteration over cells with range-based for
     QVector<Cell>::iterator begin() { return mGrid.begin(); }
     QVector<Cell>::iterator end() { return mGrid.end(); }
@@ -373,7 +393,12 @@ inline bool TileLayer::contains(const QPoint &point) const
 
 inline QRegion TileLayer::region() const
 {
-    return region([] (const Cell &cell) { return !cell.isEmpty(); });
+    return mask().toRegion();
+}
+
+inline TileMask TileLayer::mask() const
+{
+    return mask([] (const Cell &cell) { return !cell.isEmpty(); });
 }
 
 /**
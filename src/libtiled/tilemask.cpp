@@ -0,0 +1,432 @@
+/*
+ * tilemask.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "tilemask.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace Tiled;
+
+namespace {
+
+enum Operation {
+    Unite,
+    Intersect,
+    Subtract
+};
+
+/**
+ * Combines the runs of two rows using the given operation.
+ *
+ * Both rows are visited as a sorted sequence of boundaries, where a run is
+ * entered at its left and left again after its right. Since the runs within
+ * a row never touch, each row contributes at most one boundary per position.
+ */
+TileMask::Row combineRows(const TileMask::Row &a,
+                          const TileMask::Row &b,
+                          Operation operation)
+{
+    switch (operation) {
+    case Unite:
+        if (a.isEmpty())
+            return b;
+        if (b.isEmpty())
+            return a;
+        if (a.last().right + 1 < b.first().left)
+            return a + b;
+        if (b.last().right + 1 < a.first().left)
+            return b + a;
+        break;
+    case Intersect:
+        if (a.isEmpty() || b.isEmpty())
+            return TileMask::Row();
+        break;
+    case Subtract:
+        if (a.isEmpty() || b.isEmpty())
+            return a;
+        break;
+    }
+
+    auto boundary = [] (const TileMask::Row &row, int index) {
+        const TileMask::Span &span = row.at(index >> 1);
+        return (index & 1) ? span.right + 1 : span.left;
+    };
+
+    TileMask::Row result;
+    result.reserve(a.size() + b.size());
+
+    const int boundariesA = a.size() * 2;
+    const int boundariesB = b.size() * 2;
+    int indexA = 0;
+    int indexB = 0;
+    bool inA = false;
+    bool inB = false;
+    bool inside = false;
+    int start = 0;
+
+    while (indexA < boundariesA || indexB < boundariesB) {
+        const int nextA = indexA < boundariesA ? boundary(a, indexA) : INT_MAX;
+        const int nextB = indexB < boundariesB ? boundary(b, indexB) : INT_MAX;
+        const int x = qMin(nextA, nextB);
+
+        if (nextA == x) {
+            inA = !inA;
+            ++indexA;
+        }
+        if (nextB == x) {
+            inB = !inB;
+            ++indexB;
+        }
+
+        bool include = false;
+        switch (operation) {
+        case Unite:     include = inA || inB; break;
+        case Intersect: include = inA && inB; break;
+        case Subtract:  include = inA && !inB; break;
+        }
+
+        if (include != inside) {
+            if (include)
+                start = x;
+            else
+                result.append(TileMask::Span { start, x - 1 });
+            inside = include;
+        }
+    }
+
+    return result;
+}
+
+} // anonymous namespace
+
+TileMask::TileMask()
+    : mTop(0)
+{
+}
+
+TileMask::TileMask(const QRect &rect)
+    : mTop(0)
+{
+    addRect(rect);
+}
+
+TileMask::TileMask(const QRegion &region)
+    : mTop(0)
+{
+    if (region.isEmpty())
+        return;
+
+    const QRect bounds = region.boundingRect();
+    ensureRows(bounds.top(), bounds.bottom());
+
+    // The rectangles of a region are sorted by row and then by column, so
+    // each run can be appended to its row.
+    foreach (const QRect &rect, region.rects())
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
+            addSpan(y, rect.left(), rect.right());
+
+    trim();
+}
+
+const TileMask::Row &TileMask::row(int y) const
+{
+    static const Row emptyRow;
+
+    const int index = y - mTop;
+    if (index < 0 || index >= mRows.size())
+        return emptyRow;
+
+    return mRows.at(index);
+}
+
+QRect TileMask::boundingRect() const
+{
+    if (isEmpty())
+        return QRect();
+
+    int left = INT_MAX;
+    int right = INT_MIN;
+
+    for (const Row &row : mRows) {
+        if (row.isEmpty())
+            continue;
+
+        left = qMin(left, row.first().left);
+        right = qMax(right, row.last().right);
+    }
+
+    return QRect(QPoint(left, top()), QPoint(right, bottom()));
+}
+
+int TileMask::cellCount() const
+{
+    int count = 0;
+    for (const Row &row : mRows)
+        for (const Span &span : row)
+            count += span.width();
+    return count;
+}
+
+bool TileMask::contains(int x, int y) const
+{
+    const Row &spans = row(y);
+
+    // Find the first run that does not end before x
+    auto it = std::lower_bound(spans.begin(), spans.end(), x,
+                               [] (const Span &span, int x) { return span.right < x; });
+
+    return it != spans.end() && it->left <= x;
+}
+
+bool TileMask::intersects(const TileMask &other) const
+{
+    const int top = qMax(mTop, other.mTop);
+    const int bottom = qMin(this->bottom(), other.bottom());
+
+    for (int y = top; y <= bottom; ++y) {
+        const Row &a = row(y);
+        const Row &b = other.row(y);
+
+        int i = 0;
+        int j = 0;
+
+        while (i < a.size() && j < b.size()) {
+            if (a.at(i).right < b.at(j).left)
+                ++i;
+            else if (b.at(j).right < a.at(i).left)
+                ++j;
+            else
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void TileMask::addSpan(int y, int left, int right)
+{
+    if (left > right)
+        return;
+
+    ensureRows(y, y);
+
+    Row &spans = mRows[y - mTop];
+
+    if (spans.isEmpty() || spans.last().right + 1 < left) {
+        spans.append(Span { left, right });
+    } else if (spans.last().left <= left) {
+        Span &last = spans.last();
+        last.right = qMax(last.right, right);
+    } else {
+        spans = combineRows(spans, Row { Span { left, right } }, Unite);
+    }
+}
+
+void TileMask::addRect(const QRect &rect)
+{
+    if (rect.isEmpty())
+        return;
+
+    ensureRows(rect.top(), rect.bottom());
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        addSpan(y, rect.left(), rect.right());
+}
+
+void TileMask::unite(const TileMask &other)
+{
+    if (other.isEmpty())
+        return;
+
+    if (isEmpty()) {
+        *this = other;
+        return;
+    }
+
+    ensureRows(other.top(), other.bottom());
+
+    for (int y = other.top(); y <= other.bottom(); ++y) {
+        Row &spans = mRows[y - mTop];
+        spans = combineRows(spans, other.row(y), Unite);
+    }
+}
+
+void TileMask::intersect(const TileMask &other)
+{
+    const int top = qMax(mTop, other.mTop);
+    const int bottom = qMin(this->bottom(), other.bottom());
+
+    if (isEmpty() || other.isEmpty() || top > bottom) {
+        *this = TileMask();
+        return;
+    }
+
+    QVector<Row> rows(bottom - top + 1);
+    for (int y = top; y <= bottom; ++y)
+        rows[y - top] = combineRows(row(y), other.row(y), Intersect);
+
+    mTop = top;
+    mRows.swap(rows);
+    trim();
+}
+
+void TileMask::subtract(const TileMask &other)
+{
+    const int top = qMax(mTop, other.mTop);
+    const int bottom = qMin(this->bottom(), other.bottom());
+
+    if (isEmpty() || other.isEmpty() || top > bottom)
+        return;
+
+    for (int y = top; y <= bottom; ++y) {
+        Row &spans = mRows[y - mTop];
+        spans = combineRows(spans, other.row(y), Subtract);
+    }
+
+    trim();
+}
+
+void TileMask::translate(const QPoint &offset)
+{
+    if (isEmpty())
+        return;
+
+    mTop += offset.y();
+
+    if (offset.x() != 0) {
+        for (Row &row : mRows) {
+            for (Span &span : row) {
+                span.left += offset.x();
+                span.right += offset.x();
+            }
+        }
+    }
+}
+
+TileMask TileMask::united(const TileMask &other) const
+{
+    TileMask result(*this);
+    result.unite(other);
+    return result;
+}
+
+TileMask TileMask::intersected(const TileMask &other) const
+{
+    TileMask result(*this);
+    result.intersect(other);
+    return result;
+}
+
+TileMask TileMask::subtracted(const TileMask &other) const
+{
+    TileMask result(*this);
+    result.subtract(other);
+    return result;
+}
+
+TileMask TileMask::translated(const QPoint &offset) const
+{
+    TileMask result(*this);
+    result.translate(offset);
+    return result;
+}
+
+bool TileMask::operator==(const TileMask &other) const
+{
+    return mTop == other.mTop && mRows == other.mRows;
+}
+
+QRegion TileMask::toRegion() const
+{
+    QVector<QRect> rects;
+    int bandStart = 0;  // index of the first rectangle of the current band
+
+    for (int i = 0; i < mRows.size(); ++i) {
+        const Row &spans = mRows.at(i);
+        if (spans.isEmpty())
+            continue;
+
+        const int y = mTop + i;
+
+        // Grow the current band when this row has the same runs
+        if (i > 0 && spans == mRows.at(i - 1)) {
+            for (int r = bandStart; r < rects.size(); ++r)
+                rects[r].setBottom(y);
+            continue;
+        }
+
+        bandStart = rects.size();
+        for (const Span &span : spans)
+            rects.append(QRect(span.left, y, span.width(), 1));
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
+
+void TileMask::ensureRows(int top, int bottom)
+{
+    if (mRows.isEmpty()) {
+        mTop = top;
+        mRows.resize(bottom - top + 1);
+        return;
+    }
+
+    if (top < mTop) {
+        mRows.insert(0, mTop - top, Row());
+        mTop = top;
+    }
+
+    if (bottom > this->bottom())
+        mRows.resize(bottom - mTop + 1);
+}
+
+void TileMask::trim()
+{
+    int first = 0;
+    while (first < mRows.size() && mRows.at(first).isEmpty())
+        ++first;
+
+    int last = mRows.size() - 1;
+    while (last >= first && mRows.at(last).isEmpty())
+        --last;
+
+    if (first > last) {
+        mTop = 0;
+        mRows.clear();
+        return;
+    }
+
+    if (first > 0 || last < mRows.size() - 1) {
+        mRows = mRows.mid(first, last - first + 1);
+        mTop += first;
+    }
+}
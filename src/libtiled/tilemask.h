@@ -0,0 +1,139 @@
+/*
+ * tilemask.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+
+/**
+ * A set of tiles, stored as a sorted list of horizontal runs for each row.
+ *
+ * Unlike QRegion, which needs to merge its rectangles into bands, the runs of
+ * each row are independent. This keeps the set operations linear in the
+ * number of runs in the affected rows, also for irregular shapes like the
+ * ones created by the magic wand.
+ *
+ * Within a row the runs are sorted, and they never overlap or touch. This
+ * means two masks covering the same tiles always compare equal.
+ */
+class TILEDSHARED_EXPORT TileMask
+{
+public:
+    /**
+     * A horizontal run of tiles, from \a left up to and including \a right.
+     */
+    struct Span
+    {
+        int left;
+        int right;
+
+        int width() const { return right - left + 1; }
+
+        bool operator==(const Span &other) const
+        { return left == other.left && right == other.right; }
+    };
+
+    typedef QVector<Span> Row;
+
+    TileMask();
+    TileMask(const QRect &rect);
+    TileMask(const QRegion &region);
+
+    bool isEmpty() const { return mRows.isEmpty(); }
+
+    /**
+     * Returns the first row containing tiles.
+     */
+    int top() const { return mTop; }
+
+    /**
+     * Returns the last row containing tiles.
+     */
+    int bottom() const { return mTop + mRows.size() - 1; }
+
+    /**
+     * Returns the runs in row \a y, which may be empty.
+     */
+    const Row &row(int y) const;
+
+    QRect boundingRect() const;
+    int cellCount() const;
+
+    bool contains(int x, int y) const;
+    bool contains(const QPoint &point) const { return contains(point.x(), point.y()); }
+
+    bool intersects(const TileMask &other) const;
+
+    /**
+     * Adds the run of tiles from \a left to \a right on row \a y.
+     *
+     * Adding runs in row by row and left to right order is the most
+     * efficient way of building up a mask.
+     */
+    void addSpan(int y, int left, int right);
+    void addRect(const QRect &rect);
+
+    void unite(const TileMask &other);
+    void intersect(const TileMask &other);
+    void subtract(const TileMask &other);
+    void translate(const QPoint &offset);
+
+    TileMask united(const TileMask &other) const;
+    TileMask intersected(const TileMask &other) const;
+    TileMask subtracted(const TileMask &other) const;
+    TileMask translated(const QPoint &offset) const;
+
+    TileMask &operator+=(const TileMask &other) { unite(other); return *this; }
+    TileMask &operator-=(const TileMask &other) { subtract(other); return *this; }
+    TileMask &operator&=(const TileMask &other) { intersect(other); return *this; }
+
+    bool operator==(const TileMask &other) const;
+    bool operator!=(const TileMask &other) const { return !(*this == other); }
+
+    /**
+     * Converts the mask to a region. Identical consecutive rows are merged
+     * into a single band of rectangles.
+     */
+    QRegion toRegion() const;
+
+private:
+    void ensureRows(int top, int bottom);
+    void trim();
+
+    int mTop;
+    QVector<Row> mRows;
+};
+
+} // namespace Tiled
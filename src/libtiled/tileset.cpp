@@ -34,6 +34,10 @@
 #include "tilesetformat.h"
 
 #include <QBitmap>
+#include <QFile>
+#include <QImageReader>
+
+#include <climits>
 
 using namespace Tiled;
 
@@ -116,6 +120,7 @@ Tile *Tileset::findOrCreateTile(int id)
         return tile;
 
     mNextTileId = std::max(mNextTileId, id + 1);
+    markTerrainDistancesDirty();
     return mTiles[id] = new Tile(id, this);
 }
 
@@ -200,10 +205,12 @@ bool Tileset::loadFromImage(const QImage &image,
             }
 
             auto it = mTiles.find(tileNum);
-            if (it != mTiles.end())
+            if (it != mTiles.end()) {
                 it.value()->setImage(tilePixmap);
-            else
+            } else {
                 mTiles.insert(tileNum, new Tile(tilePixmap, tileNum, this));
+                markTerrainDistancesDirty();
+            }
 
             ++tileNum;
         }
@@ -362,7 +369,7 @@ void Tileset::insertTerrain(int index, Terrain *terrain)
         }
     }
 
-    mTerrainDistancesDirty = true;
+    markTerrainDistancesDirty();
 }
 
 /**
@@ -392,7 +399,7 @@ Terrain *Tileset::takeTerrainAt(int index)
         }
     }
 
-    mTerrainDistancesDirty = true;
+    markTerrainDistancesDirty();
 
     return terrain;
 }
@@ -419,6 +426,61 @@ int Tileset::terrainTransitionPenalty(int terrainType0, int terrainType1) const
     return mTerrainTypes.at(terrainType0)->transitionDistance(terrainType1);
 }
 
+/**
+ * Returns the tiles that best match the given \a terrain. Only the corners
+ * selected by \a considerationMask need to match exactly, while for the other
+ * corners the tiles with the lowest total transition penalty are returned.
+ *
+ * Tiles are grouped by their terrain and the result is remembered for each
+ * combination of terrain and mask, so that repeated lookups are cheap. This
+ * lookup is reset whenever the terrain information or the tiles change.
+ */
+QVector<Tile*> Tileset::bestTerrainTiles(unsigned terrain,
+                                         unsigned considerationMask) const
+{
+    const quint64 key = (quint64(considerationMask) << 32) | terrain;
+
+    auto it = mBestTerrainTiles.constFind(key);
+    if (it != mBestTerrainTiles.constEnd())
+        return it.value();
+
+    if (mTilesByTerrain.isEmpty()) {
+        for (Tile *tile : mTiles)
+            mTilesByTerrain[tile->terrain()].append(tile);
+    }
+
+    QVector<Tile*> bestTiles;
+    int penalty = INT_MAX;
+
+    for (auto i = mTilesByTerrain.constBegin(), end = mTilesByTerrain.constEnd(); i != end; ++i) {
+        const unsigned tileTerrain = i.key();
+
+        if ((tileTerrain & considerationMask) != (terrain & considerationMask))
+            continue;
+
+        // calculate the tile transition penalty based on shortest distance to target terrain type
+        int tr = terrainTransitionPenalty(tileTerrain >> 24, terrain >> 24);
+        int tl = terrainTransitionPenalty((tileTerrain >> 16) & 0xFF, (terrain >> 16) & 0xFF);
+        int br = terrainTransitionPenalty((tileTerrain >> 8) & 0xFF, (terrain >> 8) & 0xFF);
+        int bl = terrainTransitionPenalty(tileTerrain & 0xFF, terrain & 0xFF);
+
+        // if there is no path to the destination terrain, this isn't a useful transition
+        if (tr < 0 || tl < 0 || br < 0 || bl < 0)
+            continue;
+
+        int transitionPenalty = tr + tl + br + bl;
+        if (transitionPenalty < penalty) {
+            bestTiles.clear();
+            penalty = transitionPenalty;
+        }
+        if (transitionPenalty == penalty)
+            bestTiles += i.value();
+    }
+
+    mBestTerrainTiles.insert(key, bestTiles);
+    return bestTiles;
+}
+
 /**
  * Calculates the transition distance matrix for all terrain types.
  */
@@ -515,6 +577,8 @@ Tile *Tileset::addTile(const QPixmap &image, const QString &source)
     newTile->setImageSource(source);
 
     mTiles.insert(newTile->id(), newTile);
+    markTerrainDistancesDirty();
+
     if (mTileHeight < image.height())
         mTileHeight = image.height();
     if (mTileWidth < image.width())
@@ -534,6 +598,7 @@ void Tileset::addTiles(const QList<Tile *> &tiles)
         mTiles.insert(tile->id(), tile);
     }
 
+    markTerrainDistancesDirty();
     updateTileSize();
 }
 
@@ -549,6 +614,7 @@ void Tileset::removeTiles(const QList<Tile *> &tiles)
         mTiles.remove(tile->id());
     }
 
+    markTerrainDistancesDirty();
     updateTileSize();
 }
 
@@ -558,6 +624,7 @@ void Tileset::removeTiles(const QList<Tile *> &tiles)
 void Tileset::deleteTile(int id)
 {
     delete mTiles.take(id);
+    markTerrainDistancesDirty();
 }
 
 /**
@@ -574,25 +641,68 @@ void Tileset::setTileImage(Tile *tile,
     Q_ASSERT(isCollection());
     Q_ASSERT(mTiles.value(tile->id()) == tile);
 
-    const QSize previousImageSize = tile->image().size();
-    const QSize newImageSize = image.size();
+    const QSize previousImageSize = tile->size();
 
     tile->setImage(image);
     tile->setImageSource(source);
 
-    if (previousImageSize != newImageSize) {
-        // Update our max. tile size
-        if (previousImageSize.height() == mTileHeight ||
-                previousImageSize.width() == mTileWidth) {
-            // This used to be the max image; we have to recompute
-            updateTileSize();
-        } else {
-            // Check if we have a new maximum
-            if (mTileHeight < newImageSize.height())
-                mTileHeight = newImageSize.height();
-            if (mTileWidth < newImageSize.width())
-                mTileWidth = newImageSize.width();
-        }
+    updateTileSize(previousImageSize, image.size());
+}
+
+/**
+ * Sets the tile with the given \a id to load its image from \a source when
+ * it is first used. This avoids loading images that are never used, which
+ * matters for large image collection tilesets.
+ *
+ * The \a size of the image is needed to lay out the tile before its image
+ * is loaded. When it is not given, it is read from the header of the image
+ * file. When the image file can't be read, the tile is left without image.
+ */
+void Tileset::setDeferredTileImage(Tile *tile,
+                                   const QString &source,
+                                   QSize size)
+{
+    Q_ASSERT(isCollection());
+    Q_ASSERT(mTiles.value(tile->id()) == tile);
+
+    const QSize previousImageSize = tile->size();
+
+    // Reading the size from the image header also checks that it exists
+    if (size.isEmpty())
+        size = QImageReader(source).size();
+    else if (!QFile::exists(source))
+        size = QSize();
+
+    if (size.isValid()) {
+        tile->setDeferredImage(source, size);
+    } else {
+        tile->setImage(QPixmap());
+        tile->setImageSource(source);
+    }
+
+    updateTileSize(previousImageSize, tile->size());
+}
+
+/**
+ * Makes sure the tile width and tile height properties reflect the maximum
+ * size, after the image of a tile changed size.
+ */
+void Tileset::updateTileSize(const QSize &previousImageSize,
+                             const QSize &newImageSize)
+{
+    if (previousImageSize == newImageSize)
+        return;
+
+    if (previousImageSize.height() == mTileHeight ||
+            previousImageSize.width() == mTileWidth) {
+        // This used to be the max image; we have to recompute
+        updateTileSize();
+    } else {
+        // Check if we have a new maximum
+        if (mTileHeight < newImageSize.height())
+            mTileHeight = newImageSize.height();
+        if (mTileWidth < newImageSize.width())
+            mTileWidth = newImageSize.width();
     }
 }
 
@@ -624,6 +734,10 @@ void Tileset::swap(Tileset &other)
 
     // Don't swap mWeakPointer, since it's a reference to this.
 
+    // The terrain lookup refers to the tiles, so it needs to be rebuilt
+    markTerrainDistancesDirty();
+    other.markTerrainDistancesDirty();
+
     // Update back references from tiles and terrains
     for (auto tile : mTiles)
         tile->mTileset = this;
@@ -29,10 +29,12 @@
 
 #pragma once
 
+#include "imagecache.h"
 #include "imagereference.h"
 #include "object.h"
 
 #include <QColor>
+#include <QHash>
 #include <QList>
 #include <QPixmap>
 #include <QPoint>
@@ -184,6 +186,9 @@ public:
 
     int terrainTransitionPenalty(int terrainType0, int terrainType1) const;
 
+    QVector<Tile*> bestTerrainTiles(unsigned terrain,
+                                    unsigned considerationMask) const;
+
     Tile *addTile(const QPixmap &image, const QString &source = QString());
     void addTiles(const QList<Tile*> &tiles);
     void removeTiles(const QList<Tile *> &tiles);
@@ -196,6 +201,9 @@ public:
     void setTileImage(Tile *tile,
                       const QPixmap &image,
                       const QString &source = QString());
+    void setDeferredTileImage(Tile *tile,
+                              const QString &source,
+                              QSize size = QSize());
 
     void markTerrainDistancesDirty();
 
@@ -228,8 +236,12 @@ public:
 
 private:
     void updateTileSize();
+    void updateTileSize(const QSize &previousImageSize,
+                        const QSize &newImageSize);
     void recalculateTerrainDistances();
 
+    friend class Tile; // To update the tile size after loading an image
+
     QString mName;
     QString mFileName;
     ImageReference mImageReference;
@@ -247,6 +259,8 @@ private:
     int mNextTileId;
     QList<Terrain*> mTerrainTypes;
     bool mTerrainDistancesDirty;
+    mutable QHash<unsigned, QVector<Tile*>> mTilesByTerrain;
+    mutable QHash<quint64, QVector<Tile*>> mBestTerrainTiles;
     bool mLoaded;
     QColor mBackgroundColor;
     QPointer<TilesetFormat> mFormat;
@@ -507,7 +521,7 @@ inline void Tileset::setBackgroundColor(QColor color)
  */
 inline bool Tileset::loadFromImage(const QString &fileName)
 {
-    return loadFromImage(QImage(fileName), fileName);
+    return loadFromImage(ImageCache::loadImage(fileName), fileName);
 }
 
 /**
@@ -579,11 +593,15 @@ inline int Tileset::takeNextTileId()
 }
 
 /**
- * Used by the Tile class when its terrain information changes.
+ * Used by the Tile class when its terrain information changes. Also used
+ * when tiles are added or removed, since this invalidates the lookup done
+ * by bestTerrainTiles().
  */
 inline void Tileset::markTerrainDistancesDirty()
 {
     mTerrainDistancesDirty = true;
+    mTilesByTerrain.clear();
+    mBestTerrainTiles.clear();
 }
 
 inline SharedTileset Tileset::sharedPointer() const
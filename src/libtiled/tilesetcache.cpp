@@ -0,0 +1,308 @@
+/*
+ * tilesetcache.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tilesetcache.h"
+
+#include "imagecache.h"
+#include "imagedecoder.h"
+#include "imagereference.h"
+#include "maptovariantconverter.h"
+#include "tile.h"
+#include "varianttomapconverter.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+
+using namespace Tiled;
+
+namespace {
+
+const quint32 CacheMagic = 0x54534358; // "TSCX"
+const quint32 CacheVersion = 1;
+
+struct TilesetCacheData
+{
+    QMutex mutex;
+    QString directory;
+};
+
+Q_GLOBAL_STATIC(TilesetCacheData, cacheData)
+
+/**
+ * The modification time and size of a file, used to detect whether a file
+ * has changed since the cache entry was written.
+ */
+struct FileStamp
+{
+    FileStamp() : lastModified(0), size(-1) {}
+
+    explicit FileStamp(const QString &fileName)
+        : path(fileName)
+    {
+        const QFileInfo fileInfo(fileName);
+        lastModified = fileInfo.exists() ? fileInfo.lastModified().toMSecsSinceEpoch() : 0;
+        size = fileInfo.exists() ? fileInfo.size() : -1;
+    }
+
+    bool isUpToDate() const
+    {
+        const FileStamp current(path);
+        return current.size == size && current.lastModified == lastModified;
+    }
+
+    QString path;
+    qint64 lastModified;
+    qint64 size;
+};
+
+QDataStream &operator<<(QDataStream &out, const FileStamp &stamp)
+{
+    return out << stamp.path << stamp.lastModified << stamp.size;
+}
+
+QDataStream &operator>>(QDataStream &in, FileStamp &stamp)
+{
+    return in >> stamp.path >> stamp.lastModified >> stamp.size;
+}
+
+QString entryFileName(const QString &directory, const QString &fileName)
+{
+    const QString path = QFileInfo(fileName).canonicalFilePath();
+    if (path.isEmpty())
+        return QString();
+
+    const QByteArray key = QCryptographicHash::hash(path.toUtf8(),
+                                                    QCryptographicHash::Sha1);
+    return directory + QLatin1Char('/') + QString::fromLatin1(key.toHex())
+            + QLatin1String(".tscache");
+}
+
+/**
+ * Returns the image files of the \a tileset that are stored along with it.
+ * Returns false when the tileset uses embedded images, which can't be
+ * validated against a file.
+ *
+ * The images of tiles in image collection tilesets are not stored, since
+ * they are only loaded once they are used.
+ */
+bool collectImageFiles(const Tileset &tileset, QStringList &files)
+{
+    if (!tileset.isCollection()) {
+        files.append(tileset.imageSource());
+        return true;
+    }
+
+    if (tileset.imageReference().hasImage())
+        return false;
+
+    for (const Tile *tile : tileset.tiles())
+        if (tile->imageSource().isEmpty() && tile->imageLoaded())
+            return false;
+
+    return true;
+}
+
+} // anonymous namespace
+
+
+void TilesetCache::setCacheDirectory(const QString &path)
+{
+    TilesetCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+    d->directory = path;
+}
+
+QString TilesetCache::cacheDirectory()
+{
+    TilesetCacheData *d = cacheData();
+    QMutexLocker locker(&d->mutex);
+    return d->directory;
+}
+
+SharedTileset TilesetCache::load(const QString &fileName, bool loadImages)
+{
+    const QString directory = cacheDirectory();
+    if (directory.isEmpty())
+        return SharedTileset();
+
+    QFile file(entryFileName(directory, fileName));
+    if (file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly))
+        return SharedTileset();
+
+    QDataStream in(&file);
+
+    quint32 magic, version;
+    in >> magic >> version;
+    if (magic != CacheMagic || version != CacheVersion)
+        return SharedTileset();
+
+    in.setVersion(QDataStream::Qt_5_4);
+
+    FileStamp source;
+    QVector<FileStamp> images;
+    QVariant variant;
+    in >> source >> images >> variant;
+
+    if (in.status() != QDataStream::Ok)
+        return SharedTileset();
+
+    // Any change to the tileset or its images invalidates the entry
+    if (source.path != QFileInfo(fileName).canonicalFilePath() || !source.isUpToDate())
+        return SharedTileset();
+    for (const FileStamp &image : images)
+        if (!image.isUpToDate())
+            return SharedTileset();
+
+    // The pixels follow the stamps in the same order. They are stored in
+    // native byte order, since the cache is never shared between machines.
+    QVector<QImage> pixels;
+    pixels.reserve(images.size());
+
+    for (int i = 0; i < images.size(); ++i) {
+        qint32 width, height;
+        in >> width >> height;
+        if (in.status() != QDataStream::Ok || width <= 0 || height <= 0)
+            return SharedTileset();
+
+        QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+        if (image.isNull())
+            return SharedTileset();
+
+        const int byteCount = image.byteCount();
+        if (in.readRawData(reinterpret_cast<char*>(image.bits()), byteCount) != byteCount)
+            return SharedTileset();
+
+        pixels.append(image);
+    }
+
+    for (int i = 0; i < images.size(); ++i)
+        ImageCache::insert(images.at(i).path, pixels.at(i));
+
+    // While the pixels are still referenced, loading the images of the
+    // tileset is served by the ImageCache
+    VariantToMapConverter converter;
+    converter.setImageLoadingEnabled(loadImages);
+
+    SharedTileset tileset = converter.toTileset(variant, QFileInfo(fileName).dir());
+    if (tileset)
+        tileset->setFileName(fileName);
+
+    return tileset;
+}
+
+bool TilesetCache::store(const Tileset &tileset, const QString &fileName)
+{
+    const QString directory = cacheDirectory();
+    if (directory.isEmpty())
+        return false;
+
+    const QString entry = entryFileName(directory, fileName);
+    if (entry.isEmpty())
+        return false;
+
+    QStringList files;
+    if (!collectImageFiles(tileset, files))
+        return false;
+
+    QVector<ImageReference> references;
+    QVector<FileStamp> images;
+    references.reserve(files.size());
+    images.reserve(files.size());
+
+    for (const QString &file : files) {
+        ImageReference reference;
+        reference.source = file;
+        references.append(reference);
+        images.append(FileStamp(file));
+    }
+
+    // The images were usually just loaded along with the tileset, in which
+    // case they are still in the ImageCache
+    const QVector<QImage> pixels = ImageDecoder::decodeAll(references);
+    for (const QImage &image : pixels)
+        if (image.isNull())
+            return false;
+
+    // A clone has no file name, so that the full tileset is converted rather
+    // than a reference to its file
+    const SharedTileset clone = tileset.clone();
+    MapToVariantConverter converter;
+    const QVariant variant = converter.toVariant(*clone, QFileInfo(fileName).dir());
+
+    if (!QDir().mkpath(directory))
+        return false;
+
+    // Always written atomically, since another thread or instance may be
+    // reading the same entry
+    QSaveFile file(entry);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out << CacheMagic << CacheVersion;
+    out.setVersion(QDataStream::Qt_5_4);
+
+    FileStamp source(fileName);
+    source.path = QFileInfo(fileName).canonicalFilePath();
+    out << source << images << variant;
+
+    for (const QImage &image : pixels) {
+        const QImage premultiplied =
+                image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+        out << qint32(premultiplied.width()) << qint32(premultiplied.height());
+        out.writeRawData(reinterpret_cast<const char*>(premultiplied.constBits()),
+                         premultiplied.byteCount());
+    }
+
+    if (out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+void TilesetCache::clear()
+{
+    const QString directory = cacheDirectory();
+    if (directory.isEmpty())
+        return;
+
+    QDir dir(directory);
+    const QStringList entries = dir.entryList(QStringList(QLatin1String("*.tscache")),
+                                              QDir::Files);
+    for (const QString &entry : entries)
+        dir.remove(entry);
+}
@@ -0,0 +1,84 @@
+/*
+ * tilesetcache.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tileset.h"
+
+#include <QString>
+
+namespace Tiled {
+
+/**
+ * An optional on-disk cache of tilesets, which allows loading a tileset
+ * without parsing its file and without decoding its image.
+ *
+ * For each tileset file, the cache directory contains an entry with the
+ * tileset in a binary format along with the pixels of its image,
+ * premultiplied so they can be painted without conversion. An entry is only
+ * used while the tileset file and its image have the same modification
+ * time and size as when the entry was written. The images of tiles in image
+ * collection tilesets are not stored, since these are loaded on first use.
+ *
+ * The cache is disabled until a cache directory has been set.
+ */
+class TILEDSHARED_EXPORT TilesetCache
+{
+public:
+    /**
+     * Sets the directory where the cache entries are stored. An empty
+     * \a path disables the cache.
+     */
+    static void setCacheDirectory(const QString &path);
+    static QString cacheDirectory();
+
+    static bool isEnabled() { return !cacheDirectory().isEmpty(); }
+
+    /**
+     * Loads the tileset stored in \a fileName from the cache. Returns null
+     * when the cache is disabled or has no valid entry for this file.
+     *
+     * The cached pixels are made available through the ImageCache. When
+     * \a loadImages is false, the images of the tileset are not set up, and
+     * are left for the caller to load.
+     */
+    static SharedTileset load(const QString &fileName, bool loadImages = true);
+
+    /**
+     * Stores the \a tileset that was read from \a fileName in the cache.
+     * Returns whether an entry was written.
+     */
+    static bool store(const Tileset &tileset, const QString &fileName);
+
+    /**
+     * Removes all entries from the cache directory.
+     */
+    static void clear();
+};
+
+} // namespace Tiled
@@ -30,6 +30,8 @@
 #include "tilesetmanager.h"
 
 #include "filesystemwatcher.h"
+#include "imagecache.h"
+#include "imagedecoder.h"
 #include "tileanimationdriver.h"
 #include "tile.h"
 #include "tilesetformat.h"
@@ -46,6 +48,7 @@ TilesetManager *TilesetManager::mInstance;
 TilesetManager::TilesetManager():
     mWatcher(new FileSystemWatcher(this)),
     mAnimationDriver(new TileAnimationDriver(this)),
+    mImageDecoder(new ImageDecoder(this)),
     mReloadTilesetsOnChange(false)
 {
     connect(mWatcher, SIGNAL(fileChanged(QString)),
@@ -66,6 +69,9 @@ TilesetManager::~TilesetManager()
     // Since all MapDocuments should be deleted first, we assert that there are
     // no remaining tileset references.
     Q_ASSERT(mTilesets.isEmpty());
+
+    // Release the cached pixmaps while the application is still around
+    ImageCache::clear();
 }
 
 /**
@@ -182,10 +188,19 @@ void TilesetManager::reloadImages(const SharedTileset &tileset)
         return;
 
     if (tileset->isCollection()) {
-        for (Tile *tile : tileset->tiles())
-            tile->setImage(QPixmap(tile->imageSource()));
+        // The images are loaded again once they are used
+        for (Tile *tile : tileset->tiles()) {
+            const QString source = tile->imageSource();
+            if (source.isEmpty())
+                continue;
+
+            ImageCache::remove(source);
+            tileset->setDeferredTileImage(tile, source);
+        }
+
         emit tilesetImagesChanged(tileset.data());
     } else {
+        ImageCache::remove(tileset->imageSource());
         if (tileset->loadImage())
             emit tilesetImagesChanged(tileset.data());
     }
@@ -231,6 +246,8 @@ void TilesetManager::tilesetImageSourceChanged(const Tileset &tileset,
 
 void TilesetManager::fileChanged(const QString &path)
 {
+    ImageCache::remove(path);
+
     if (!mReloadTilesetsOnChange)
         return;
 
@@ -245,6 +262,10 @@ void TilesetManager::fileChanged(const QString &path)
 
 void TilesetManager::fileChangedTimeout()
 {
+    // Make sure the changed files are loaded again
+    for (const QString &fileName : mChangedFiles)
+        ImageCache::remove(fileName);
+
     QMapIterator<SharedTileset, int> it(mTilesets);
 
     while (it.hasNext()) {
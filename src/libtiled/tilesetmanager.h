@@ -41,6 +41,7 @@
 namespace Tiled {
 
 class FileSystemWatcher;
+class ImageDecoder;
 class TileAnimationDriver;
 
 /**
@@ -77,6 +78,12 @@ public:
     void tilesetImageSourceChanged(const Tileset &tileset,
                                    const QString &oldImageSource);
 
+    /**
+     * Returns the queue used for decoding images in the background. Sharing
+     * it makes sure that images used by several maps are decoded only once.
+     */
+    ImageDecoder *imageDecoder() const { return mImageDecoder; }
+
 signals:
     /**
      * Emitted when a tileset's images have changed and views need updating.
@@ -109,6 +116,7 @@ private:
     QMap<SharedTileset, int> mTilesets;
     FileSystemWatcher *mWatcher;
     TileAnimationDriver *mAnimationDriver;
+    ImageDecoder *mImageDecoder;
     QSet<QString> mChangedFiles;
     QTimer mChangedFilesTimer;
     bool mReloadTilesetsOnChange;
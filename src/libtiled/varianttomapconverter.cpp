@@ -33,6 +33,7 @@
 #include "tilesetmanager.h"
 
 #include <QScopedPointer>
+#include <QVector>
 
 namespace Tiled {
 
@@ -126,7 +127,7 @@ SharedTileset VariantToMapConverter::toTileset(const QVariant &variant,
     mReadingExternalTileset = true;
 
     SharedTileset tileset = toTileset(variant);
-    if (tileset && !tileset->imageSource().isEmpty())
+    if (tileset && mImageLoadingEnabled && !tileset->imageSource().isEmpty())
         tileset->loadImage();
 
     mReadingExternalTileset = false;
@@ -193,7 +194,7 @@ SharedTileset VariantToMapConverter::toTileset(const QVariant &variant)
     const QVariantMap grid = variantMap[QLatin1String("grid")].toMap();
     const int tileOffsetX = tileOffset[QLatin1String("x")].toInt();
     const int tileOffsetY = tileOffset[QLatin1String("y")].toInt();
-    const int columns = tileOffset[QLatin1String("columns")].toInt();
+    const int columns = variantMap[QLatin1String("columns")].toInt();
     const QString bgColor = variantMap[QLatin1String("backgroundcolor")].toString();
 
     if (tileWidth <= 0 || tileHeight <= 0 ||
@@ -282,8 +283,12 @@ SharedTileset VariantToMapConverter::toTileset(const QVariant &variant)
 
         imageVariant = tileVar[QLatin1String("image")];
         if (!imageVariant.isNull()) {
-            QString imagePath = resolvePath(mMapDir, imageVariant);
-            tileset->setTileImage(tile, QPixmap(imagePath), imagePath);
+            const QString imagePath = resolvePath(mMapDir, imageVariant);
+            const QSize imageSize(tileVar[QLatin1String("imagewidth")].toInt(),
+                                  tileVar[QLatin1String("imageheight")].toInt());
+
+            // Images of tiles are only loaded once they are used
+            tileset->setDeferredTileImage(tile, imagePath, imageSize);
         }
 
         QVariantMap objectGroupVariant = tileVar[QLatin1String("objectgroup")].toMap();
@@ -390,6 +395,25 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
     switch (layerDataFormat) {
     case Map::XML:
     case Map::CSV: {
+        if (dataVariant.userType() == qMetaTypeId<QVector<unsigned>>()) {
+            // Provided by readers that avoid creating a QVariant for each tile
+            const QVector<unsigned> gids = dataVariant.value<QVector<unsigned>>();
+
+            if (gids.size() != width * height) {
+                mError = tr("Corrupt layer data for layer '%1'").arg(name);
+                return nullptr;
+            }
+
+            const unsigned *gid = gids.constData();
+            bool ok;
+
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x)
+                    tileLayer->setCell(x, y, mGidMapper.gidToCell(*gid++, ok));
+
+            break;
+        }
+
         const QVariantList dataVariantList = dataVariant.toList();
 
         if (dataVariantList.size() != width * height) {
@@ -50,6 +50,7 @@ public:
     VariantToMapConverter()
         : mMap(nullptr)
         , mReadingExternalTileset(false)
+        , mImageLoadingEnabled(true)
     {}
 
     /**
@@ -71,6 +72,14 @@ public:
      */
     SharedTileset toTileset(const QVariant &variant, const QDir &directory);
 
+    /**
+     * Sets whether the image of a tileset read by toTileset() is loaded.
+     * When disabled, only the image reference is set up, and the image is
+     * left for the caller to load. The images of tiles in image collection
+     * tilesets are always loaded on first use.
+     */
+    void setImageLoadingEnabled(bool enabled) { mImageLoadingEnabled = enabled; }
+
     /**
      * Returns the last error, if any.
      */
@@ -94,6 +103,7 @@ private:
     Map *mMap;
     QDir mMapDir;
     bool mReadingExternalTileset;
+    bool mImageLoadingEnabled;
     GidMapper mGidMapper;
     QString mError;
 };
@@ -24,13 +24,151 @@
 #include "savefile.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tileset.h"
 
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
 
 using namespace Tiled;
 using namespace Csv;
 
+namespace {
+
+/**
+ * Returns the text written for the given tile: either its name, if given,
+ * or its ID.
+ */
+QByteArray tileToken(const Tile *tile)
+{
+    if (tile->hasProperty(QLatin1String("name")))
+        return tile->property(QLatin1String("name")).toString().toUtf8();
+
+    return QByteArray::number(tile->id());
+}
+
+/**
+ * The text written for each tile of the tilesets of a map, computed once
+ * before writing any layers.
+ */
+class TileTokens
+{
+public:
+    explicit TileTokens(const Map *map)
+        : mEmpty("-1")
+    {
+        for (const SharedTileset &tileset : map->tilesets()) {
+            QVector<QByteArray> &tokens = mTokens[tileset.data()];
+            tokens.resize(tileset->nextTileId());
+
+            for (const Tile *tile : tileset->tiles())
+                tokens[tile->id()] = tileToken(tile);
+        }
+    }
+
+    const QByteArray &empty() const { return mEmpty; }
+
+    /**
+     * Returns the tokens of the given \a tileset, indexed by tile ID, or
+     * null when the tileset is not part of the map.
+     */
+    const QVector<QByteArray> *tokens(const Tileset *tileset) const
+    {
+        auto it = mTokens.constFind(tileset);
+        return it != mTokens.constEnd() ? &it.value() : nullptr;
+    }
+
+private:
+    QHash<const Tileset*, QVector<QByteArray>> mTokens;
+    QByteArray mEmpty;
+};
+
+/**
+ * Writes a single tile layer to its own file.
+ */
+class LayerWriter : public QRunnable
+{
+public:
+    LayerWriter(const TileLayer *tileLayer,
+                const QString &fileName,
+                const TileTokens &tokens,
+                QString &error)
+        : mTileLayer(tileLayer)
+        , mFileName(fileName)
+        , mTokens(tokens)
+        , mError(error)
+    {}
+
+    void run() override;
+
+private:
+    const TileLayer *mTileLayer;
+    const QString mFileName;
+    const TileTokens &mTokens;
+    QString &mError;
+};
+
+void LayerWriter::run()
+{
+    SaveFile file(mFileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        mError = CsvPlugin::tr("Could not open file for writing.");
+        return;
+    }
+
+    auto device = file.device();
+
+    const Tileset *lastTileset = nullptr;
+    const QVector<QByteArray> *lastTokens = nullptr;
+
+    // Reserving makes sure the capacity is kept when clearing the row
+    QByteArray row;
+    row.reserve(mTileLayer->width() * 4);
+
+    // Write out tiles either by ID or their name, if given. -1 is "empty"
+    for (int y = 0; y < mTileLayer->height(); ++y) {
+        row.resize(0);
+
+        for (int x = 0; x < mTileLayer->width(); ++x) {
+            if (x > 0)
+                row.append(',');
+
+            const Tile *tile = mTileLayer->cellAt(x, y).tile();
+            if (!tile) {
+                row.append(mTokens.empty());
+                continue;
+            }
+
+            if (tile->tileset() != lastTileset) {
+                lastTileset = tile->tileset();
+                lastTokens = mTokens.tokens(lastTileset);
+            }
+
+            if (lastTokens && tile->id() < lastTokens->size())
+                row.append(lastTokens->at(tile->id()));
+            else
+                row.append(tileToken(tile));
+        }
+
+        row.append('\n');
+        device->write(row);
+    }
+
+    if (file.error() != QFileDevice::NoError) {
+        mError = file.errorString();
+        return;
+    }
+
+    if (!file.commit())
+        mError = file.errorString();
+}
+
+} // anonymous namespace
+
 CsvPlugin::CsvPlugin()
 {
 }
@@ -40,54 +178,38 @@ bool CsvPlugin::write(const Map *map, const QString &fileName)
     // Get file paths for each layer
     QStringList layerPaths = outputFiles(map, fileName);
 
+    const TileTokens tokens(map);
+
+    // Each tile layer is written to its own file, so they can be written in
+    // parallel
+    QVector<QString> errors(layerPaths.size());
+    QThreadPool threadPool;
+
     // Traverse all tile layers
-    uint currentLayer = 0u;
+    int currentLayer = 0;
     for (const Layer *layer : map->layers()) {
         if (layer->layerType() != Layer::TileLayerType)
             continue;
-            
+
         const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
 
-        SaveFile file(layerPaths.at(currentLayer));
+        threadPool.start(new LayerWriter(tileLayer,
+                                         layerPaths.at(currentLayer),
+                                         tokens,
+                                         errors[currentLayer]));
 
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            mError = tr("Could not open file for writing.");
-            return false;
-        }
+        ++currentLayer;
+    }
 
-        auto device = file.device();
-
-        // Write out tiles either by ID or their name, if given. -1 is "empty"
-        for (int y = 0; y < tileLayer->height(); ++y) {
-            for (int x = 0; x < tileLayer->width(); ++x) {
-                if (x > 0)
-                    device->write(",", 1);
-    
-                const Cell &cell = tileLayer->cellAt(x, y);
-                const Tile *tile = cell.tile();
-                if (tile && tile->hasProperty(QLatin1String("name"))) {
-                    device->write(tile->property(QLatin1String("name")).toString().toUtf8());
-                } else {
-                    const int id = tile ? tile->id() : -1;
-                    device->write(QByteArray::number(id));
-                }
-            }
-    
-            device->write("\n", 1);
-        }
-    
-        if (file.error() != QFileDevice::NoError) {
-            mError = file.errorString();
-            return false;
-        }
+    threadPool.waitForDone();
 
-        if (!file.commit()) {
-            mError = file.errorString();
+    for (const QString &error : errors) {
+        if (!error.isEmpty()) {
+            mError = error;
             return false;
         }
-
-        ++currentLayer;
     }
+
     return true;
 }
 
@@ -35,6 +35,7 @@ public:
     CsvPlugin();
 
     bool write(const Tiled::Map *map, const QString &fileName) override;
+    Tiled::MapFormat *clone() const override { return new CsvPlugin; }
     QString errorString() const override;
     QStringList outputFiles(const Tiled::Map *map, const QString &fileName) const override;
 
@@ -3,8 +3,12 @@ include(../plugin.pri)
 DEFINES += JSON_LIBRARY
 
 SOURCES += jsonplugin.cpp \
+    jsonstreamreader.cpp \
+    jsonstreamwriter.cpp \
     qjsonparser/json.cpp
 
 HEADERS += jsonplugin.h \
     json_global.h \
+    jsonstreamreader.h \
+    jsonstreamwriter.h \
     qjsonparser/json.h
@@ -21,6 +21,8 @@
 
 #include "jsonplugin.h"
 
+#include "jsonstreamreader.h"
+#include "jsonstreamwriter.h"
 #include "maptovariantconverter.h"
 #include "varianttomapconverter.h"
 #include "savefile.h"
@@ -31,7 +33,6 @@
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QTextStream>
 
 namespace Json {
 
@@ -56,7 +57,7 @@ Tiled::Map *JsonMapFormat::read(const QString &fileName)
         return nullptr;
     }
 
-    JsonReader reader;
+    JsonStreamReader reader;
     QByteArray contents = file.readAll();
     if (mSubFormat == JavaScript && contents.size() > 0 && contents[0] != '{') {
         // Scan past JSONP prefix; look for an open curly at the start of the line
@@ -96,38 +97,39 @@ bool JsonMapFormat::write(const Tiled::Map *map, const QString &fileName)
     }
 
     Tiled::MapToVariantConverter converter;
+    converter.setTileDataAsVector(true);
     QVariant variant = converter.toVariant(*map, QFileInfo(fileName).dir());
 
-    JsonWriter writer;
+    JsonStreamWriter writer(file.device());
     writer.setAutoFormatting(true);
 
-    if (!writer.stringify(variant)) {
-        // This can only happen due to coding error
-        mError = writer.errorString();
-        return false;
-    }
-
-    QTextStream out(file.device());
     if (mSubFormat == JavaScript) {
         // Trim and escape name
         JsonWriter nameWriter;
         QString baseName = QFileInfo(fileName).baseName();
         nameWriter.stringify(baseName);
-        out << "(function(name,data){\n if(typeof onTileMapLoaded === 'undefined') {\n";
-        out << "  if(typeof TileMaps === 'undefined') TileMaps = {};\n";
-        out << "  TileMaps[name] = data;\n";
-        out << " } else {\n";
-        out << "  onTileMapLoaded(name,data);\n";
-        out << " }\n";
-        out << " if(typeof module === 'object' && module && module.exports) {\n";
-        out << "  module.exports = data;\n";
-        out << " }})(" << nameWriter.result() << ",\n";
+        writer.writeRaw("(function(name,data){\n if(typeof onTileMapLoaded === 'undefined') {\n"
+                        "  if(typeof TileMaps === 'undefined') TileMaps = {};\n"
+                        "  TileMaps[name] = data;\n"
+                        " } else {\n"
+                        "  onTileMapLoaded(name,data);\n"
+                        " }\n"
+                        " if(typeof module === 'object' && module && module.exports) {\n"
+                        "  module.exports = data;\n"
+                        " }})(");
+        writer.writeRaw(nameWriter.result().toLatin1());
+        writer.writeRaw(",\n");
     }
-    out << writer.result();
-    if (mSubFormat == JavaScript) {
-        out << ");";
+
+    if (!writer.write(variant)) {
+        // This can only happen due to coding error
+        mError = writer.errorString();
+        return false;
     }
-    out.flush();
+
+    if (mSubFormat == JavaScript)
+        writer.writeRaw(");");
+    writer.flush();
 
     if (file.error() != QFileDevice::NoError) {
         mError = tr("Error while writing file:\n%1").arg(file.errorString());
@@ -217,7 +219,7 @@ Tiled::SharedTileset JsonTilesetFormat::read(const QString &fileName)
         return Tiled::SharedTileset();
     }
 
-    JsonReader reader;
+    JsonStreamReader reader;
     QByteArray contents = file.readAll();
 
     reader.parse(contents);
@@ -277,18 +279,16 @@ bool JsonTilesetFormat::write(const Tiled::Tileset &tileset,
     Tiled::MapToVariantConverter converter;
     QVariant variant = converter.toVariant(tileset, QFileInfo(fileName).dir());
 
-    JsonWriter writer;
+    JsonStreamWriter writer(file.device());
     writer.setAutoFormatting(true);
 
-    if (!writer.stringify(variant)) {
+    if (!writer.write(variant)) {
         // This can only happen due to coding error
         mError = writer.errorString();
         return false;
     }
 
-    QTextStream out(file.device());
-    out << writer.result();
-    out.flush();
+    writer.flush();
 
     if (file.error() != QFileDevice::NoError) {
         mError = tr("Error while writing file:\n%1").arg(file.errorString());
@@ -63,6 +63,7 @@ public:
     bool supportsFile(const QString &fileName) const override;
 
     bool write(const Tiled::Map *map, const QString &fileName) override;
+    Tiled::MapFormat *clone() const override { return new JsonMapFormat(mSubFormat); }
 
     QString nameFilter() const override;
     QString shortName() const override;
@@ -0,0 +1,431 @@
+/*
+ * jsonstreamreader.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "jsonstreamreader.h"
+
+#include "qjsonparser/json.h"
+
+#include <QVector>
+
+using namespace Json;
+
+static const int MaximumDepth = 1024;
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+JsonStreamReader::JsonStreamReader()
+    : mBegin(nullptr)
+    , mPos(nullptr)
+    , mEnd(nullptr)
+    , mDepth(0)
+    , mErrorOffset(-1)
+{
+}
+
+bool JsonStreamReader::parse(const QByteArray &data)
+{
+    mResult.clear();
+    mErrorOffset = -1;
+    mDepth = 0;
+
+    const uchar *bytes = reinterpret_cast<const uchar*>(data.constData());
+    const int size = data.size();
+
+    // Leave UTF-16 and UTF-32 to JsonReader, detected the same way it does
+    const bool utf16Or32Bom = size > 1 && ((bytes[0] == 0xfe && bytes[1] == 0xff) ||
+                                           (bytes[0] == 0xff && bytes[1] == 0xfe) ||
+                                           (bytes[0] == 0 && bytes[1] == 0));
+    const bool nullBytes = size > 3 && (bytes[0] == 0 || bytes[1] == 0);
+
+    if (utf16Or32Bom || nullBytes) {
+        JsonReader reader;
+        reader.parse(data);
+        mResult = reader.result();
+        if (!mResult.isValid())
+            mErrorOffset = 0;
+        return mResult.isValid();
+    }
+
+    mBegin = data.constData();
+    mPos = mBegin;
+    mEnd = mBegin + size;
+
+    // Skip UTF-8 byte order mark
+    if (size > 2 && bytes[0] == 0xef && bytes[1] == 0xbb && bytes[2] == 0xbf)
+        mPos += 3;
+
+    QVariant value;
+    skipWhitespace();
+    bool ok = parseValue(value);
+    if (ok) {
+        skipWhitespace();
+        ok = mPos == mEnd;
+    }
+
+    if (!ok) {
+        mErrorOffset = int(mPos - mBegin);
+        return false;
+    }
+
+    mResult = value;
+    return true;
+}
+
+bool JsonStreamReader::parseValue(QVariant &value)
+{
+    if (mPos == mEnd)
+        return false;
+
+    switch (*mPos) {
+    case '{':
+        return parseObject(value);
+    case '[':
+        return parseArray(value);
+    case '"': {
+        QString string;
+        if (!parseString(string))
+            return false;
+        value = string;
+        return true;
+    }
+    case 't':
+        value = true;
+        return parseLiteral("true", 4);
+    case 'f':
+        value = false;
+        return parseLiteral("false", 5);
+    case 'n':
+        value = QVariant();
+        return parseLiteral("null", 4);
+    default:
+        if (*mPos == '-' || *mPos == '+' || isDigit(*mPos))
+            return parseNumber(value);
+        return false;
+    }
+}
+
+bool JsonStreamReader::parseObject(QVariant &value)
+{
+    if (++mDepth > MaximumDepth)
+        return false;
+
+    ++mPos; // skip {
+    skipWhitespace();
+
+    QVariantMap map;
+
+    if (mPos < mEnd && *mPos == '}') {
+        ++mPos;
+        --mDepth;
+        value = map;
+        return true;
+    }
+
+    QString key;
+    while (true) {
+        if (mPos == mEnd || *mPos != '"' || !parseString(key))
+            return false;
+
+        skipWhitespace();
+        if (mPos == mEnd || *mPos != ':')
+            return false;
+        ++mPos;
+        skipWhitespace();
+
+        QVariant member;
+        if (mPos < mEnd && *mPos == '[' && key == QLatin1String("data")) {
+            if (!parseTileData(member) && !parseArray(member))
+                return false;
+        } else if (!parseValue(member)) {
+            return false;
+        }
+
+        map.insert(key, member);
+
+        skipWhitespace();
+        if (mPos == mEnd)
+            return false;
+        if (*mPos == '}')
+            break;
+        if (*mPos != ',')
+            return false;
+        ++mPos;
+        skipWhitespace();
+    }
+
+    ++mPos; // skip }
+    --mDepth;
+    value = map;
+    return true;
+}
+
+bool JsonStreamReader::parseArray(QVariant &value)
+{
+    if (++mDepth > MaximumDepth)
+        return false;
+
+    ++mPos; // skip [
+    skipWhitespace();
+
+    QVariantList list;
+
+    if (mPos < mEnd && *mPos == ']') {
+        ++mPos;
+        --mDepth;
+        value = list;
+        return true;
+    }
+
+    while (true) {
+        QVariant element;
+        if (!parseValue(element))
+            return false;
+
+        list.append(element);
+
+        skipWhitespace();
+        if (mPos == mEnd)
+            return false;
+        if (*mPos == ']')
+            break;
+        if (*mPos != ',')
+            return false;
+        ++mPos;
+        skipWhitespace();
+    }
+
+    ++mPos; // skip ]
+    --mDepth;
+    value = list;
+    return true;
+}
+
+/**
+ * Reads an array of unsigned integers into a QVector<unsigned>, without
+ * creating a QVariant for each element.
+ *
+ * When the array contains anything else, the position is restored and false
+ * is returned, so that the array can be read by parseArray instead.
+ */
+bool JsonStreamReader::parseTileData(QVariant &value)
+{
+    const char * const start = mPos;
+
+    ++mPos; // skip [
+    skipWhitespace();
+
+    QVector<unsigned> gids;
+
+    if (mPos < mEnd && *mPos == ']') {
+        ++mPos;
+        value = QVariant::fromValue(gids);
+        return true;
+    }
+
+    while (true) {
+        if (mPos == mEnd || !isDigit(*mPos))
+            break;
+
+        quint64 gid = 0;
+        do {
+            gid = gid * 10 + unsigned(*mPos - '0');
+            ++mPos;
+        } while (mPos < mEnd && isDigit(*mPos) && gid <= 0xffffffffu);
+
+        if (gid > 0xffffffffu)
+            break;
+
+        gids.append(unsigned(gid));
+
+        skipWhitespace();
+        if (mPos == mEnd)
+            break;
+        if (*mPos == ']') {
+            ++mPos;
+            value = QVariant::fromValue(gids);
+            return true;
+        }
+        if (*mPos != ',')
+            break;
+        ++mPos;
+        skipWhitespace();
+    }
+
+    mPos = start;
+    return false;
+}
+
+bool JsonStreamReader::parseString(QString &string)
+{
+    ++mPos; // skip "
+
+    // Fast path for strings without escape sequences
+    const char *start = mPos;
+    while (mPos < mEnd && *mPos != '"' && *mPos != '\\')
+        ++mPos;
+
+    if (mPos == mEnd)
+        return false;
+
+    string = QString::fromUtf8(start, int(mPos - start));
+
+    if (*mPos == '"') {
+        ++mPos;
+        return true;
+    }
+
+    while (mPos < mEnd) {
+        const char c = *mPos;
+
+        if (c == '"') {
+            ++mPos;
+            return true;
+        }
+
+        if (c != '\\') {
+            start = mPos;
+            while (mPos < mEnd && *mPos != '"' && *mPos != '\\')
+                ++mPos;
+            string += QString::fromUtf8(start, int(mPos - start));
+            continue;
+        }
+
+        if (++mPos == mEnd)
+            return false;
+
+        switch (*mPos) {
+        case 'b': string += QLatin1Char('\b'); break;
+        case 'f': string += QLatin1Char('\f'); break;
+        case 'n': string += QLatin1Char('\n'); break;
+        case 'r': string += QLatin1Char('\r'); break;
+        case 't': string += QLatin1Char('\t'); break;
+        case 'u': {
+            if (mEnd - mPos < 5)
+                return false;
+            ushort unicode = 0;
+            for (int i = 1; i <= 4; ++i) {
+                const int digit = hexValue(mPos[i]);
+                if (digit < 0)
+                    return false;
+                unicode = ushort(unicode * 16 + digit);
+            }
+            string += QChar(unicode);
+            mPos += 4;
+            break;
+        }
+        default:
+            // Includes \\, \" and \/
+            string += QLatin1Char(*mPos);
+            break;
+        }
+
+        ++mPos;
+    }
+
+    return false;
+}
+
+/**
+ * Follows the number parsing of JsonReader, which means integers are read as
+ * qlonglong while numbers containing a '.', 'e' or 'E' are read as double.
+ */
+bool JsonStreamReader::parseNumber(QVariant &value)
+{
+    const char *start = mPos;
+    bool isDouble = false;
+    qlonglong integer = 0;
+    qlonglong sign = 1;
+
+    if (*mPos == '-' || *mPos == '+') {
+        if (*mPos == '-')
+            sign = -1;
+        ++mPos;
+    }
+
+    for (; mPos < mEnd; ++mPos) {
+        const char c = *mPos;
+        if (c == '+' || c == '-')
+            continue;
+        if (c == '.' || c == 'e' || c == 'E') {
+            isDouble = true;
+            continue;
+        }
+        if (isDigit(c)) {
+            if (!isDouble)
+                integer = integer * 10 + (c - '0');
+            continue;
+        }
+        break;
+    }
+
+    if (isDouble) {
+        const QByteArray number = QByteArray::fromRawData(start, int(mPos - start));
+        value = number.toDouble();
+    } else {
+        value = integer * sign;
+    }
+
+    return true;
+}
+
+bool JsonStreamReader::parseLiteral(const char *literal, int length)
+{
+    if (mEnd - mPos < length || qstrncmp(mPos, literal, uint(length)) != 0)
+        return false;
+
+    mPos += length;
+
+    // Like JsonReader, reject literals directly followed by more letters
+    if (mPos < mEnd && *mPos >= 'a' && *mPos <= 'z')
+        return false;
+
+    return true;
+}
+
+void JsonStreamReader::skipWhitespace()
+{
+    while (mPos < mEnd) {
+        switch (*mPos) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+            ++mPos;
+            break;
+        default:
+            return;
+        }
+    }
+}
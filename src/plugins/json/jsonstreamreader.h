@@ -0,0 +1,77 @@
+/*
+ * jsonstreamreader.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+namespace Json {
+
+/**
+ * Reads JSON from UTF-8 encoded data in a single pass, producing the same
+ * QVariant tree as JsonReader.
+ *
+ * Arrays stored under a "data" key which contain only unsigned integers,
+ * like the tile layer data of a map, are read straight into a
+ * QVector<unsigned> instead of a QVariantList. This avoids creating a
+ * QVariant for each tile, and is understood by
+ * VariantToMapConverter::toTileLayer.
+ *
+ * Data in other encodings is passed on to JsonReader.
+ */
+class JsonStreamReader
+{
+public:
+    JsonStreamReader();
+
+    /**
+     * Parses the given \a data. Returns false when it is not valid JSON.
+     */
+    bool parse(const QByteArray &data);
+
+    QVariant result() const { return mResult; }
+
+    /**
+     * Returns the offset in the data at which parsing failed.
+     */
+    int errorOffset() const { return mErrorOffset; }
+
+private:
+    bool parseValue(QVariant &value);
+    bool parseObject(QVariant &value);
+    bool parseArray(QVariant &value);
+    bool parseTileData(QVariant &value);
+    bool parseString(QString &string);
+    bool parseNumber(QVariant &value);
+    bool parseLiteral(const char *literal, int length);
+    void skipWhitespace();
+
+    const char *mBegin;
+    const char *mPos;
+    const char *mEnd;
+    int mDepth;
+    int mErrorOffset;
+    QVariant mResult;
+};
+
+} // namespace Json
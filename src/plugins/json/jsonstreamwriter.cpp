@@ -0,0 +1,262 @@
+/*
+ * jsonstreamwriter.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "jsonstreamwriter.h"
+
+#include <QDebug>
+#include <QIODevice>
+#include <QVector>
+
+#include <qnumeric.h>
+
+using namespace Json;
+
+static const int BufferSize = 64 * 1024;
+static const int IndentSize = 4;
+
+JsonStreamWriter::JsonStreamWriter(QIODevice *device)
+    : mDevice(device)
+    , mAutoFormatting(false)
+{
+    mBuffer.reserve(BufferSize);
+}
+
+JsonStreamWriter::~JsonStreamWriter()
+{
+    flush();
+}
+
+void JsonStreamWriter::setAutoFormatting(bool autoFormatting)
+{
+    mAutoFormatting = autoFormatting;
+}
+
+bool JsonStreamWriter::write(const QVariant &variant)
+{
+    mError.clear();
+    write(variant, 0);
+    return mError.isEmpty();
+}
+
+void JsonStreamWriter::writeRaw(const QByteArray &data)
+{
+    append(data);
+}
+
+void JsonStreamWriter::flush()
+{
+    if (mBuffer.isEmpty())
+        return;
+
+    mDevice->write(mBuffer);
+    mBuffer.resize(0);
+}
+
+/**
+ * Follows JsonWriter::stringify exactly, so that the output is the same.
+ */
+void JsonStreamWriter::write(const QVariant &variant, int depth)
+{
+    static const int tileDataType = qMetaTypeId<QVector<unsigned>>();
+
+    const int type = variant.userType();
+
+    if (type == tileDataType) {
+        writeTileData(variant.value<QVector<unsigned>>());
+    } else if (type == QMetaType::QVariantList || type == QMetaType::QStringList) {
+        append('[');
+        const QVariantList list = variant.toList();
+        for (int i = 0; i < list.count(); ++i) {
+            if (i != 0) {
+                append(',');
+                if (mAutoFormatting)
+                    append(' ');
+            }
+            write(list.at(i), depth + 1);
+        }
+        append(']');
+    } else if (type == QMetaType::QVariantMap) {
+        const QVariantMap map = variant.toMap();
+        if (mAutoFormatting && depth != 0) {
+            append('\n');
+            writeIndent(depth);
+            append("{\n", 2);
+        } else {
+            append('{');
+        }
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            if (it != map.constBegin()) {
+                append(',');
+                if (mAutoFormatting)
+                    append('\n');
+            }
+            if (mAutoFormatting) {
+                writeIndent(depth);
+                append(' ');
+            }
+            writeString(it.key());
+            append(':');
+            write(it.value(), depth + 1);
+        }
+        if (mAutoFormatting) {
+            append('\n');
+            writeIndent(depth);
+        }
+        append('}');
+    } else if (type == QMetaType::QString || type == QMetaType::QByteArray) {
+        writeString(variant.toString());
+    } else if (type == QMetaType::Double || type == QMetaType::Float) {
+        const double d = variant.toDouble();
+        if (qIsFinite(d))
+            append(QString::number(d, 'g', 15).toLatin1());
+        else
+            append("null", 4);
+    } else if (type == QMetaType::Bool) {
+        if (variant.toBool())
+            append("true", 4);
+        else
+            append("false", 5);
+    } else if (type == QMetaType::UnknownType) {
+        append("null", 4);
+    } else if (type == QMetaType::ULongLong) {
+        append(QByteArray::number(variant.toULongLong()));
+    } else if (type == QMetaType::LongLong) {
+        append(QByteArray::number(variant.toLongLong()));
+    } else if (type == QMetaType::Int) {
+        append(QByteArray::number(variant.toInt()));
+    } else if (type == QMetaType::UInt) {
+        append(QByteArray::number(variant.toUInt()));
+    } else if (type == QMetaType::QChar) {
+        // Unlike strings, characters below 128 are not escaped
+        const QChar c = variant.toChar();
+        append('"');
+        if (c.unicode() > 127)
+            writeEscapedChar(c.unicode());
+        else
+            append(char(c.unicode()));
+        append('"');
+    } else if (variant.canConvert<qlonglong>()) {
+        append(QByteArray::number(variant.toLongLong()));
+    } else if (variant.canConvert<QString>()) {
+        writeString(variant.toString());
+    } else {
+        if (!mError.isEmpty())
+            mError.append(QLatin1Char('\n'));
+        QString msg = QString::fromLatin1("Unsupported type %1 (id: %2)")
+                .arg(QString::fromUtf8(variant.typeName())).arg(type);
+        mError.append(msg);
+        qWarning() << "JsonStreamWriter::write - " << msg;
+        append("null", 4);
+    }
+}
+
+/**
+ * Writes a quoted string, escaped the same way as JsonWriter does.
+ */
+void JsonStreamWriter::writeString(const QString &string)
+{
+    append('"');
+
+    for (const QChar c : string) {
+        const ushort u = c.unicode();
+        switch (u) {
+        case '\b': append("\\b", 2); break;
+        case '\f': append("\\f", 2); break;
+        case '\n': append("\\n", 2); break;
+        case '\r': append("\\r", 2); break;
+        case '\t': append("\\t", 2); break;
+        case '"':  append("\\\"", 2); break;
+        case '\\': append("\\\\", 2); break;
+        case '/':  append("\\/", 2); break;
+        default:
+            if (u > 127) {
+                writeEscapedChar(u);
+            } else {
+                append(char(u));
+            }
+        }
+    }
+
+    append('"');
+}
+
+void JsonStreamWriter::writeEscapedChar(ushort unicode)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    const char escaped[] = {
+        '\\', 'u',
+        hexDigits[(unicode >> 12) & 0xf],
+        hexDigits[(unicode >> 8) & 0xf],
+        hexDigits[(unicode >> 4) & 0xf],
+        hexDigits[unicode & 0xf]
+    };
+    append(escaped, 6);
+}
+
+/**
+ * Writes the global tile IDs as an array of numbers, formatting them
+ * directly into the buffer.
+ */
+void JsonStreamWriter::writeTileData(const QVector<unsigned> &gids)
+{
+    const char *separator = mAutoFormatting ? ", " : ",";
+    const int separatorSize = mAutoFormatting ? 2 : 1;
+
+    append('[');
+
+    for (int i = 0; i < gids.size(); ++i) {
+        if (i != 0)
+            append(separator, separatorSize);
+
+        char digits[10];
+        char *end = digits + sizeof(digits);
+        char *begin = end;
+        unsigned gid = gids.at(i);
+        do {
+            *--begin = char('0' + gid % 10);
+            gid /= 10;
+        } while (gid);
+
+        append(begin, int(end - begin));
+    }
+
+    append(']');
+}
+
+void JsonStreamWriter::writeIndent(int depth)
+{
+    for (int i = depth * IndentSize; i > 0; --i)
+        append(' ');
+}
+
+inline void JsonStreamWriter::append(char c)
+{
+    mBuffer.append(c);
+    if (mBuffer.size() >= BufferSize)
+        flush();
+}
+
+inline void JsonStreamWriter::append(const char *data, int size)
+{
+    mBuffer.append(data, size);
+    if (mBuffer.size() >= BufferSize)
+        flush();
+}
@@ -0,0 +1,81 @@
+/*
+ * jsonstreamwriter.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+class QIODevice;
+
+namespace Json {
+
+/**
+ * Writes a QVariant tree as JSON directly to a device. The output is the
+ * same as that of JsonWriter, but it is written through a small buffer
+ * instead of being collected in a string first.
+ *
+ * Tile layer data stored as a QVector<unsigned> (see
+ * MapToVariantConverter::setTileDataAsVector) is written directly, so that
+ * there is no need to create a QVariant for each tile.
+ */
+class JsonStreamWriter
+{
+public:
+    explicit JsonStreamWriter(QIODevice *device);
+    ~JsonStreamWriter();
+
+    void setAutoFormatting(bool autoFormatting);
+
+    /**
+     * Writes the given \a variant. Returns false when it contained values
+     * that could not be converted to JSON, which were written as null.
+     */
+    bool write(const QVariant &variant);
+
+    /**
+     * Writes \a data as-is, for example to wrap the JSON in some code.
+     */
+    void writeRaw(const QByteArray &data);
+
+    void flush();
+
+    QString errorString() const { return mError; }
+
+private:
+    void write(const QVariant &variant, int depth);
+    void writeString(const QString &string);
+    void writeEscapedChar(ushort unicode);
+    void writeTileData(const QVector<unsigned> &gids);
+    void writeIndent(int depth);
+
+    void append(char c);
+    void append(const char *data, int size);
+    void append(const QByteArray &data) { append(data.constData(), data.size()); }
+
+    QIODevice *mDevice;
+    QByteArray mBuffer;
+    bool mAutoFormatting;
+    QString mError;
+};
+
+} // namespace Json
@@ -35,6 +35,7 @@
 
 #include <QFile>
 #include <QCoreApplication>
+#include <QVector>
 
 /**
  * See below for an explanation of the different formats. One of these needs
@@ -380,12 +381,18 @@ void LuaPlugin::writeTileLayer(LuaTableWriter &writer,
     case Map::CSV:
         writer.writeKeyAndValue("encoding", "lua");
         writer.writeStartTable("data");
-        for (int y = 0; y < tileLayer->height(); ++y) {
-            if (y > 0)
-                writer.prepareNewLine();
+        {
+            QVector<unsigned> row(tileLayer->width());
 
-            for (int x = 0; x < tileLayer->width(); ++x)
-                writer.writeValue(mGidMapper.cellToGid(tileLayer->cellAt(x, y)));
+            for (int y = 0; y < tileLayer->height(); ++y) {
+                if (y > 0)
+                    writer.prepareNewLine();
+
+                for (int x = 0; x < tileLayer->width(); ++x)
+                    row[x] = mGidMapper.cellToGid(tileLayer->cellAt(x, y));
+
+                writer.writeValues(row.constData(), row.size());
+            }
         }
         writer.writeEndTable();
         break;
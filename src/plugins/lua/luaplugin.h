@@ -54,6 +54,7 @@ public:
     LuaPlugin();
 
     bool write(const Tiled::Map *map, const QString &fileName) override;
+    Tiled::MapFormat *clone() const override { return new LuaPlugin; }
     QString nameFilter() const override;
     QString shortName() const override;
     QString errorString() const override;
@@ -102,6 +102,46 @@ void LuaTableWriter::writeUnquotedValue(const QByteArray &value)
     m_valueWritten = true;
 }
 
+/**
+ * Writes the given \a values, with the same result as calling writeValue for
+ * each of them. The values are formatted into a single buffer, which is
+ * written to the device in one go.
+ */
+void LuaTableWriter::writeValues(const unsigned *values, int count)
+{
+    if (count <= 0)
+        return;
+
+    prepareNewValue();
+
+    // Up to 10 digits for each value, plus the separator
+    m_buffer.resize(count * 12);
+
+    char *out = m_buffer.data();
+    char digits[10];
+
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+            *out++ = m_valueSeparator;
+            *out++ = ' ';
+        }
+
+        unsigned value = values[i];
+        int length = 0;
+        do {
+            digits[length++] = char('0' + value % 10);
+            value /= 10;
+        } while (value);
+
+        while (length)
+            *out++ = digits[--length];
+    }
+
+    write(m_buffer.constData(), unsigned(out - m_buffer.constData()));
+    m_newLine = false;
+    m_valueWritten = true;
+}
+
 void LuaTableWriter::writeKeyAndValue(const QByteArray &key,
                                       const char *value)
 {
@@ -48,6 +48,7 @@ public:
     void writeValue(unsigned value);
     void writeValue(const QByteArray &value);
     void writeValue(const QString &value);
+    void writeValues(const unsigned *values, int count);
 
     void writeUnquotedValue(const QByteArray &value);
 
@@ -83,6 +84,7 @@ private:
     void write(char c);
 
     QIODevice *m_device;
+    QByteArray m_buffer;
     int m_indent;
     char m_valueSeparator;
     bool m_suppressNewlines;
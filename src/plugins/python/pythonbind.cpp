@@ -89,6 +89,7 @@ typedef enum _PyBindGenWrapperFlags {
 #include "tilelayer.h"
 #include "objectgroup.h"
 #include "tileset.h"
+#include "gidmapper.h"
 #include <QImage>
 #include <QFileDialog>
 #include <QWidget>
@@ -2422,6 +2423,182 @@ bool loadTilesetFromFile(Tiled::Tileset *ts, QString file)
     return ts->loadFromImage(img, file);
 }
 
+/*
+ * Bulk access to the global tile IDs of a tile layer, to avoid crossing
+ * into Python for each cell. The GIDs are stored row by row as native
+ * unsigned 32-bit integers, which can be wrapped using array.array('I') or
+ * numpy.frombuffer(gids, numpy.uint32).
+ */
+static bool checkTileLayerRect(Tiled::TileLayer *layer, int x, int y,
+                               int &width, int &height)
+{
+    if (!layer->map()) {
+        PyErr_SetString(PyExc_RuntimeError, "layer is not part of a map");
+        return false;
+    }
+
+    // Written to avoid overflowing for large arguments
+    const bool validPosition = x >= 0 && y >= 0 &&
+            x <= layer->width() && y <= layer->height();
+
+    if (validPosition) {
+        if (width < 0)
+            width = layer->width() - x;
+        if (height < 0)
+            height = layer->height() - y;
+    }
+
+    if (!validPosition || width < 0 || height < 0 ||
+            width > layer->width() - x || height > layer->height() - y) {
+        PyErr_SetString(PyExc_IndexError, "rectangle is outside of the layer");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Provides read access to the contents of a buffer object. The array.array
+ * of Python 2 only supports the old buffer protocol, which is used as a
+ * fallback there.
+ */
+class ReadBuffer
+{
+public:
+    ReadBuffer() : mData(NULL), mLength(0), mHasView(false) {}
+    ~ReadBuffer() { if (mHasView) PyBuffer_Release(&mView); }
+
+    bool acquire(PyObject *object)
+    {
+        if (PyObject_GetBuffer(object, &mView, PyBUF_SIMPLE) == 0) {
+            mHasView = true;
+            mData = mView.buf;
+            mLength = mView.len;
+            return true;
+        }
+#if PY_VERSION_HEX < 0x03000000
+        if (PyObject_CheckReadBuffer(object)) {
+            PyErr_Clear();
+            return PyObject_AsReadBuffer(object, &mData, &mLength) == 0;
+        }
+#endif
+        return false;
+    }
+
+    const char *data() const { return static_cast<const char*>(mData); }
+    Py_ssize_t length() const { return mLength; }
+
+private:
+    Py_buffer mView;
+    const void *mData;
+    Py_ssize_t mLength;
+    bool mHasView;
+};
+
+PyObject* tileLayerGids(Tiled::TileLayer *layer, int x, int y,
+                        int width, int height)
+{
+    if (!checkTileLayerRect(layer, x, y, width, height))
+        return NULL;
+
+    const Tiled::GidMapper gidMapper(layer->map()->tilesets());
+    const Py_ssize_t size = Py_ssize_t(width) * height * sizeof(quint32);
+
+    PyObject *gids = PyByteArray_FromStringAndSize(NULL, size);
+    if (!gids)
+        return NULL;
+
+    quint32 *out = reinterpret_cast<quint32*>(PyByteArray_AS_STRING(gids));
+    for (int j = y; j < y + height; ++j)
+        for (int i = x; i < x + width; ++i)
+            *out++ = gidMapper.cellToGid(layer->cellAt(i, j));
+
+    return gids;
+}
+
+PyObject* setTileLayerGids(Tiled::TileLayer *layer, PyObject *gids,
+                           int x, int y, int width, int height)
+{
+    if (!checkTileLayerRect(layer, x, y, width, height))
+        return NULL;
+
+    ReadBuffer buffer;
+    if (!buffer.acquire(gids))
+        return NULL;
+
+    if (buffer.length() != Py_ssize_t(width) * height * Py_ssize_t(sizeof(quint32))) {
+        PyErr_SetString(PyExc_ValueError, "size of the buffer does not match the rectangle");
+        return NULL;
+    }
+
+    // Check all GIDs before changing the layer
+    const Tiled::GidMapper gidMapper(layer->map()->tilesets());
+    const char *in = buffer.data();
+    QVector<Tiled::Cell> cells(width * height);
+
+    for (int index = 0; index < cells.size(); ++index) {
+        quint32 gid;
+        memcpy(&gid, in + index * sizeof(quint32), sizeof(quint32));
+
+        bool ok;
+        cells[index] = gidMapper.gidToCell(gid, ok);
+        if (!ok) {
+            PyErr_Format(PyExc_ValueError, "invalid tile GID %u at (%d, %d)", gid,
+                         x + index % width, y + index / width);
+            return NULL;
+        }
+    }
+
+    const Tiled::Cell *cell = cells.constData();
+    for (int j = y; j < y + height; ++j)
+        for (int i = x; i < x + width; ++i)
+            layer->setCell(i, j, *cell++);
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject* variantToPython(const QVariant &variant)
+{
+    const QVariant value = Tiled::toExportValue(variant);
+
+    switch (value.type()) {
+    case QVariant::Bool:
+        return PyBool_FromLong(value.toBool());
+    case QVariant::Int:
+    case QVariant::LongLong:
+        return PyLong_FromLongLong(value.toLongLong());
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+        return PyLong_FromUnsignedLongLong(value.toULongLong());
+    case QVariant::Double:
+        return PyFloat_FromDouble(value.toDouble());
+    default:
+        return Py_BuildValue((char *) "s", value.toString().toUtf8().data());
+    }
+}
+
+PyObject* propertiesAsDict(Tiled::Object *object)
+{
+    PyObject *dict = PyDict_New();
+    if (!dict)
+        return NULL;
+
+    const Tiled::Properties &properties = object->properties();
+    Tiled::Properties::const_iterator it = properties.constBegin();
+    for (; it != properties.constEnd(); ++it) {
+        PyObject *value = variantToPython(it.value());
+        if (!value || PyDict_SetItemString(dict, it.key().toUtf8().data(), value) != 0) {
+            Py_XDECREF(value);
+            Py_DECREF(dict);
+            return NULL;
+        }
+        Py_DECREF(value);
+    }
+
+    return dict;
+}
+
 #if PY_VERSION_HEX >= 0x03000000
 static struct PyModuleDef qt_moduledef = {
     PyModuleDef_HEAD_INIT,
@@ -6291,12 +6468,84 @@ _wrap_tiled_tileLayerAt(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyOb
 }
 PyObject * _wrap_tiled_tileLayerAt(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs);
 
+
+PyObject *
+_wrap_tiled_tileLayerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs)
+{
+    PyObject *py_retval;
+    PyObject *retval;
+    PyTiledTileLayer *layer;
+    Tiled::TileLayer *layer_ptr;
+    int x = 0;
+    int y = 0;
+    int width = -1;
+    int height = -1;
+    const char *keywords[] = {"layer", "x", "y", "width", "height", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O!|iiii", (char **) keywords, &PyTiledTileLayer_Type, &layer, &x, &y, &width, &height)) {
+        return NULL;
+    }
+    layer_ptr = (layer ? layer->obj : NULL);
+    retval = tileLayerGids(layer_ptr, x, y, width, height);
+    py_retval = Py_BuildValue((char *) "N", retval);
+    return py_retval;
+}
+PyObject * _wrap_tiled_tileLayerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs);
+
+
+PyObject *
+_wrap_tiled_setTileLayerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs)
+{
+    PyObject *py_retval;
+    PyObject *retval;
+    PyTiledTileLayer *layer;
+    Tiled::TileLayer *layer_ptr;
+    PyObject *gids;
+    int x = 0;
+    int y = 0;
+    int width = -1;
+    int height = -1;
+    const char *keywords[] = {"layer", "gids", "x", "y", "width", "height", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O!O|iiii", (char **) keywords, &PyTiledTileLayer_Type, &layer, &gids, &x, &y, &width, &height)) {
+        return NULL;
+    }
+    layer_ptr = (layer ? layer->obj : NULL);
+    retval = setTileLayerGids(layer_ptr, gids, x, y, width, height);
+    py_retval = Py_BuildValue((char *) "N", retval);
+    return py_retval;
+}
+PyObject * _wrap_tiled_setTileLayerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs);
+
+
+PyObject *
+_wrap_tiled_propertiesAsDict(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs)
+{
+    PyObject *py_retval;
+    PyObject *retval;
+    PyTiledObject *object;
+    Tiled::Object *object_ptr;
+    const char *keywords[] = {"object", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O!", (char **) keywords, &PyTiledObject_Type, &object)) {
+        return NULL;
+    }
+    object_ptr = (object ? object->obj : NULL);
+    retval = propertiesAsDict(object_ptr);
+    py_retval = Py_BuildValue((char *) "N", retval);
+    return py_retval;
+}
+PyObject * _wrap_tiled_propertiesAsDict(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs);
+
 static PyMethodDef tiled_functions[] = {
     {(char *) "isTileLayerAt", (PyCFunction) _wrap_tiled_isTileLayerAt, METH_KEYWORDS|METH_VARARGS, NULL },
     {(char *) "loadTilesetFromFile", (PyCFunction) _wrap_tiled_loadTilesetFromFile, METH_KEYWORDS|METH_VARARGS, NULL },
     {(char *) "objectGroupAt", (PyCFunction) _wrap_tiled_objectGroupAt, METH_KEYWORDS|METH_VARARGS, NULL },
     {(char *) "isObjectGroupAt", (PyCFunction) _wrap_tiled_isObjectGroupAt, METH_KEYWORDS|METH_VARARGS, NULL },
     {(char *) "tileLayerAt", (PyCFunction) _wrap_tiled_tileLayerAt, METH_KEYWORDS|METH_VARARGS, NULL },
+    {(char *) "tileLayerGids", (PyCFunction) _wrap_tiled_tileLayerGids, METH_KEYWORDS|METH_VARARGS, NULL },
+    {(char *) "setTileLayerGids", (PyCFunction) _wrap_tiled_setTileLayerGids, METH_KEYWORDS|METH_VARARGS, NULL },
+    {(char *) "propertiesAsDict", (PyCFunction) _wrap_tiled_propertiesAsDict, METH_KEYWORDS|METH_VARARGS, NULL },
     {NULL, NULL, 0, NULL}
 };
 /* --- classes --- */
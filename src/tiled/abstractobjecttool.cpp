@@ -136,6 +136,8 @@ ObjectGroup *AbstractObjectTool::currentObjectGroup() const
 
 QList<MapObjectItem*> AbstractObjectTool::objectItemsAt(QPointF pos) const
 {
+    mMapScene->materializeObjectItems(QRectF(pos, pos));
+
     const QList<QGraphicsItem *> &items = mMapScene->items(pos);
 
     QList<MapObjectItem*> objectList;
@@ -148,6 +150,8 @@ QList<MapObjectItem*> AbstractObjectTool::objectItemsAt(QPointF pos) const
 
 MapObjectItem *AbstractObjectTool::topMostObjectItemAt(QPointF pos) const
 {
+    mMapScene->materializeObjectItems(QRectF(pos, pos));
+
     const QList<QGraphicsItem *> &items = mMapScene->items(pos);
 
     for (QGraphicsItem *item : items) {
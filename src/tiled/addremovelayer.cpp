@@ -23,6 +23,7 @@
 #include "layer.h"
 #include "layermodel.h"
 #include "mapdocument.h"
+#include "tilelayer.h"
 
 namespace Tiled {
 namespace Internal {
@@ -31,7 +32,8 @@ AddRemoveLayer::AddRemoveLayer(MapDocument *mapDocument,
                                int index,
                                Layer *layer,
                                GroupLayer *parentLayer)
-    : mMapDocument(mapDocument)
+    : CompressibleCommand(mapDocument->undoMemoryLimiter())
+    , mMapDocument(mapDocument)
     , mLayer(layer)
     , mParentLayer(parentLayer)
     , mIndex(index)
@@ -45,14 +47,40 @@ AddRemoveLayer::~AddRemoveLayer()
 
 void AddRemoveLayer::addLayer()
 {
+    if (!ensureLoaded())
+        return;
     mMapDocument->layerModel()->insertLayer(mParentLayer, mIndex, mLayer);
     mLayer = nullptr;
 }
 
 void AddRemoveLayer::removeLayer()
 {
+    ensureLoaded();
     mLayer = mMapDocument->layerModel()->takeLayerAt(mParentLayer, mIndex);
 }
 
+/**
+ * Only the cells of a removed tile layer are released, since they are
+ * usually what takes most of the memory.
+ */
+qint64 AddRemoveLayer::dataSize() const
+{
+    if (mLayer && mLayer->isTileLayer()) {
+        const TileLayer *tileLayer = static_cast<const TileLayer*>(mLayer);
+        return qint64(tileLayer->width()) * tileLayer->height() * sizeof(Cell);
+    }
+    return 0;
+}
+
+QByteArray AddRemoveLayer::saveData()
+{
+    return mLayer->asTileLayer()->takeCells();
+}
+
+void AddRemoveLayer::loadData(const QByteArray &data)
+{
+    mLayer->asTileLayer()->restoreCells(data);
+}
+
 } // namespace Internal
 } // namespace Tiled
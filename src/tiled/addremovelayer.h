@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "undomemorylimiter.h"
+
 #include <QCoreApplication>
 #include <QUndoCommand>
 
@@ -35,7 +37,7 @@ class MapDocument;
 /**
  * Abstract base class for AddLayer and RemoveLayer.
  */
-class AddRemoveLayer : public QUndoCommand
+class AddRemoveLayer : public QUndoCommand, public CompressibleCommand
 {
 public:
     AddRemoveLayer(MapDocument *mapDocument, int index, Layer *layer,
@@ -47,6 +49,10 @@ protected:
     void addLayer();
     void removeLayer();
 
+    qint64 dataSize() const override;
+    QByteArray saveData() override;
+    void loadData(const QByteArray &data) override;
+
 private:
     MapDocument *mMapDocument;
     Layer *mLayer;
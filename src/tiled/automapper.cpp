@@ -26,6 +26,7 @@
 #include "automappingutils.h"
 #include "changeproperties.h"
 #include "geometry.h"
+#include "grouplayer.h"
 #include "layermodel.h"
 #include "map.h"
 #include "mapdocument.h"
@@ -54,7 +55,9 @@ AutoMapper::AutoMapper(MapDocument *workingDocument, Map *rules,
                        const QString &rulePath)
     : mMapDocument(workingDocument)
     , mMapWork(workingDocument ? workingDocument->map() : nullptr)
+    , mRenderer(nullptr)
     , mMapRules(rules)
+    , mOwnsRulesMap(true)
     , mLayerInputRegions(nullptr)
     , mLayerOutputRegions(nullptr)
     , mRulePath(rulePath)
@@ -75,6 +78,39 @@ AutoMapper::AutoMapper(MapDocument *workingDocument, Map *rules,
 
     if (!setupRuleList())
         return;
+
+    // Without a working document, the rules may be shared between threads,
+    // which look up objects in the rules map concurrently
+    if (!workingDocument)
+        for (const ObjectGroup *objectGroup : mMapRules->objectGroups())
+            objectGroup->buildObjectIndex();
+}
+
+AutoMapper::AutoMapper(const AutoMapper &rules, Map *workingMap,
+                       MapRenderer *renderer)
+    : mMapDocument(nullptr)
+    , mMapWork(workingMap)
+    , mRenderer(renderer)
+    , mMapRules(rules.mMapRules)
+    , mOwnsRulesMap(false)
+    , mLayerInputRegions(rules.mLayerInputRegions)
+    , mLayerOutputRegions(rules.mLayerOutputRegions)
+    , mInputRules(rules.mInputRules)
+    , mRulesInput(rules.mRulesInput)
+    , mRulesOutput(rules.mRulesOutput)
+    , mLayerList(rules.mLayerList)
+    , mRulePath(rules.mRulePath)
+    , mDeleteTiles(rules.mDeleteTiles)
+    , mAutoMappingRadius(rules.mAutoMappingRadius)
+    , mNoOverlappingRules(rules.mNoOverlappingRules)
+    , mTouchedTileLayers(rules.mTouchedTileLayers)
+    , mTouchedObjectGroups(rules.mTouchedObjectGroups)
+    , mError(rules.mError)
+    , mWarning(rules.mWarning)
+{
+    Q_ASSERT(!rules.mMapDocument);
+    Q_ASSERT(mMapWork);
+    Q_ASSERT(mRenderer);
 }
 
 AutoMapper::~AutoMapper()
@@ -228,8 +264,8 @@ bool AutoMapper::setupRuleMapTileLayers()
             else if (layer->isObjectGroup())
                 mTouchedObjectGroups.insert(name);
 
-            Layer::TypeFlag type = layer->layerType();
-            int layerIndex = mMapWork->indexOfLayer(name, type);
+            // The index in the working map is looked up in setupCorrectIndexes
+            const int layerIndex = -1;
 
             bool found = false;
             for (RuleOutput &translationTable : mLayerList) {
@@ -343,18 +379,15 @@ bool AutoMapper::prepareAutoMap()
 
 bool AutoMapper::setupMissingLayers()
 {
-    QUndoStack *undoStack = mMapDocument->undoStack();
-
     // make sure all needed layers are there:
     foreach (const QString &name, mTouchedTileLayers) {
         if (mMapWork->indexOfLayer(name, Layer::TileLayerType) != -1)
             continue;
 
-        const int index =  mMapWork->layerCount();
         TileLayer *tileLayer = new TileLayer(name, 0, 0,
                                              mMapWork->width(),
                                              mMapWork->height());
-        undoStack->push(new AddLayer(mMapDocument, index, tileLayer, nullptr));
+        addLayer(tileLayer);
         mAddedLayers.append(tileLayer);
     }
 
@@ -362,9 +395,8 @@ bool AutoMapper::setupMissingLayers()
         if (mMapWork->indexOfLayer(name, Layer::ObjectGroupType) != -1)
             continue;
 
-        const int index =  mMapWork->layerCount();
         ObjectGroup *objectGroup = new ObjectGroup(name, 0, 0);
-        undoStack->push(new AddLayer(mMapDocument, index, objectGroup, nullptr));
+        addLayer(objectGroup);
         mAddedLayers.append(objectGroup);
     }
 
@@ -398,11 +430,29 @@ bool AutoMapper::setupTilesets()
 {
     Q_ASSERT(mAddedTilesets.isEmpty());
 
-    mMapDocument->unifyTilesets(mMapRules, mAddedTilesets);
+    if (mMapDocument) {
+        mMapDocument->unifyTilesets(mMapRules, mAddedTilesets);
+    } else {
+        // The rules map may be shared with other AutoMappers, so rather than
+        // replacing its tilesets, similar tilesets in the working map are
+        // replaced by those of the rules map. This is only done when both
+        // refer to the same file, to avoid changing how the map is saved.
+        for (const SharedTileset &tileset : mMapRules->tilesets()) {
+            const QVector<SharedTileset> &existingTilesets = mMapWork->tilesets();
+            if (existingTilesets.contains(tileset))
+                continue;
+
+            SharedTileset similar = tileset->findSimilarTileset(existingTilesets);
+            if (similar && similar->fileName() == tileset->fileName())
+                mMapWork->replaceTileset(similar, tileset);
+            else if (!mAddedTilesets.contains(tileset))
+                mAddedTilesets.append(tileset);
+        }
+    }
 
     const auto &addedTilesets = mAddedTilesets;
     for (const SharedTileset &tileset : addedTilesets)
-        mMapDocument->undoStack()->push(new AddTileset(mMapDocument, tileset));
+        addTileset(tileset);
 
     return true;
 }
@@ -434,9 +484,11 @@ void AutoMapper::autoMap(QRegion *where)
                 if (dstTileLayer) {
                     dstTileLayer->erase(region);
                 } else {
-                    eraseRegionObjectGroup(mMapDocument,
-                                           dstLayer->asObjectGroup(),
-                                           region);
+                    const auto objects = objectsToErase(renderer(),
+                                                        dstLayer->asObjectGroup(),
+                                                        region);
+                    for (MapObject *mapObject : objects)
+                        removeMapObject(mapObject);
                 }
             }
         }
@@ -445,29 +497,29 @@ void AutoMapper::autoMap(QRegion *where)
     // Increase the given region where the next automapper should work.
     // This needs to be done, so you can rely on the order of the rules at all
     // locations
-    QRegion ret;
+    TileMask ret;
     foreach (const QRect &rect, where->rects()) {
         for (int i = 0; i < mRulesInput.size(); ++i) {
             // at the moment the parallel execution does not work yet
             // TODO: make multithreading available!
             // either by dividing the rules or the region to multiple threads
-            ret = ret.united(applyRule(i, rect));
+            ret.addRect(applyRule(i, rect));
         }
     }
-    *where = where->united(ret);
+    *where = where->united(ret.toRegion());
 }
 
 QRegion AutoMapper::getSetLayersRegion() const
 {
-    QRegion result;
+    TileMask result;
     for (const QString &name : mInputRules.names) {
         const int index = mMapWork->indexOfLayer(name, Layer::TileLayerType);
         if (index == -1)
             continue;
         TileLayer *setLayer = mMapWork->layerAt(index)->asTileLayer();
-        result |= setLayer->region();
+        result += setLayer->mask();
     }
-    return result;
+    return result.toRegion();
 }
 
 static bool compareLayerTo(const TileLayer *setLayer,
@@ -499,9 +551,12 @@ QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
     // been altered by exactly this rule. We store all the altered parts to
     // make sure there are no overlaps of the same rule applied to
     // (neighbouring) places
-    QVector<QRegion> appliedRegions;
-    if (mNoOverlappingRules)
+    QVector<TileMask> appliedRegions;
+    TileMask ruleOutputMask;
+    if (mNoOverlappingRules) {
         appliedRegions.resize(mMapWork->layerCount());
+        ruleOutputMask = ruleOutputRegion;
+    }
 
     for (int y = minY; y <= maxY; ++y)
     for (int x = minX; x <= maxX; ++x) {
@@ -551,22 +606,22 @@ QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
             const QList<Layer*> layers = translationTable.keys();
 
             // check if there are no overlaps within this rule.
-            QVector<QRegion> ruleRegionInLayer;
+            QVector<TileMask> ruleRegionInLayer;
             for (int i = 0; i < layers.size(); ++i) {
                 Layer *layer = layers.at(i);
 
-                QRegion appliedPlace;
+                TileMask appliedPlace;
 
                 if (TileLayer *tileLayer = layer->asTileLayer())
-                    appliedPlace = tileLayer->region();
+                    appliedPlace = tileLayer->mask();
                 else if (ObjectGroup *objectGroup = layer->asObjectGroup())
                     appliedPlace = tileRegionOfObjectGroup(objectGroup);
                 else
                     continue;
 
-                ruleRegionInLayer.append(appliedPlace.intersected(ruleOutputRegion));
+                ruleRegionInLayer.append(appliedPlace.intersected(ruleOutputMask));
 
-                if (appliedRegions.at(i).intersects(ruleRegionInLayer.at(i).translated(x, y))) {
+                if (appliedRegions.at(i).intersects(ruleRegionInLayer.at(i).translated(QPoint(x, y)))) {
                     missmatch = true;
                     break;
                 }
@@ -577,7 +632,7 @@ QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
             copyMapRegion(ruleOutputRegion, QPoint(x, y), translationTable);
             ret = ret.united(rbr.translated(QPoint(x, y)));
             for (int i = 0; i < translationTable.size(); ++i)
-                appliedRegions[i] += ruleRegionInLayer[i].translated(x, y);
+                appliedRegions[i] += ruleRegionInLayer[i].translated(QPoint(x, y));
         }
     }
 
@@ -796,11 +851,8 @@ void AutoMapper::copyMapRegion(const QRegion &region, QPoint offset,
             Properties mergedProperties = to->properties();
             mergedProperties.merge(from->properties());
 
-            if (mergedProperties != to->properties()) {
-                QUndoStack *undoStack = mMapDocument->undoStack();
-                undoStack->push(new ChangeProperties(mMapDocument, QString(),
-                                                     to, mergedProperties));
-            }
+            if (mergedProperties != to->properties())
+                setProperties(to, mergedProperties);
         }
     }
 }
@@ -833,12 +885,11 @@ void AutoMapper::copyObjectRegion(const ObjectGroup *srcLayer, int srcX, int src
                                   int width, int height,
                                   ObjectGroup *dstLayer, int dstX, int dstY)
 {
-    QUndoStack *undo = mMapDocument->undoStack();
     const QRectF rect = QRectF(srcX, srcY, width, height);
-    const QRectF pixelRect = mMapDocument->renderer()->tileToPixelCoords(rect);
+    const QRectF pixelRect = renderer()->tileToPixelCoords(rect);
     const QList<MapObject*> objects = objectsInRegion(srcLayer, pixelRect.toAlignedRect());
 
-    QPointF pixelOffset = mMapDocument->renderer()->tileToPixelCoords(dstX, dstY);
+    QPointF pixelOffset = renderer()->tileToPixelCoords(dstX, dstY);
     pixelOffset -= pixelRect.topLeft();
 
     for (MapObject *obj : objects) {
@@ -846,7 +897,7 @@ void AutoMapper::copyObjectRegion(const ObjectGroup *srcLayer, int srcX, int src
         clone->resetId();
         clone->setX(clone->x() + pixelOffset.x());
         clone->setY(clone->y() + pixelOffset.y());
-        undo->push(new AddMapObject(mMapDocument, dstLayer, clone));
+        addMapObject(dstLayer, clone);
     }
 }
 
@@ -858,8 +909,6 @@ void AutoMapper::cleanAll()
 
 void AutoMapper::cleanTilesets()
 {
-    QUndoStack *undoStack = mMapDocument->undoStack();
-
     const auto &addedTilesets = mAddedTilesets;
     for (const SharedTileset &tileset : addedTilesets) {
         if (mMapWork->isTilesetUsed(tileset.data()))
@@ -869,7 +918,7 @@ void AutoMapper::cleanTilesets()
         if (index == -1)
             continue;
 
-        undoStack->push(new RemoveTileset(mMapDocument, index));
+        removeTileset(index);
     }
 
     mAddedTilesets.clear();
@@ -877,17 +926,12 @@ void AutoMapper::cleanTilesets()
 
 void AutoMapper::cleanTileLayers()
 {
-    QUndoStack *undoStack = mMapDocument->undoStack();
-
     const auto &addedLayers = mAddedLayers;
     for (Layer *layer : addedLayers) {
         if (!layer->isEmpty())
             continue;
 
-        const int index = layer->siblingIndex();
-        GroupLayer *parentLayer = layer->parentLayer();
-
-        undoStack->push(new RemoveLayer(mMapDocument, index, parentLayer));
+        removeLayer(layer);
     }
 
     mAddedLayers.clear();
@@ -897,10 +941,12 @@ void AutoMapper::cleanUpRulesMap()
 {
     cleanTilesets();
 
-    TilesetManager *tilesetManager = TilesetManager::instance();
-    tilesetManager->removeReferences(mMapRules->tilesets());
+    if (mOwnsRulesMap) {
+        TilesetManager *tilesetManager = TilesetManager::instance();
+        tilesetManager->removeReferences(mMapRules->tilesets());
 
-    delete mMapRules;
+        delete mMapRules;
+    }
     mMapRules = nullptr;
 
     cleanUpRuleMapLayers();
@@ -919,3 +965,83 @@ void AutoMapper::cleanUpRuleMapLayers()
     mLayerOutputRegions = nullptr;
     mInputRules.clear();
 }
+
+MapRenderer *AutoMapper::renderer() const
+{
+    return mMapDocument ? mMapDocument->renderer() : mRenderer;
+}
+
+void AutoMapper::addLayer(Layer *layer)
+{
+    if (mMapDocument) {
+        const int index = mMapWork->layerCount();
+        mMapDocument->undoStack()->push(new AddLayer(mMapDocument, index,
+                                                     layer, nullptr));
+    } else {
+        mMapWork->addLayer(layer);
+    }
+}
+
+void AutoMapper::removeLayer(Layer *layer)
+{
+    const int index = layer->siblingIndex();
+    GroupLayer *parentLayer = layer->parentLayer();
+
+    if (mMapDocument) {
+        mMapDocument->undoStack()->push(new RemoveLayer(mMapDocument, index,
+                                                        parentLayer));
+    } else {
+        if (parentLayer)
+            delete parentLayer->takeLayerAt(index);
+        else
+            delete mMapWork->takeLayerAt(index);
+    }
+}
+
+void AutoMapper::addTileset(const SharedTileset &tileset)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new AddTileset(mMapDocument, tileset));
+    else
+        mMapWork->addTileset(tileset);
+}
+
+void AutoMapper::removeTileset(int index)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new RemoveTileset(mMapDocument, index));
+    else
+        mMapWork->removeTilesetAt(index);
+}
+
+void AutoMapper::addMapObject(ObjectGroup *objectGroup, MapObject *mapObject)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new AddMapObject(mMapDocument,
+                                                         objectGroup,
+                                                         mapObject));
+    else
+        objectGroup->addObject(mapObject);
+}
+
+void AutoMapper::removeMapObject(MapObject *mapObject)
+{
+    if (mMapDocument) {
+        mMapDocument->undoStack()->push(new RemoveMapObject(mMapDocument,
+                                                            mapObject));
+    } else {
+        mapObject->objectGroup()->removeObject(mapObject);
+        delete mapObject;
+    }
+}
+
+void AutoMapper::setProperties(Object *object, const Properties &properties)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new ChangeProperties(mMapDocument,
+                                                             QString(),
+                                                             object,
+                                                             properties));
+    else
+        object->setProperties(properties);
+}
@@ -34,6 +34,8 @@ namespace Tiled {
 class Layer;
 class Map;
 class MapObject;
+class MapRenderer;
+class Object;
 class ObjectGroup;
 class TileLayer;
 
@@ -90,6 +92,23 @@ public:
      */
     AutoMapper(MapDocument *workingDocument, Map *rules,
                const QString &rulePath);
+
+    /**
+     * Constructs an AutoMapper that applies the rules set up by \a rules
+     * directly to \a workingMap, without going through a MapDocument. The
+     * changes made by such an AutoMapper can't be undone.
+     *
+     * The rules map and the data structures derived from it are shared with
+     * \a rules and only read from, so several of these AutoMappers can work
+     * on different maps in parallel. \a rules needs to outlive this instance.
+     *
+     * @param rules: An AutoMapper that was set up without a working document.
+     * @param workingMap: the map to work on.
+     * @param renderer: a renderer for \a workingMap, used for placing objects.
+     */
+    AutoMapper(const AutoMapper &rules, Map *workingMap,
+               MapRenderer *renderer);
+
     ~AutoMapper();
 
     /**
@@ -238,6 +257,25 @@ private:
      */
     void cleanUpRuleMapLayers();
 
+    /**
+     * Returns the renderer to use for converting between tile and pixel
+     * coordinates on the working map.
+     */
+    MapRenderer *renderer() const;
+
+    /*
+     * The following functions change the working map. When working on a
+     * MapDocument they push the matching undo commands, otherwise the map
+     * is changed directly.
+     */
+    void addLayer(Layer *layer);
+    void removeLayer(Layer *layer);
+    void addTileset(const SharedTileset &tileset);
+    void removeTileset(int index);
+    void addMapObject(ObjectGroup *objectGroup, MapObject *mapObject);
+    void removeMapObject(MapObject *mapObject);
+    void setProperties(Object *object, const Properties &properties);
+
     /**
      * Cleans up the data structures filled by setupTilesets(),
      * so the next rule can be processed.
@@ -251,7 +289,7 @@ private:
     void cleanTileLayers();
 
     /**
-     * where to work in
+     * where to work in, null when working directly on mMapWork
      */
     MapDocument *mMapDocument;
 
@@ -260,11 +298,22 @@ private:
      */
     Map *mMapWork;
 
+    /**
+     * used instead of mMapDocument->renderer() when there is no document
+     */
+    MapRenderer *mRenderer;
+
     /**
      * map containing the rules, usually different than mMapWork
      */
     Map *mMapRules;
 
+    /**
+     * whether mMapRules is owned by this instance, which is not the case
+     * when the rules are shared with another AutoMapper
+     */
+    bool mOwnsRulesMap;
+
     /**
      * This contains all added tilesets as pointers.
      * if rules use Tilesets which are not in the mMapWork they are added.
@@ -31,6 +31,7 @@ using namespace Tiled::Internal;
 AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
                                      QVector<AutoMapper*> autoMapper,
                                      QRegion *where)
+    : CompressibleCommand(mapDocument->undoMemoryLimiter())
 {
     mMapDocument = mapDocument;
     Map *map = mMapDocument->map();
@@ -94,6 +95,9 @@ AutoMapperWrapper::~AutoMapperWrapper()
 
 void AutoMapperWrapper::undo()
 {
+    if (!ensureLoaded())
+        return;
+
     Map *map = mMapDocument->map();
     for (TileLayer *layer : mLayersBefore) {
         const int layerIndex = map->indexOfLayer(layer->name());
@@ -104,6 +108,9 @@ void AutoMapperWrapper::undo()
 
 void AutoMapperWrapper::redo()
 {
+    if (!ensureLoaded())
+        return;
+
     Map *map = mMapDocument->map();
     for (TileLayer *layer : mLayersAfter) {
         const int layerIndex = map->indexOfLayer(layer->name());
@@ -112,6 +119,45 @@ void AutoMapperWrapper::redo()
     }
 }
 
+qint64 AutoMapperWrapper::dataSize() const
+{
+    qint64 size = 0;
+    for (const TileLayer *layer : mLayersBefore)
+        size += qint64(layer->width()) * layer->height() * sizeof(Cell);
+    for (const TileLayer *layer : mLayersAfter)
+        size += qint64(layer->width()) * layer->height() * sizeof(Cell);
+    return size;
+}
+
+QByteArray AutoMapperWrapper::saveData()
+{
+    QByteArray data;
+    data.reserve(int(dataSize()));
+
+    for (TileLayer *layer : mLayersBefore)
+        data.append(layer->takeCells());
+    for (TileLayer *layer : mLayersAfter)
+        data.append(layer->takeCells());
+
+    return data;
+}
+
+void AutoMapperWrapper::loadData(const QByteArray &data)
+{
+    int offset = 0;
+
+    auto restore = [&] (TileLayer *layer) {
+        const int size = layer->width() * layer->height() * int(sizeof(Cell));
+        layer->restoreCells(data.mid(offset, size));
+        offset += size;
+    };
+
+    for (TileLayer *layer : mLayersBefore)
+        restore(layer);
+    for (TileLayer *layer : mLayersAfter)
+        restore(layer);
+}
+
 void AutoMapperWrapper::patchLayer(int layerIndex, TileLayer *layer)
 {
     Map *map = mMapDocument->map();
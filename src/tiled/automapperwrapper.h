@@ -21,6 +21,7 @@
 #pragma once
 
 #include "automapper.h"
+#include "undomemorylimiter.h"
 
 #include <QUndoCommand>
 #include <QVector>
@@ -38,7 +39,7 @@ class MapDocument;
  * This class will take a snapshot of the layers before and after the
  * automapping is done. In between instances of AutoMapper are doing the work.
  */
-class AutoMapperWrapper : public QUndoCommand
+class AutoMapperWrapper : public QUndoCommand, public CompressibleCommand
 {
 public:
     AutoMapperWrapper(MapDocument *mapDocument, QVector<AutoMapper*> autoMapper,
@@ -48,6 +49,11 @@ public:
     void undo() override;
     void redo() override;
 
+protected:
+    qint64 dataSize() const override;
+    QByteArray saveData() override;
+    void loadData(const QByteArray &data) override;
+
 private:
     void patchLayer(int layerIndex, TileLayer *layer);
 
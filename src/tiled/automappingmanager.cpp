@@ -77,7 +77,8 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
     if (!mLoaded) {
         const QString mapPath = QFileInfo(mMapDocument->fileName()).path();
         const QString rulesFileName = mapPath + QLatin1String("/rules.txt");
-        if (loadFile(rulesFileName)) {
+        if (loadRules(rulesFileName, mMapDocument, mAutoMappers,
+                      mError, mWarning)) {
             mLoaded = true;
         } else {
             emit errorsOccurred(automatic);
@@ -117,20 +118,24 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
         emit errorsOccurred(automatic);
 }
 
-bool AutomappingManager::loadFile(const QString &filePath)
+bool AutomappingManager::loadRules(const QString &filePath,
+                                   MapDocument *mapDocument,
+                                   QVector<AutoMapper*> &autoMappers,
+                                   QString &error,
+                                   QString &warning)
 {
     bool ret = true;
     const QString absPath = QFileInfo(filePath).path();
     QFile rulesFile(filePath);
 
     if (!rulesFile.exists()) {
-        mError += tr("No rules file found at:\n%1").arg(filePath)
-                  + QLatin1Char('\n');
+        error += tr("No rules file found at:\n%1").arg(filePath)
+                 + QLatin1Char('\n');
         return false;
     }
     if (!rulesFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        mError += tr("Error opening rules file:\n%1").arg(filePath)
-                  + QLatin1Char('\n');
+        error += tr("Error opening rules file:\n%1").arg(filePath)
+                 + QLatin1Char('\n');
         return false;
     }
 
@@ -148,7 +153,7 @@ bool AutomappingManager::loadFile(const QString &filePath)
             rulePath = absPath + QLatin1Char('/') + rulePath;
 
         if (!QFileInfo(rulePath).exists()) {
-            mError += tr("File not found:\n%1").arg(rulePath) + QLatin1Char('\n');
+            error += tr("File not found:\n%1").arg(rulePath) + QLatin1Char('\n');
             ret = false;
             continue;
         }
@@ -158,25 +163,25 @@ bool AutomappingManager::loadFile(const QString &filePath)
             QScopedPointer<Map> rules(tmxFormat.read(rulePath));
 
             if (!rules) {
-                mError += tr("Opening rules map failed:\n%1").arg(
+                error += tr("Opening rules map failed:\n%1").arg(
                         tmxFormat.errorString()) + QLatin1Char('\n');
                 ret = false;
                 continue;
             }
 
-            AutoMapper *autoMapper = new AutoMapper(mMapDocument, rules.take(), rulePath);
+            AutoMapper *autoMapper = new AutoMapper(mapDocument, rules.take(), rulePath);
 
-            mWarning += autoMapper->warningString();
-            const QString error = autoMapper->errorString(); 
-            if (error.isEmpty()) {
-                mAutoMappers.append(autoMapper);
+            warning += autoMapper->warningString();
+            const QString autoMapperError = autoMapper->errorString();
+            if (autoMapperError.isEmpty()) {
+                autoMappers.append(autoMapper);
             } else {
-                mError += error;
+                error += autoMapperError;
                 delete autoMapper;
             }
         }
         if (rulePath.endsWith(QLatin1String(".txt"), Qt::CaseInsensitive)) {
-            if (!loadFile(rulePath))
+            if (!loadRules(rulePath, mapDocument, autoMappers, error, warning))
                 ret = false;
         }
     }
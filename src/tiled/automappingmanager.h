@@ -56,6 +56,25 @@ public:
 
     QString warningString() const { return mWarning; }
 
+    /**
+     * Parses the rules file at \a filePath. For each rule map it references
+     * (file extension is tmx) an AutoMapper working on \a mapDocument is set
+     * up and appended to \a autoMappers. Referenced txt files are searched
+     * for rules recursively.
+     *
+     * The \a mapDocument may be null, in which case the AutoMappers can be
+     * used as rules for AutoMappers that work directly on a map.
+     *
+     * Errors and warnings are appended to \a error and \a warning.
+     *
+     * @return if the loading was successful: return true if it succeeded.
+     */
+    static bool loadRules(const QString &filePath,
+                          MapDocument *mapDocument,
+                          QVector<AutoMapper*> &autoMappers,
+                          QString &error,
+                          QString &warning);
+
 signals:
     /**
      * This signal is emitted after automapping was done and an error occurred.
@@ -79,18 +98,6 @@ private slots:
 private:
     Q_DISABLE_COPY(AutomappingManager)
 
-    /**
-     * This function parses a rules file.
-     * For each path which is a rule, (file extension is tmx) an AutoMapper
-     * object is setup.
-     *
-     * If a file extension is txt, this file will be opened and searched for
-     * rules again.
-     *
-     * @return if the loading was successful: return true if it succeeded.
-     */
-    bool loadFile(const QString &filePath);
-
     /**
      * Applies automapping to the Region \a where, considering only layer
      * \a touchedLayer has changed.
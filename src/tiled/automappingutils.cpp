@@ -26,20 +26,41 @@
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "objectgroup.h"
+#include "tilemask.h"
 
 #include <QUndoStack>
 
 namespace Tiled {
 namespace Internal {
 
-void eraseRegionObjectGroup(MapDocument *mapDocument,
-                            ObjectGroup *layer,
-                            const QRegion &where)
+/**
+ * Returns a rectangle in pixel coordinates that covers the given rectangle
+ * in tile coordinates. Some margin is added, since objects are matched to
+ * tiles by their aligned bounding rectangle.
+ */
+static QRectF pixelBounds(const MapRenderer *renderer, const QRect &tileRect)
 {
-    QUndoStack *undo = mapDocument->undoStack();
+    const QRectF rect = QRectF(tileRect).adjusted(-2, -2, 2, 2);
+
+    QPolygonF corners;
+    corners << renderer->tileToPixelCoords(rect.topLeft())
+            << renderer->tileToPixelCoords(rect.topRight())
+            << renderer->tileToPixelCoords(rect.bottomRight())
+            << renderer->tileToPixelCoords(rect.bottomLeft());
+
+    return corners.boundingRect();
+}
+
+const QList<MapObject*> objectsToErase(const MapRenderer *renderer,
+                                       const ObjectGroup *layer,
+                                       const QRegion &where)
+{
+    QList<MapObject*> ret;
 
-    const auto objects = layer->objects();
-    for (MapObject *obj : objects) {
+    // Only the objects near the region need to be checked
+    const QRectF searchRect = pixelBounds(renderer, where.boundingRect());
+
+    for (MapObject *obj : layer->objectsInRect(searchRect)) {
         // TODO: we are checking bounds, which is only correct for rectangles and
         // tile objects. polygons and polylines are not covered correctly by this
         // erase method (we are in fact deleting too many objects)
@@ -47,10 +68,10 @@ void eraseRegionObjectGroup(MapDocument *mapDocument,
 
         // Convert the boundary of the object into tile space
         const QRectF objBounds = obj->boundsUseTile();
-        QPointF tl = mapDocument->renderer()->pixelToTileCoords(objBounds.topLeft());
-        QPointF tr = mapDocument->renderer()->pixelToTileCoords(objBounds.topRight());
-        QPointF br = mapDocument->renderer()->pixelToTileCoords(objBounds.bottomRight());
-        QPointF bl = mapDocument->renderer()->pixelToTileCoords(objBounds.bottomLeft());
+        QPointF tl = renderer->pixelToTileCoords(objBounds.topLeft());
+        QPointF tr = renderer->pixelToTileCoords(objBounds.topRight());
+        QPointF br = renderer->pixelToTileCoords(objBounds.bottomRight());
+        QPointF bl = renderer->pixelToTileCoords(objBounds.bottomLeft());
 
         QRectF objInTileSpace;
         objInTileSpace.setTopLeft(tl);
@@ -60,27 +81,46 @@ void eraseRegionObjectGroup(MapDocument *mapDocument,
 
         const QRect objAlignedRect = objInTileSpace.toAlignedRect();
         if (where.intersects(objAlignedRect))
-            undo->push(new RemoveMapObject(mapDocument, obj));
+            ret += obj;
     }
+
+    return ret;
+}
+
+void eraseRegionObjectGroup(MapDocument *mapDocument,
+                            ObjectGroup *layer,
+                            const QRegion &where)
+{
+    QUndoStack *undo = mapDocument->undoStack();
+
+    const auto objects = objectsToErase(mapDocument->renderer(), layer, where);
+    for (MapObject *obj : objects)
+        undo->push(new RemoveMapObject(mapDocument, obj));
 }
 
 QRegion tileRegionOfObjectGroup(const ObjectGroup *layer)
 {
-    QRegion ret;
+    // Uniting many rectangles is much faster using a mask than using QRegion
+    TileMask ret;
     for (MapObject *obj : layer->objects()) {
         // TODO: we are using bounds, which is only correct for rectangles and
         // tile objects. polygons and polylines are not probably covering less
         // tiles.
-        ret += obj->bounds().toAlignedRect();
+        ret.addRect(obj->bounds().toAlignedRect());
     }
-    return ret;
+    return ret.toRegion();
 }
 
 const QList<MapObject*> objectsInRegion(const ObjectGroup *layer,
                                         const QRegion &where)
 {
     QList<MapObject*> ret;
-    for (MapObject *obj : layer->objects()) {
+
+    // Only the objects near the region need to be checked. The aligned
+    // rectangle of an object can be up to a pixel larger than its bounds.
+    const QRectF searchRect = QRectF(where.boundingRect()).adjusted(-1, -1, 1, 1);
+
+    for (MapObject *obj : layer->objectsInRect(searchRect)) {
         // TODO: we are checking bounds, which is only correct for rectangles and
         // tile objects. polygons and polylines are not covered correctly by this
         // erase method (we are in fact deleting too many objects)
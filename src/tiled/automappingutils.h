@@ -25,6 +25,7 @@
 namespace Tiled {
 
 class MapObject;
+class MapRenderer;
 class ObjectGroup;
 
 namespace Internal {
@@ -34,6 +35,10 @@ class MapDocument;
 const QList<MapObject*> objectsInRegion(const ObjectGroup *layer,
                                         const QRegion &where);
 
+const QList<MapObject*> objectsToErase(const MapRenderer *renderer,
+                                       const ObjectGroup *layer,
+                                       const QRegion &where);
+
 void eraseRegionObjectGroup(MapDocument *mapDocument,
                             ObjectGroup *layer,
                             const QRegion &where);
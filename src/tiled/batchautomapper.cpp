@@ -0,0 +1,214 @@
+/*
+ * batchautomapper.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batchautomapper.h"
+
+#include "automapper.h"
+#include "automappingmanager.h"
+#include "hexagonalrenderer.h"
+#include "isometricrenderer.h"
+#include "map.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
+#include "tilesetmanager.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QPair>
+#include <QtConcurrentRun>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+/**
+ * Limits the number of loaded maps waiting to be processed, since loading is
+ * usually faster than AutoMapping and saving.
+ */
+static const int MaximumPendingMaps = 4;
+
+/**
+ * Returns the tilesets of the given \a map that are loaded from a file.
+ * Only these can be shared with other maps.
+ */
+static QVector<SharedTileset> externalTilesets(const Map *map)
+{
+    QVector<SharedTileset> tilesets;
+    for (const SharedTileset &tileset : map->tilesets())
+        if (!tileset->fileName().isEmpty())
+            tilesets.append(tileset);
+    return tilesets;
+}
+
+static MapRenderer *createRenderer(Map *map)
+{
+    switch (map->orientation()) {
+    case Map::Isometric:
+        return new IsometricRenderer(map);
+    case Map::Staggered:
+        return new StaggeredRenderer(map);
+    case Map::Hexagonal:
+        return new HexagonalRenderer(map);
+    default:
+        return new OrthogonalRenderer(map);
+    }
+}
+
+BatchAutoMapper::BatchAutoMapper()
+    : mDtdEnabled(false)
+{
+}
+
+BatchAutoMapper::~BatchAutoMapper()
+{
+    qDeleteAll(mRules);
+}
+
+bool BatchAutoMapper::loadRules(const QString &rulesFile)
+{
+    return AutomappingManager::loadRules(rulesFile, nullptr, mRules,
+                                         mError, mWarning);
+}
+
+bool BatchAutoMapper::run(const QVector<Job> &jobs)
+{
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    QVector<Result> results(jobs.size());
+
+    // The maps are deleted on this thread once saved, since their tilesets
+    // own pixmaps
+    QList<QPair<Map*, QFuture<void>>> pendingMaps;
+    auto finishOldestMap = [&pendingMaps] {
+        auto pendingMap = pendingMaps.takeFirst();
+        pendingMap.second.waitForFinished();
+        delete pendingMap.first;
+    };
+
+    // Keep the external tilesets of loaded maps referenced, so that following
+    // maps will share them instead of loading them again.
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    QVector<SharedTileset> referencedTilesets;
+
+    for (int i = 0; i < jobs.size(); ++i) {
+        const Job &job = jobs.at(i);
+        Result &result = results[i];
+
+        while (pendingMaps.size() >= MaximumPendingMaps)
+            finishOldestMap();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        MapReader reader;
+        Map *map = reader.readMap(job.sourceFile);
+        result.loadTime = timer.elapsed();
+
+        if (!map) {
+            result.error = reader.errorString();
+            continue;
+        }
+
+        const QVector<SharedTileset> tilesets = externalTilesets(map);
+        tilesetManager->addReferences(tilesets);
+        referencedTilesets += tilesets;
+
+        pendingMaps.append(qMakePair(map, QtConcurrent::run([this, map, &job, &result] {
+            autoMapAndSave(map, job, result);
+        })));
+    }
+
+    while (!pendingMaps.isEmpty())
+        finishOldestMap();
+
+    tilesetManager->removeReferences(referencedTilesets);
+
+    bool success = true;
+
+    for (int i = 0; i < jobs.size(); ++i) {
+        const Job &job = jobs.at(i);
+        const Result &result = results.at(i);
+
+        qWarning().noquote() << tr("%1: load %2 ms, automap %3 ms, save %4 ms")
+                                .arg(job.sourceFile)
+                                .arg(result.loadTime)
+                                .arg(result.autoMapTime)
+                                .arg(result.saveTime);
+
+        if (!result.warning.isEmpty())
+            qWarning().noquote() << result.warning.trimmed();
+
+        if (!result.error.isEmpty()) {
+            qWarning().noquote() << result.error.trimmed();
+            success = false;
+        }
+    }
+
+    qWarning().noquote() << tr("Processed %n map(s) in %1 ms", "", jobs.size())
+                            .arg(totalTimer.elapsed());
+
+    return success;
+}
+
+/**
+ * Applies the rules to the given \a map and saves it. Called on a worker
+ * thread.
+ */
+void BatchAutoMapper::autoMapAndSave(Map *map, const Job &job,
+                                     Result &result) const
+{
+    QScopedPointer<MapRenderer> renderer(createRenderer(map));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<AutoMapper*> autoMappers;
+    for (const AutoMapper *rules : mRules)
+        autoMappers.append(new AutoMapper(*rules, map, renderer.data()));
+
+    // Same order of operations as in AutoMapperWrapper
+    QVector<AutoMapper*> preparedAutoMappers;
+    for (AutoMapper *autoMapper : autoMappers)
+        if (autoMapper->prepareAutoMap())
+            preparedAutoMappers.append(autoMapper);
+
+    QRegion where(0, 0, map->width(), map->height());
+    for (AutoMapper *autoMapper : preparedAutoMappers)
+        autoMapper->autoMap(&where);
+
+    for (AutoMapper *autoMapper : autoMappers) {
+        autoMapper->cleanAll();
+        result.warning += autoMapper->warningString();
+        result.error += autoMapper->errorString();
+    }
+
+    qDeleteAll(autoMappers);
+    result.autoMapTime = timer.restart();
+
+    MapWriter writer;
+    writer.setDtdEnabled(mDtdEnabled);
+    if (!writer.writeMap(map, job.targetFile))
+        result.error += writer.errorString();
+
+    result.saveTime = timer.elapsed();
+}
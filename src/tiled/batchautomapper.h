@@ -0,0 +1,109 @@
+/*
+ * batchautomapper.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+
+namespace Tiled {
+
+class Map;
+
+namespace Internal {
+
+class AutoMapper;
+
+/**
+ * Applies AutoMapping rules to any number of maps, without involving a
+ * MapDocument or an undo stack. Used for the --automap command line option.
+ *
+ * The rules are loaded only once and shared by all maps. The maps are loaded
+ * one after the other, so that they can share external tilesets through the
+ * TilesetManager, while the AutoMapping and saving of each map happens in
+ * parallel on the global thread pool. Only a few loaded maps are kept
+ * waiting for a thread, to bound memory use.
+ */
+class BatchAutoMapper
+{
+    Q_DECLARE_TR_FUNCTIONS(BatchAutoMapper)
+
+public:
+    struct Job
+    {
+        QString sourceFile;
+        QString targetFile;
+    };
+
+    BatchAutoMapper();
+    ~BatchAutoMapper();
+
+    /**
+     * Loads the rules from the given rules file, which may either be a
+     * rules map (tmx) or a text file listing rules maps.
+     *
+     * @return whether the rules were loaded without errors
+     */
+    bool loadRules(const QString &rulesFile);
+
+    /**
+     * Whether the DTD reference is written to the saved maps.
+     */
+    void setDtdEnabled(bool enabled) { mDtdEnabled = enabled; }
+
+    /**
+     * Applies the loaded rules to the source map of each of the given
+     * \a jobs and saves the result to its target file. Reports any errors as
+     * well as the time spent on each map.
+     *
+     * @return whether all maps were processed successfully
+     */
+    bool run(const QVector<Job> &jobs);
+
+    QString errorString() const { return mError; }
+    QString warningString() const { return mWarning; }
+
+private:
+    struct Result
+    {
+        Result()
+            : loadTime(0)
+            , autoMapTime(0)
+            , saveTime(0)
+        {}
+
+        QString error;
+        QString warning;
+        qint64 loadTime;
+        qint64 autoMapTime;
+        qint64 saveTime;
+    };
+
+    void autoMapAndSave(Map *map, const Job &job, Result &result) const;
+
+    QVector<AutoMapper*> mRules;
+    QString mError;
+    QString mWarning;
+    bool mDtdEnabled;
+};
+
+} // namespace Internal
+} // namespace Tiled
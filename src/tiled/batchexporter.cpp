@@ -0,0 +1,282 @@
+/*
+ * batchexporter.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batchexporter.h"
+
+#include "map.h"
+#include "mapformat.h"
+#include "mapreader.h"
+#include "preferences.h"
+#include "tilesetmanager.h"
+#include "tmxmapformat.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFuture>
+#include <QPair>
+#include <QRegExp>
+#include <QtConcurrentRun>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+/**
+ * Limits the number of loaded maps waiting to be exported, since loading is
+ * usually faster than exporting.
+ */
+static const int MaximumPendingExports = 4;
+
+/**
+ * Returns the tilesets of the given \a map that are loaded from a file.
+ * Only these can be shared with other maps.
+ */
+static QVector<SharedTileset> externalTilesets(const Map *map)
+{
+    QVector<SharedTileset> tilesets;
+    for (const SharedTileset &tileset : map->tilesets())
+        if (!tileset->fileName().isEmpty())
+            tilesets.append(tileset);
+    return tilesets;
+}
+
+/**
+ * Returns the options that affect the output of the given \a format, to be
+ * recorded in the export manifest. Only the TMX writer has such options,
+ * which it takes from the preferences.
+ */
+static QVariantMap writerOptions(MapFormat *format)
+{
+    QVariantMap options;
+
+    if (qobject_cast<TmxMapFormat*>(format)) {
+        const Preferences *prefs = Preferences::instance();
+        options.insert(QLatin1String("dtd"), prefs->dtdEnabled());
+        options.insert(QLatin1String("embeddedImageFormat"),
+                       static_cast<int>(prefs->embeddedImageFormat()));
+    }
+
+    return options;
+}
+
+BatchExporter::BatchExporter(MapFormat *format)
+    : mFormat(format)
+    , mManifest(nullptr)
+{
+}
+
+bool BatchExporter::isPattern(const QString &sourceFile)
+{
+    const QString fileName = QFileInfo(sourceFile).fileName();
+    return fileName.contains(QLatin1Char('*')) ||
+            fileName.contains(QLatin1Char('?')) ||
+            fileName.contains(QLatin1Char('['));
+}
+
+bool BatchExporter::addJob(const QString &sourceFile, const QString &targetFile)
+{
+    const QFileInfo sourceInfo(sourceFile);
+
+    if (!isPattern(sourceFile)) {
+        mJobs.append(Job { sourceFile, targetFile });
+        return true;
+    }
+
+    // The name filter of a format includes a pattern like "(*.lua)"
+    QRegExp extensionFinder(QLatin1String("\\(\\*\\.([^\\)\\s]*)"));
+    if (extensionFinder.indexIn(mFormat->nameFilter()) == -1) {
+        mError = tr("Unable to determine the file extension for format '%1'.")
+                .arg(mFormat->shortName());
+        return false;
+    }
+    const QString extension = extensionFinder.cap(1);
+
+    const QDir sourceDir = sourceInfo.dir();
+    const QStringList fileNames = sourceDir.entryList(QStringList(sourceInfo.fileName()),
+                                                      QDir::Files, QDir::Name);
+    if (fileNames.isEmpty()) {
+        mError = tr("No files match '%1'.").arg(sourceFile);
+        return false;
+    }
+
+    const QDir targetDir(targetFile);
+    if (!targetDir.exists() && !QDir().mkpath(targetFile)) {
+        mError = tr("Unable to create directory '%1'.").arg(targetFile);
+        return false;
+    }
+
+    for (const QString &fileName : fileNames) {
+        const QString targetName = QFileInfo(fileName).completeBaseName() +
+                QLatin1Char('.') + extension;
+        mJobs.append(Job { sourceDir.filePath(fileName),
+                           targetDir.filePath(targetName) });
+    }
+
+    return true;
+}
+
+bool BatchExporter::run()
+{
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    QVector<Result> results(mJobs.size());
+
+    // Each pending export needs its own instance of the format. When the
+    // format can't be cloned, the maps are exported one at a time.
+    QVector<MapFormat*> formats(1, mFormat);
+    while (formats.size() < MaximumPendingExports) {
+        MapFormat *format = mFormat->clone();
+        if (!format)
+            break;
+        formats.append(format);
+    }
+    int exportCount = 0;
+
+    // The maps are deleted on this thread once exported, since their
+    // tilesets own pixmaps
+    QList<QPair<Map*, QFuture<void>>> pendingExports;
+    auto finishOldestExport = [&pendingExports] {
+        auto pendingExport = pendingExports.takeFirst();
+        pendingExport.second.waitForFinished();
+        delete pendingExport.first;
+    };
+
+    // Keep the external tilesets of loaded maps referenced, so that following
+    // maps will share them instead of loading them again.
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    QVector<SharedTileset> referencedTilesets;
+
+    const QVariantMap options = writerOptions(mFormat);
+
+    for (int i = 0; i < mJobs.size(); ++i) {
+        const Job &job = mJobs.at(i);
+        Result &result = results[i];
+
+        if (mManifest && mManifest->isUpToDate(job.sourceFile,
+                                               job.targetFile,
+                                               mFormat->shortName(),
+                                               options)) {
+            result.upToDate = true;
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        MapReader reader;
+        Map *map = reader.readMap(job.sourceFile);
+        result.loadTime = timer.elapsed();
+
+        if (!map) {
+            result.error = reader.errorString();
+            continue;
+        }
+
+        const QVector<SharedTileset> tilesets = externalTilesets(map);
+        tilesetManager->addReferences(tilesets);
+        referencedTilesets += tilesets;
+
+        if (mManifest) {
+            const QStringList outputFiles = mFormat->outputFiles(map, job.targetFile);
+            result.manifestEntry = mManifest->createEntry(map, job.sourceFile,
+                                                          outputFiles,
+                                                          mFormat->shortName(),
+                                                          options);
+        }
+
+        // Exports finish in order, so once fewer exports than format
+        // instances are pending, the instance used by the oldest export
+        // started so far is no longer in use.
+        while (pendingExports.size() >= formats.size())
+            finishOldestExport();
+
+        MapFormat *format = formats.at(exportCount++ % formats.size());
+
+        pendingExports.append(qMakePair(map, QtConcurrent::run([format, map, &job, &result] {
+            exportMap(format, map, job, result);
+        })));
+    }
+
+    while (!pendingExports.isEmpty())
+        finishOldestExport();
+
+    qDeleteAll(formats.begin() + 1, formats.end());
+
+    tilesetManager->removeReferences(referencedTilesets);
+
+    int failed = 0;
+    int upToDate = 0;
+
+    for (int i = 0; i < mJobs.size(); ++i) {
+        const Job &job = mJobs.at(i);
+        const Result &result = results.at(i);
+
+        if (result.upToDate) {
+            ++upToDate;
+            continue;
+        }
+
+        if (mManifest) {
+            if (result.error.isEmpty())
+                mManifest->insert(job.targetFile, result.manifestEntry);
+            else
+                mManifest->remove(job.targetFile);
+        }
+
+        qWarning().noquote() << tr("%1: load %2 ms, export %3 ms")
+                                .arg(job.sourceFile)
+                                .arg(result.loadTime)
+                                .arg(result.exportTime);
+
+        if (!result.error.isEmpty()) {
+            qWarning().noquote() << result.error.trimmed();
+            ++failed;
+        }
+    }
+
+    qWarning().noquote() << tr("Exported %n map(s) in %1 ms", "", mJobs.size() - upToDate - failed)
+                            .arg(totalTimer.elapsed());
+
+    if (upToDate > 0)
+        qWarning().noquote() << tr("Skipped %n up-to-date map(s)", "", upToDate);
+
+    if (failed > 0)
+        qWarning().noquote() << tr("Failed to export %n map(s)", "", failed);
+
+    return failed == 0;
+}
+
+/**
+ * Exports the given \a map using the given \a format instance. Called on a
+ * worker thread.
+ */
+void BatchExporter::exportMap(MapFormat *format, const Map *map,
+                              const Job &job, Result &result)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!format->write(map, job.targetFile))
+        result.error = format->errorString();
+
+    result.exportTime = timer.elapsed();
+}
@@ -0,0 +1,125 @@
+/*
+ * batchexporter.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "exportmanifest.h"
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+
+namespace Tiled {
+
+class Map;
+class MapFormat;
+
+namespace Internal {
+
+/**
+ * Exports any number of maps to a single format. Used for the --export-maps
+ * command line option.
+ *
+ * The maps are loaded one after the other, so that they can share external
+ * tilesets through the TilesetManager, while the exporting happens on the
+ * global thread pool, in parallel with loading the next maps. Since map
+ * formats may keep state while writing a map, each concurrent export uses
+ * its own instance of the format (see MapFormat::clone). Formats that can't
+ * be cloned write only one map at a time.
+ *
+ * When an ExportManifest is set, maps that did not change since they were
+ * last exported are skipped without being loaded.
+ */
+class BatchExporter
+{
+    Q_DECLARE_TR_FUNCTIONS(BatchExporter)
+
+public:
+    struct Job
+    {
+        QString sourceFile;
+        QString targetFile;
+    };
+
+    explicit BatchExporter(MapFormat *format);
+
+    /**
+     * Returns whether the file name of \a sourceFile contains wildcards,
+     * in which case it matches any number of maps.
+     */
+    static bool isPattern(const QString &sourceFile);
+
+    /**
+     * Adds a job exporting \a sourceFile to \a targetFile.
+     *
+     * When the file name of \a sourceFile contains wildcards, a job is added
+     * for each matching file and \a targetFile is the directory to export
+     * to. The exported files are named after the source files, with the
+     * extension of the format.
+     *
+     * @return whether the job could be added
+     */
+    bool addJob(const QString &sourceFile, const QString &targetFile);
+
+    const QVector<Job> &jobs() const { return mJobs; }
+
+    /**
+     * Sets the manifest used to skip exporting unchanged maps. It is updated
+     * with the maps that were exported, but not saved.
+     */
+    void setManifest(ExportManifest *manifest) { mManifest = manifest; }
+
+    /**
+     * Exports the source map of each job to its target file. Reports any
+     * errors as well as the time spent on each map.
+     *
+     * @return whether all maps were exported successfully
+     */
+    bool run();
+
+    QString errorString() const { return mError; }
+
+private:
+    struct Result
+    {
+        Result()
+            : loadTime(0)
+            , exportTime(0)
+            , upToDate(false)
+        {}
+
+        QString error;
+        qint64 loadTime;
+        qint64 exportTime;
+        bool upToDate;
+        ExportManifest::Entry manifestEntry;
+    };
+
+    static void exportMap(MapFormat *format, const Map *map,
+                          const Job &job, Result &result);
+
+    MapFormat *mFormat;
+    ExportManifest *mManifest;
+    QVector<Job> mJobs;
+    QString mError;
+};
+
+} // namespace Internal
+} // namespace Tiled
@@ -118,6 +118,8 @@ void BrokenLinksModel::setDocument(Document *document)
 
         connect(mDocument, &Document::ignoreBrokenLinksChanged,
                 this, &BrokenLinksModel::refresh);
+        connect(mDocument, &Document::loadingImagesChanged,
+                this, &BrokenLinksModel::refresh);
     }
 }
 
@@ -129,7 +131,7 @@ void BrokenLinksModel::refresh()
 
     mBrokenLinks.clear();
 
-    if (mDocument && !mDocument->ignoreBrokenLinks()) {
+    if (mDocument && !mDocument->ignoreBrokenLinks() && !mDocument->isLoadingImages()) {
         auto processTileset = [this](const SharedTileset &tileset) {
             if (tileset->isCollection()) {
                 for (Tile *tile : tileset->tiles()) {
@@ -20,6 +20,7 @@
 
 #include "changetileimagesource.h"
 
+#include "imagecache.h"
 #include "tilesetdocument.h"
 #include "tile.h"
 
@@ -43,7 +44,7 @@ ChangeTileImageSource::ChangeTileImageSource(TilesetDocument *tilesetDocument,
 void ChangeTileImageSource::apply(const QString &imageSource)
 {
     mTilesetDocument->setTileImage(mTile,
-                                   QPixmap(imageSource),
+                                   ImageCache::loadPixmap(imageSource),
                                    imageSource);
 }
 
@@ -22,6 +22,7 @@
 
 #include "object.h"
 #include "tile.h"
+#include "undomemorylimiter.h"
 
 #include <QFileInfo>
 #include <QUndoStack>
@@ -35,8 +36,10 @@ Document::Document(DocumentType type, const QString &fileName,
     , mType(type)
     , mFileName(fileName)
     , mUndoStack(new QUndoStack(this))
+    , mUndoMemoryLimiter(new UndoMemoryLimiter(mUndoStack))
     , mCurrentObject(nullptr)
     , mIgnoreBrokenLinks(false)
+    , mLoadingImages(false)
 {
     connect(mUndoStack, &QUndoStack::cleanChanged,
             this, &Document::modifiedChanged);
@@ -112,5 +115,14 @@ void Document::setIgnoreBrokenLinks(bool ignoreBrokenLinks)
     emit ignoreBrokenLinksChanged(ignoreBrokenLinks);
 }
 
+void Document::setLoadingImages(bool loadingImages)
+{
+    if (mLoadingImages == loadingImages)
+        return;
+
+    mLoadingImages = loadingImages;
+    emit loadingImagesChanged(loadingImages);
+}
+
 } // namespace Internal
 } // namespace Tiled
@@ -37,6 +37,8 @@ class Tile;
 
 namespace Internal {
 
+class UndoMemoryLimiter;
+
 /**
  * Keeps track of a file and its undo history.
  */
@@ -84,6 +86,7 @@ public:
     QDateTime lastSaved() const { return mLastSaved; }
 
     QUndoStack *undoStack() const;
+    UndoMemoryLimiter *undoMemoryLimiter() const;
     bool isModified() const;
 
     Object *currentObject() const { return mCurrentObject; }
@@ -98,6 +101,13 @@ public:
     bool ignoreBrokenLinks() const;
     void setIgnoreBrokenLinks(bool ignoreBrokenLinks);
 
+    /**
+     * Whether the images of this document are still being loaded, in which
+     * case missing images are not reported as broken links yet.
+     */
+    bool isLoadingImages() const;
+    void setLoadingImages(bool loadingImages);
+
 signals:
     void saved();
 
@@ -118,6 +128,7 @@ signals:
     void propertiesChanged(Object *object);
 
     void ignoreBrokenLinksChanged(bool ignoreBrokenLinks);
+    void loadingImagesChanged(bool loadingImages);
 
 protected:
     void setFileName(const QString &fileName);
@@ -125,11 +136,13 @@ protected:
     DocumentType mType;
     QString mFileName;
     QUndoStack *mUndoStack;
+    UndoMemoryLimiter *mUndoMemoryLimiter;
     QDateTime mLastSaved;
 
     Object *mCurrentObject;             /**< Current properties object. */
 
     bool mIgnoreBrokenLinks;
+    bool mLoadingImages;
 };
 
 
@@ -147,10 +160,24 @@ inline QUndoStack *Document::undoStack() const
     return mUndoStack;
 }
 
+/**
+ * Returns the object that keeps the memory used by the undo stack within
+ * limits. Commands holding on to a lot of memory should register with it.
+ */
+inline UndoMemoryLimiter *Document::undoMemoryLimiter() const
+{
+    return mUndoMemoryLimiter;
+}
+
 inline bool Document::ignoreBrokenLinks() const
 {
     return mIgnoreBrokenLinks;
 }
 
+inline bool Document::isLoadingImages() const
+{
+    return mLoadingImages;
+}
+
 } // namespace Internal
 } // namespace Tiled
@@ -241,6 +241,8 @@ void EditPolygonTool::mousePressed(QGraphicsSceneMouseEvent *event)
         mStart = event->scenePos();
         mScreenStart = event->screenPos();
 
+        mapScene()->materializeObjectItems(QRectF(mStart, mStart));
+
         const QList<QGraphicsItem *> items = mapScene()->items(mStart,
                                                                Qt::IntersectsItemShape,
                                                                Qt::DescendingOrder,
@@ -437,6 +439,9 @@ void EditPolygonTool::updateSelection(QGraphicsSceneMouseEvent *event)
 
     const QSet<MapObjectItem*> oldSelection = mapScene()->selectedObjectItems();
 
+    if (oldSelection.isEmpty())
+        mapScene()->materializeObjectItems(rect);
+
     const auto intersectedItems = mapScene()->items(rect,
                                                     Qt::IntersectsItemShape,
                                                     Qt::DescendingOrder,
@@ -0,0 +1,249 @@
+/*
+ * exportmanifest.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "exportmanifest.h"
+
+#include "imagelayer.h"
+#include "layer.h"
+#include "map.h"
+#include "savefile.h"
+#include "tile.h"
+#include "tileset.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+static const int ManifestVersion = 2;
+
+static QString absolutePath(const QString &fileName)
+{
+    return QFileInfo(fileName).absoluteFilePath();
+}
+
+ExportManifest::ExportManifest(const QString &fileName)
+    : mFileName(fileName)
+{
+}
+
+bool ExportManifest::load()
+{
+    mEntries.clear();
+
+    QFile file(mFileName);
+    if (!file.exists())
+        return true;
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        mError = tr("Could not open export manifest '%1': %2")
+                .arg(mFileName, file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    const QJsonObject root = document.object();
+
+    if (parseError.error != QJsonParseError::NoError ||
+            root.value(QLatin1String("version")).toInt() != ManifestVersion) {
+        mError = tr("Ignoring invalid export manifest '%1'").arg(mFileName);
+        return false;
+    }
+
+    const QJsonArray exports = root.value(QLatin1String("exports")).toArray();
+    for (const QJsonValue &value : exports) {
+        const QJsonObject object = value.toObject();
+
+        Entry entry;
+        entry.sourceFile = object.value(QLatin1String("source")).toString();
+        entry.format = object.value(QLatin1String("format")).toString();
+        entry.version = object.value(QLatin1String("tiled")).toString();
+        entry.options = object.value(QLatin1String("options")).toObject().toVariantMap();
+
+        const QJsonArray outputs = object.value(QLatin1String("outputs")).toArray();
+        for (const QJsonValue &output : outputs)
+            entry.outputFiles.append(output.toString());
+
+        const QJsonObject inputs = object.value(QLatin1String("inputs")).toObject();
+        for (auto it = inputs.constBegin(); it != inputs.constEnd(); ++it)
+            entry.inputs.insert(it.key(), it.value().toString().toLatin1());
+
+        mEntries.insert(object.value(QLatin1String("target")).toString(), entry);
+    }
+
+    return true;
+}
+
+bool ExportManifest::save()
+{
+    QStringList targetFiles = mEntries.keys();
+    targetFiles.sort();
+
+    QJsonArray exports;
+    for (const QString &targetFile : targetFiles) {
+        const Entry &entry = mEntries[targetFile];
+
+        QJsonObject inputs;
+        for (auto it = entry.inputs.constBegin(); it != entry.inputs.constEnd(); ++it)
+            inputs.insert(it.key(), QString::fromLatin1(it.value()));
+
+        QJsonObject object;
+        object.insert(QLatin1String("target"), targetFile);
+        object.insert(QLatin1String("source"), entry.sourceFile);
+        object.insert(QLatin1String("format"), entry.format);
+        object.insert(QLatin1String("tiled"), entry.version);
+        object.insert(QLatin1String("options"), QJsonObject::fromVariantMap(entry.options));
+        object.insert(QLatin1String("outputs"), QJsonArray::fromStringList(entry.outputFiles));
+        object.insert(QLatin1String("inputs"), inputs);
+
+        exports.append(object);
+    }
+
+    QJsonObject root;
+    root.insert(QLatin1String("version"), ManifestVersion);
+    root.insert(QLatin1String("exports"), exports);
+
+    SaveFile file(mFileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        mError = tr("Could not open export manifest '%1' for writing: %2")
+                .arg(mFileName, file.errorString());
+        return false;
+    }
+
+    file.device()->write(QJsonDocument(root).toJson());
+
+    if (!file.commit()) {
+        mError = tr("Could not write export manifest '%1': %2")
+                .arg(mFileName, file.errorString());
+        return false;
+    }
+
+    return true;
+}
+
+bool ExportManifest::isUpToDate(const QString &sourceFile,
+                                const QString &targetFile,
+                                const QString &format,
+                                const QVariantMap &options)
+{
+    const auto it = mEntries.constFind(absolutePath(targetFile));
+    if (it == mEntries.constEnd())
+        return false;
+
+    const Entry &entry = it.value();
+
+    if (entry.sourceFile != absolutePath(sourceFile) ||
+            entry.format != format ||
+            entry.options != options ||
+            entry.version != QCoreApplication::applicationVersion())
+        return false;
+
+    for (const QString &outputFile : entry.outputFiles)
+        if (!QFile::exists(outputFile))
+            return false;
+
+    for (auto input = entry.inputs.constBegin(); input != entry.inputs.constEnd(); ++input)
+        if (fileHash(input.key()) != input.value())
+            return false;
+
+    return true;
+}
+
+ExportManifest::Entry ExportManifest::createEntry(const Map *map,
+                                                  const QString &sourceFile,
+                                                  const QStringList &outputFiles,
+                                                  const QString &format,
+                                const QVariantMap &options)
+{
+    Entry entry;
+    entry.sourceFile = absolutePath(sourceFile);
+    entry.format = format;
+    entry.version = QCoreApplication::applicationVersion();
+
+    for (const QString &outputFile : outputFiles)
+        entry.outputFiles.append(absolutePath(outputFile));
+
+    QStringList inputs(entry.sourceFile);
+
+    for (const SharedTileset &tileset : map->tilesets()) {
+        if (!tileset->fileName().isEmpty())
+            inputs.append(tileset->fileName());
+        if (!tileset->imageSource().isEmpty())
+            inputs.append(tileset->imageSource());
+
+        for (const Tile *tile : tileset->tiles())
+            if (!tile->imageSource().isEmpty())
+                inputs.append(tile->imageSource());
+    }
+
+    LayerIterator iterator(map);
+    while (Layer *layer = iterator.next()) {
+        if (ImageLayer *imageLayer = layer->asImageLayer())
+            if (!imageLayer->imageSource().isEmpty())
+                inputs.append(imageLayer->imageSource());
+    }
+
+    for (const QString &input : inputs) {
+        const QString fileName = absolutePath(input);
+        entry.inputs.insert(fileName, fileHash(fileName));
+    }
+
+    return entry;
+}
+
+void ExportManifest::insert(const QString &targetFile, const Entry &entry)
+{
+    mEntries.insert(absolutePath(targetFile), entry);
+}
+
+void ExportManifest::remove(const QString &targetFile)
+{
+    mEntries.remove(absolutePath(targetFile));
+}
+
+/**
+ * Returns the hash of the contents of the given file, or an empty hash when
+ * the file can't be read. Hashes are computed only once, since many maps
+ * usually share the same tilesets.
+ */
+QByteArray ExportManifest::fileHash(const QString &fileName)
+{
+    auto it = mFileHashes.constFind(fileName);
+    if (it != mFileHashes.constEnd())
+        return it.value();
+
+    QByteArray hash;
+
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadOnly)) {
+        QCryptographicHash cryptographicHash(QCryptographicHash::Sha1);
+        if (cryptographicHash.addData(&file))
+            hash = cryptographicHash.result().toHex();
+    }
+
+    mFileHashes.insert(fileName, hash);
+    return hash;
+}
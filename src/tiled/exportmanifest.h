@@ -0,0 +1,113 @@
+/*
+ * exportmanifest.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+namespace Tiled {
+
+class Map;
+
+namespace Internal {
+
+/**
+ * Keeps track of exported maps, so that exporting can be skipped for maps
+ * that did not change since they were last exported. Used for the
+ * --incremental command line option.
+ *
+ * For each target file, the manifest stores the SHA-1 hash of the contents
+ * of each of the files that went into it: the map itself, its external
+ * tilesets and the images used by the tilesets and image layers. It also
+ * stores the export format, the writer options and the version of Tiled,
+ * since a change in any of them may change the output.
+ *
+ * Checking whether a target is up to date only requires hashing the files
+ * recorded in the manifest, without loading the map.
+ */
+class ExportManifest
+{
+    Q_DECLARE_TR_FUNCTIONS(ExportManifest)
+
+public:
+    struct Entry
+    {
+        QString sourceFile;
+        QString format;
+        QString version;
+        QVariantMap options;                // writer options affecting the output
+        QStringList outputFiles;
+        QMap<QString, QByteArray> inputs;   // file name -> hex encoded hash
+    };
+
+    explicit ExportManifest(const QString &fileName);
+
+    const QString &fileName() const { return mFileName; }
+
+    /**
+     * Loads the manifest. A missing manifest file is not an error, since it
+     * just means nothing was exported yet.
+     */
+    bool load();
+
+    /**
+     * Saves the manifest, replacing the previous one only once it has been
+     * written completely.
+     */
+    bool save();
+
+    /**
+     * Returns whether \a targetFile was exported from \a sourceFile to the
+     * given \a format using the same writer \a options, and none of the
+     * files it depends on have changed since.
+     */
+    bool isUpToDate(const QString &sourceFile, const QString &targetFile,
+                    const QString &format, const QVariantMap &options);
+
+    /**
+     * Creates an entry recording the files the given \a map depends on,
+     * along with their current hashes.
+     */
+    Entry createEntry(const Map *map, const QString &sourceFile,
+                      const QStringList &outputFiles, const QString &format,
+                      const QVariantMap &options);
+
+    void insert(const QString &targetFile, const Entry &entry);
+    void remove(const QString &targetFile);
+
+    QString errorString() const { return mError; }
+
+private:
+    QByteArray fileHash(const QString &fileName);
+
+    QString mFileName;
+    QHash<QString, Entry> mEntries;         // indexed by target file
+    QHash<QString, QByteArray> mFileHashes; // computed during this run
+    QString mError;
+};
+
+} // namespace Internal
+} // namespace Tiled
@@ -53,7 +53,7 @@ void MagicWandTool::tilePositionChanged(const QPoint &tilePos)
 
     TilePainter regionComputer(mapDocument(), tileLayer);
     mSelectedRegion = regionComputer.computeFillRegion(tilePos);
-    brushItem()->setTileRegion(mSelectedRegion);
+    brushItem()->setTileRegion(mSelectedRegion.toRegion());
 }
 
 void MagicWandTool::mousePressed(QGraphicsSceneMouseEvent *event)
@@ -66,24 +66,23 @@ void MagicWandTool::mousePressed(QGraphicsSceneMouseEvent *event)
 
     MapDocument *document = mapDocument();
 
-    QRegion selection;
+    TileMask selection;
 
     // Left button modifies selection, right button clears selection
     if (button == Qt::LeftButton) {
-        selection = document->selectedArea();
+        selection = mSelectedRegion;
 
         if (modifiers == Qt::ShiftModifier)
-            selection += mSelectedRegion;
+            selection += TileMask(document->selectedArea());
         else if (modifiers == Qt::ControlModifier)
-            selection -= mSelectedRegion;
+            selection = TileMask(document->selectedArea()).subtracted(mSelectedRegion);
         else if (modifiers == (Qt::ControlModifier | Qt::ShiftModifier))
-            selection &= mSelectedRegion;
-        else
-            selection = mSelectedRegion;
+            selection &= TileMask(document->selectedArea());
     }
 
-    if (selection != document->selectedArea()) {
-        QUndoCommand *cmd = new ChangeSelectedArea(document, selection);
+    const QRegion selectedArea = selection.toRegion();
+    if (selectedArea != document->selectedArea()) {
+        QUndoCommand *cmd = new ChangeSelectedArea(document, selectedArea);
         document->undoStack()->push(cmd);
     }
 }
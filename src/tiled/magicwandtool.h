@@ -53,7 +53,7 @@ protected:
 
 private:
 
-    QRegion mSelectedRegion;
+    TileMask mSelectedRegion;
 };
 
 } // namespace Internal
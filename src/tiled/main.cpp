@@ -20,6 +20,8 @@
  * this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "batchautomapper.h"
+#include "batchexporter.h"
 #include "commandlineparser.h"
 #include "languagemanager.h"
 #include "mainwindow.h"
@@ -71,6 +73,9 @@ public:
     bool showedVersion;
     bool disableOpenGL;
     bool exportMap;
+    bool exportMaps;
+    bool incremental;
+    bool autoMap;
     bool newInstance;
 
 private:
@@ -78,7 +83,10 @@ private:
     void justQuit();
     void setDisableOpenGL();
     void setExportMap();
+    void setExportMaps();
+    void setIncremental();
     void showExportFormats();
+    void setAutoMap();
     void startNewInstance();
 
     // Convenience wrapper around registerOption
@@ -102,6 +110,9 @@ CommandLineHandler::CommandLineHandler()
     , showedVersion(false)
     , disableOpenGL(false)
     , exportMap(false)
+    , exportMaps(false)
+    , incremental(false)
+    , autoMap(false)
     , newInstance(false)
 {
     option<&CommandLineHandler::showVersion>(
@@ -124,11 +135,26 @@ CommandLineHandler::CommandLineHandler()
                 QLatin1String("--export-map"),
                 tr("Export the specified tmx file to target"));
 
+    option<&CommandLineHandler::setExportMaps>(
+                QChar(),
+                QLatin1String("--export-maps"),
+                tr("Export any number of tmx files, or files matching a pattern, to targets"));
+
+    option<&CommandLineHandler::setIncremental>(
+                QChar(),
+                QLatin1String("--incremental"),
+                tr("Skip exporting maps that did not change, using the given manifest file"));
+
     option<&CommandLineHandler::showExportFormats>(
                 QChar(),
                 QLatin1String("--export-formats"),
                 tr("Print a list of supported export formats"));
 
+    option<&CommandLineHandler::setAutoMap>(
+                QChar(),
+                QLatin1String("--automap"),
+                tr("Apply the given AutoMapping rules to the given maps"));
+
     option<&CommandLineHandler::startNewInstance>(
                 QChar(),
                 QLatin1String("--new-instance"),
@@ -160,6 +186,16 @@ void CommandLineHandler::setExportMap()
     exportMap = true;
 }
 
+void CommandLineHandler::setExportMaps()
+{
+    exportMaps = true;
+}
+
+void CommandLineHandler::setIncremental()
+{
+    incremental = true;
+}
+
 void CommandLineHandler::showExportFormats()
 {
     PluginManager::instance()->loadPlugins();
@@ -174,12 +210,61 @@ void CommandLineHandler::showExportFormats()
     quit = true;
 }
 
+void CommandLineHandler::setAutoMap()
+{
+    autoMap = true;
+}
+
 void CommandLineHandler::startNewInstance()
 {
     newInstance = true;
 }
 
 
+/**
+ * Returns the writable map format with the given short name, or when
+ * \a formatName is empty, the one matching the extension of \a targetFile.
+ * Reports the problem and returns null when no unique format was found.
+ */
+static MapFormat *findExportFormat(const QString &formatName,
+                                   const QString &targetFile)
+{
+    MapFormat *chosenFormat = nullptr;
+    auto formats = PluginManager::objects<MapFormat>();
+
+    if (!formatName.isEmpty()) {
+        // Find the map format supporting the given filter
+        for (MapFormat *format : formats) {
+            if (!format->hasCapabilities(MapFormat::Write))
+                continue;
+            if (format->shortName().compare(formatName, Qt::CaseInsensitive) == 0) {
+                chosenFormat = format;
+                break;
+            }
+        }
+        if (!chosenFormat)
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Format not recognized (see --export-formats)");
+    } else {
+        // Find the map format based on target file extension
+        QString suffix = QFileInfo(targetFile).completeSuffix();
+        for (MapFormat *format : formats) {
+            if (!format->hasCapabilities(MapFormat::Write))
+                continue;
+            if (format->nameFilter().contains(suffix, Qt::CaseInsensitive)) {
+                if (chosenFormat) {
+                    qWarning().noquote() << QCoreApplication::translate("Command line", "Non-unique file extension. Can't determine correct export format.");
+                    return nullptr;
+                }
+                chosenFormat = format;
+            }
+        }
+        if (!chosenFormat)
+            qWarning().noquote() << QCoreApplication::translate("Command line", "No exporter found for target file.");
+    }
+
+    return chosenFormat;
+}
+
 int main(int argc, char *argv[])
 {
 #if defined(Q_OS_WIN) && (!defined(Q_CC_MINGW) || __MINGW32_MAJOR_VERSION >= 5)
@@ -243,46 +328,13 @@ int main(int argc, char *argv[])
             return 1;
         }
         int index = 0;
-        const QString *filter = commandLine.filesToOpen().length() > 2 ? &commandLine.filesToOpen().at(index++) : nullptr;
+        const QString filter = commandLine.filesToOpen().length() > 2 ? commandLine.filesToOpen().at(index++) : QString();
         const QString &sourceFile = commandLine.filesToOpen().at(index++);
         const QString &targetFile = commandLine.filesToOpen().at(index++);
 
-        MapFormat *chosenFormat = nullptr;
-        auto formats = PluginManager::objects<MapFormat>();
-
-        if (filter) {
-            // Find the map format supporting the given filter
-            for (MapFormat *format : formats) {
-                if (!format->hasCapabilities(MapFormat::Write))
-                    continue;
-                if (format->shortName().compare(*filter, Qt::CaseInsensitive) == 0) {
-                    chosenFormat = format;
-                    break;
-                }
-            }
-            if (!chosenFormat) {
-                qWarning().noquote() << QCoreApplication::translate("Command line", "Format not recognized (see --export-formats)");
-                return 1;
-            }
-        } else {
-            // Find the map format based on target file extension
-            QString suffix = QFileInfo(targetFile).completeSuffix();
-            for (MapFormat *format : formats) {
-                if (!format->hasCapabilities(MapFormat::Write))
-                    continue;
-                if (format->nameFilter().contains(suffix, Qt::CaseInsensitive)) {
-                    if (chosenFormat) {
-                        qWarning().noquote() << QCoreApplication::translate("Command line", "Non-unique file extension. Can't determine correct export format.");
-                        return 1;
-                    }
-                    chosenFormat = format;
-                }
-            }
-            if (!chosenFormat) {
-                qWarning().noquote() << QCoreApplication::translate("Command line", "No exporter found for target file.");
-                return 1;
-            }
-        }
+        MapFormat *chosenFormat = findExportFormat(filter, targetFile);
+        if (!chosenFormat)
+            return 1;
 
         // Load the source file
         MapReader reader;
@@ -302,6 +354,86 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (commandLine.exportMaps) {
+        // Expecting an optional manifest file and format, followed by pairs
+        // of source and target
+        QStringList files = commandLine.filesToOpen();
+
+        QScopedPointer<ExportManifest> manifest;
+        if (commandLine.incremental && !files.isEmpty())
+            manifest.reset(new ExportManifest(files.takeFirst()));
+
+        if (files.length() < 2) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Batch export syntax is --export-maps [--incremental <manifest file>] [format] <tmx file or pattern> <target file or directory> [<tmx file or pattern> <target file or directory>...]");
+            return 1;
+        }
+
+        int index = files.length() % 2;
+        const QString formatName = index ? files.first() : QString();
+
+        // When exporting a pattern, the target is a directory, from which
+        // the format can't be derived
+        if (formatName.isEmpty()) {
+            for (int i = index; i < files.length(); i += 2) {
+                if (BatchExporter::isPattern(files.at(i))) {
+                    qWarning().noquote() << QCoreApplication::translate("Command line", "A format is required when exporting maps matching a pattern (see --export-formats)");
+                    return 1;
+                }
+            }
+        }
+
+        MapFormat *chosenFormat = findExportFormat(formatName, files.at(index + 1));
+        if (!chosenFormat)
+            return 1;
+
+        if (manifest && !manifest->load())
+            qWarning().noquote() << manifest->errorString();
+
+        BatchExporter batchExporter(chosenFormat);
+        batchExporter.setManifest(manifest.data());
+
+        for (; index < files.length(); index += 2) {
+            if (!batchExporter.addJob(files.at(index), files.at(index + 1))) {
+                qWarning().noquote() << batchExporter.errorString();
+                return 1;
+            }
+        }
+
+        const bool success = batchExporter.run();
+
+        if (manifest && !manifest->save()) {
+            qWarning().noquote() << manifest->errorString();
+            return 1;
+        }
+
+        return success ? 0 : 1;
+    }
+
+    if (commandLine.autoMap) {
+        // Expecting the rules file followed by pairs of source and target maps
+        const QStringList &files = commandLine.filesToOpen();
+        if (files.length() < 3 || files.length() % 2 == 0) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "AutoMapping syntax is --automap <rules file> <tmx file> <target file> [<tmx file> <target file>...]");
+            return 1;
+        }
+
+        BatchAutoMapper batchAutoMapper;
+        batchAutoMapper.setDtdEnabled(Preferences::instance()->dtdEnabled());
+
+        if (!batchAutoMapper.loadRules(files.first())) {
+            qWarning().noquote() << batchAutoMapper.errorString().trimmed();
+            return 1;
+        }
+        if (!batchAutoMapper.warningString().isEmpty())
+            qWarning().noquote() << batchAutoMapper.warningString().trimmed();
+
+        QVector<BatchAutoMapper::Job> jobs;
+        for (int i = 1; i < files.length(); i += 2)
+            jobs.append(BatchAutoMapper::Job { files.at(i), files.at(i + 1) });
+
+        return batchAutoMapper.run(jobs) ? 0 : 1;
+    }
+
     if (!commandLine.filesToOpen().isEmpty() && !commandLine.newInstance) {
         // Convert files to absolute paths because the already running Tiled
         // instance likely does not have the same working directory.
@@ -44,6 +44,7 @@
 #include "mapeditor.h"
 #include "mapformat.h"
 #include "map.h"
+#include "maploader.h"
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "mapscene.h"
@@ -77,12 +78,15 @@
 #include <QCloseEvent>
 #include <QDesktopServices>
 #include <QFileDialog>
+#include <QHBoxLayout>
 #include <QLabel>
 #include <QMessageBox>
 #include <QMimeData>
+#include <QProgressBar>
 #include <QRegExp>
 #include <QSessionManager>
 #include <QShortcut>
+#include <QStatusBar>
 #include <QTextStream>
 #include <QToolBar>
 #include <QToolButton>
@@ -588,6 +592,10 @@ bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat)
         return true;
     }
 
+    // Ignore the request when this file is still being loaded
+    if (mMapLoaders.contains(fileName))
+        return true;
+
     if (!fileFormat) {
         // Try to find a plugin that implements support for this format
         const auto formats = PluginManager::objects<FileFormat>();
@@ -604,6 +612,13 @@ bool MainWindow::openFile(const QString &fileName, FileFormat *fileFormat)
         return false;
     }
 
+    // Maps in TMX format are loaded in the background, which allows them to
+    // be shown before all their images have been loaded
+    if (TmxMapFormat *tmxMapFormat = qobject_cast<TmxMapFormat*>(fileFormat)) {
+        loadMapInBackground(fileName, tmxMapFormat);
+        return true;
+    }
+
     QString error;
     Document *document = nullptr;
 
@@ -637,6 +652,72 @@ bool MainWindow::openFile(const QString &fileName)
     return openFile(fileName, nullptr);
 }
 
+void MainWindow::loadMapInBackground(const QString &fileName, MapFormat *format)
+{
+    MapLoader *mapLoader = new MapLoader(fileName, format, this);
+    mMapLoaders.insert(fileName, mapLoader);
+
+    // Show the progress in the status bar, with an option to cancel
+    QWidget *progressWidget = new QWidget;
+    QLabel *label = new QLabel(tr("Loading %1").arg(QFileInfo(fileName).fileName()));
+    QProgressBar *progressBar = new QProgressBar;
+    progressBar->setRange(0, 0);
+    progressBar->setMaximumWidth(Utils::dpiScaled(150));
+    QToolButton *cancelButton = new QToolButton;
+    cancelButton->setText(tr("Cancel"));
+    cancelButton->setAutoRaise(true);
+
+    QHBoxLayout *layout = new QHBoxLayout(progressWidget);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(label);
+    layout->addWidget(progressBar);
+    layout->addWidget(cancelButton);
+
+    statusBar()->addPermanentWidget(progressWidget);
+    statusBar()->show();
+
+    connect(cancelButton, &QToolButton::clicked, mapLoader, &MapLoader::cancel);
+
+    connect(mapLoader, &MapLoader::progressChanged,
+            progressBar, [progressBar] (int loadedImages, int totalImages) {
+        progressBar->setRange(0, totalImages);
+        progressBar->setValue(loadedImages);
+    });
+
+    connect(mapLoader, &MapLoader::mapDocumentReady,
+            this, [this,fileName] (MapDocument *mapDocument) {
+        mDocumentManager->addDocument(mapDocument);
+        Preferences::instance()->addRecentFile(fileName);
+
+        // While restoring the previous session, keep the document that was
+        // last active current
+        if (!mLastActiveDocument.isEmpty()) {
+            int documentIndex = mDocumentManager->findDocument(mLastActiveDocument);
+            if (documentIndex != -1)
+                mDocumentManager->switchToDocument(documentIndex);
+        }
+    });
+
+    connect(mapLoader, &MapLoader::failed,
+            this, [this] (const QString &error) {
+        QMessageBox::critical(this, tr("Error Opening File"), error);
+    });
+
+    connect(mapLoader, &MapLoader::finished,
+            this, [this,mapLoader,progressWidget] {
+        mMapLoaders.remove(mapLoader->fileName());
+        mapLoader->deleteLater();
+        progressWidget->deleteLater();
+
+        if (mMapLoaders.isEmpty()) {
+            mLastActiveDocument.clear();
+            statusBar()->hide();
+        }
+    });
+
+    mapLoader->start();
+}
+
 void MainWindow::openLastFiles()
 {
     mSettings.beginGroup(QLatin1String("recentFiles"));
@@ -665,6 +746,10 @@ void MainWindow::openLastFiles()
     if (documentIndex != -1)
         mDocumentManager->switchToDocument(documentIndex);
 
+    // Maps that are still loading are added as they become ready
+    if (!mMapLoaders.isEmpty())
+        mLastActiveDocument = lastActiveDocument;
+
     mSettings.endGroup();
 }
 
@@ -29,6 +29,7 @@
 #include "preferences.h"
 #include "preferencesdialog.h"
 
+#include <QHash>
 #include <QMainWindow>
 #include <QPointer>
 #include <QSessionManager>
@@ -44,6 +45,7 @@ class MainWindow;
 namespace Tiled {
 
 class FileFormat;
+class MapFormat;
 class TileLayer;
 class Terrain;
 
@@ -56,6 +58,7 @@ class MapDocumentActionHandler;
 class MapScene;
 class MapView;
 class ObjectTypesEditor;
+class MapLoader;
 class TmxMapFormat;
 class TsxTilesetFormat;
 class Zoomable;
@@ -185,6 +188,8 @@ private:
       */
     bool confirmAllSave();
 
+    void loadMapInBackground(const QString &fileName, MapFormat *format);
+
     void writeSettings();
     void readSettings();
 
@@ -222,6 +227,9 @@ private:
 
     QPointer<PreferencesDialog> mPreferencesDialog;
 
+    QHash<QString, MapLoader*> mMapLoaders;
+    QString mLastActiveDocument;
+
     QMap<QMainWindow*, QByteArray> mMainWindowStates;
 };
 
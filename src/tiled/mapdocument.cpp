@@ -110,6 +110,9 @@ MapDocument::MapDocument(Map *map, const QString &fileName)
     connect(mMapObjectModel, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
             SLOT(onObjectsMoved(QModelIndex,int,int,QModelIndex,int)));
 
+    connect(this, &MapDocument::tilesetTileOffsetChanged,
+            this, &MapDocument::onTilesetTileOffsetChanged);
+
     // Register tileset references
     TilesetManager *tilesetManager = TilesetManager::instance();
     tilesetManager->addReferences(mMap->tilesets());
@@ -850,6 +853,14 @@ void MapDocument::onObjectsMoved(const QModelIndex &parent, int start, int end,
     emit objectsIndexChanged(objectGroup, first, last);
 }
 
+void MapDocument::onTilesetTileOffsetChanged(Tileset *tileset)
+{
+    // The spatial index of object groups includes the tile offset
+    for (ObjectGroup *objectGroup : mMap->objectGroups())
+        if (objectGroup->referencesTileset(tileset))
+            objectGroup->invalidateObjectIndex();
+}
+
 void MapDocument::onLayerAdded(Layer *layer)
 {
     emit layerAdded(layer);
@@ -298,6 +298,7 @@ private slots:
     void onObjectsMoved(const QModelIndex &parent, int start, int end,
                         const QModelIndex &destination, int row);
 
+    void onTilesetTileOffsetChanged(Tileset *tileset);
     void onLayerAdded(Layer *layer);
     void onLayerAboutToBeRemoved(GroupLayer *groupLayer, int index);
     void onLayerRemoved(Layer *layer);
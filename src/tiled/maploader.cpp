@@ -0,0 +1,467 @@
+/*
+ * maploader.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "maploader.h"
+
+#include "documentmanager.h"
+#include "imagecache.h"
+#include "imagedecoder.h"
+#include "imagelayer.h"
+#include "layer.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "mapformat.h"
+#include "mapobject.h"
+#include "mapobjectmodel.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilesetformat.h"
+#include "tilesetmanager.h"
+
+#include <QPixmap>
+#include <QtConcurrentRun>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+/**
+ * Reads a map without loading any images, so that it can be used on a worker
+ * thread. External tilesets in TSX format are read the same way, while other
+ * tileset formats are left to the GUI thread.
+ */
+class BackgroundMapReader : public MapReader
+{
+public:
+    BackgroundMapReader()
+    {
+        setImageLoadingEnabled(false);
+    }
+
+    QVector<PendingImage> mTilesetImages;
+
+protected:
+    SharedTileset readExternalTileset(const QString &source,
+                                      QString *error) override
+    {
+        // Returning null inserts a placeholder tileset, which is loaded
+        // through the TilesetManager after the map has been read.
+        if (!source.endsWith(QLatin1String(".tsx"), Qt::CaseInsensitive))
+            return SharedTileset();
+
+        MapReader reader;
+        reader.setImageLoadingEnabled(false);
+
+        SharedTileset tileset = reader.readTileset(source);
+        if (tileset)
+            mTilesetImages += reader.pendingImages();
+        else
+            *error = reader.errorString();
+
+        return tileset;
+    }
+};
+
+} // anonymous namespace
+
+static MapLoader::ReadResult readMapInBackground(const QString &fileName)
+{
+    BackgroundMapReader reader;
+
+    MapLoader::ReadResult result;
+    result.map = reader.readMap(fileName);
+
+    if (result.map) {
+        result.pendingImages = reader.pendingImages();
+        result.pendingImages += reader.mTilesetImages;
+    } else {
+        result.error = reader.errorString();
+    }
+
+    return result;
+}
+
+/**
+ * Returns whether any of the images of the given tileset failed to load or
+ * have not been loaded yet.
+ */
+static bool hasMissingImages(const Tileset &tileset)
+{
+    if (!tileset.isCollection())
+        return !tileset.imageLoaded();
+
+    for (const Tile *tile : tileset.tiles())
+        if (!tile->imageLoaded())
+            return true;
+
+    return false;
+}
+
+
+MapLoader::MapLoader(const QString &fileName, MapFormat *format,
+                     QObject *parent)
+    : QObject(parent)
+    , mFileName(fileName)
+    , mFormat(format)
+    , mCanceled(false)
+    , mImageCount(0)
+    , mLoadedImageCount(0)
+    , mFinished(false)
+{
+    mFlushTimer.setInterval(100);
+    mFlushTimer.setSingleShot(true);
+
+    connect(&mReadWatcher, &QFutureWatcherBase::finished,
+            this, &MapLoader::mapRead);
+    connect(&mFlushTimer, &QTimer::timeout,
+            this, &MapLoader::flushChanges);
+    connect(TilesetManager::instance()->imageDecoder(), &ImageDecoder::imageDecoded,
+            this, &MapLoader::imageDecoded);
+}
+
+MapLoader::~MapLoader()
+{
+    stopDecoding();
+
+    // The map is owned by the loader until the document has been created
+    if (mReadWatcher.isRunning()) {
+        mReadWatcher.disconnect(this);
+        mReadWatcher.waitForFinished();
+        delete mReadWatcher.result().map;
+    }
+}
+
+void MapLoader::start()
+{
+    mReadWatcher.setFuture(QtConcurrent::run(readMapInBackground, mFileName));
+}
+
+void MapLoader::cancel()
+{
+    if (mFinished)
+        return;
+
+    mCanceled = true;
+
+    // When still reading, the map is discarded once it has been read
+    if (mReadWatcher.isRunning())
+        return;
+
+    stopDecoding();
+
+    // A document that was already edited is kept open, with the images that
+    // were loaded so far, since closing it would lose the changes
+    if (mMapDocument && !mMapDocument->isModified()) {
+        DocumentManager *documentManager = DocumentManager::instance();
+        MapDocument *mapDocument = mMapDocument;
+        const int index = documentManager->documents().indexOf(mapDocument);
+        mMapDocument = nullptr;
+
+        if (index != -1)
+            documentManager->closeDocumentAt(index);
+        else
+            delete mapDocument;
+    }
+
+    finish();
+}
+
+void MapLoader::mapRead()
+{
+    ReadResult result = mReadWatcher.result();
+
+    if (mCanceled || !mFormat) {
+        delete result.map;
+        finish();
+        return;
+    }
+
+    if (!result.map) {
+        emit failed(result.error);
+        finish();
+        return;
+    }
+
+    const QVector<MapReader::PendingImage> pendingImages =
+            resolveExternalTilesets(result);
+
+    MapDocument *mapDocument = new MapDocument(result.map, mFileName);
+    mapDocument->setReaderFormat(mFormat);
+    if (mFormat->hasCapabilities(MapFormat::Write))
+        mapDocument->setWriterFormat(mFormat);
+
+    // Images that have not been loaded yet are not broken links
+    mapDocument->setLoadingImages(true);
+
+    mMapDocument = mapDocument;
+
+    connect(DocumentManager::instance(), &DocumentManager::documentAboutToClose,
+            this, &MapLoader::documentAboutToClose);
+
+    emit mapDocumentReady(mapDocument);
+
+    // The document may have been closed in response to the above signal
+    if (mFinished)
+        return;
+
+    startDecoding(pendingImages);
+}
+
+/**
+ * Replaces the external tilesets of the map that are already loaded with the
+ * loaded instances, and loads the tilesets that could not be read on the
+ * worker thread.
+ *
+ * Returns the pending images that still need to be loaded.
+ */
+QVector<MapReader::PendingImage> MapLoader::resolveExternalTilesets(ReadResult &result)
+{
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    QVector<MapReader::PendingImage> pendingImages = result.pendingImages;
+
+    const QVector<SharedTileset> tilesets = result.map->tilesets();
+    for (const SharedTileset &tileset : tilesets) {
+        if (tileset->fileName().isEmpty()) {
+            mTilesets.append(tileset);
+            continue;
+        }
+
+        SharedTileset replacement = tilesetManager->findTileset(tileset->fileName());
+
+        if (!replacement && !tileset->loaded()) {
+            replacement = tilesetManager->loadTileset(tileset->fileName());
+            if (!replacement)
+                continue;
+        }
+
+        if (!replacement) {
+            // Read in the background, so still needs its format
+            tileset->setFormat(findSupportingFormat(tileset->fileName()));
+            mTilesets.append(tileset);
+            continue;
+        }
+
+        result.map->replaceTileset(tileset, replacement);
+
+        // An already loaded tileset may still be waiting for its images,
+        // in which case they are loaded here as well.
+        const bool loadImages = hasMissingImages(*replacement);
+        if (loadImages)
+            mTilesets.append(replacement);
+
+        for (int i = pendingImages.size() - 1; i >= 0; --i) {
+            MapReader::PendingImage &pendingImage = pendingImages[i];
+            if (pendingImage.tileset != tileset.data())
+                continue;
+
+            if (loadImages)
+                pendingImage.tileset = replacement.data();
+            else
+                pendingImages.remove(i);
+        }
+    }
+
+    return pendingImages;
+}
+
+void MapLoader::startDecoding(const QVector<MapReader::PendingImage> &pendingImages)
+{
+    // The decoder combines requests for the same image file, also when they
+    // are made by other maps being loaded
+    ImageDecoder *imageDecoder = TilesetManager::instance()->imageDecoder();
+
+    for (const MapReader::PendingImage &pendingImage : pendingImages) {
+        auto it = mPendingImages.find(pendingImage.reference.source);
+        if (it == mPendingImages.end() || pendingImage.reference.source.isEmpty()) {
+            const QString key = imageDecoder->request(pendingImage.reference);
+            it = mPendingImages.insert(key, QVector<MapReader::PendingImage>());
+        }
+        it->append(pendingImage);
+    }
+
+    mImageCount = mPendingImages.size();
+    emit progressChanged(mLoadedImageCount, mImageCount);
+
+    if (mPendingImages.isEmpty())
+        finish();
+}
+
+void MapLoader::imageDecoded(const QString &key, const QImage &image)
+{
+    auto it = mPendingImages.find(key);
+    if (it == mPendingImages.end())
+        return;
+
+    const QVector<MapReader::PendingImage> users = *it;
+    mPendingImages.erase(it);
+
+    for (const MapReader::PendingImage &pendingImage : users)
+        applyImage(pendingImage, image);
+
+    ++mLoadedImageCount;
+
+    if (mPendingImages.isEmpty())
+        finish();
+    else if (!mFlushTimer.isActive())
+        mFlushTimer.start();
+}
+
+void MapLoader::applyImage(const MapReader::PendingImage &pendingImage,
+                           const QImage &image)
+{
+    const QString &source = pendingImage.reference.source;
+
+    if (Tileset *tileset = pendingImage.tileset) {
+        if (pendingImage.tileId == -1) {
+            tileset->loadFromImage(image, source);
+        } else if (Tile *tile = tileset->findTile(pendingImage.tileId)) {
+            QPixmap pixmap;
+            if (!image.isNull()) {
+                pixmap = source.isEmpty() ? QPixmap::fromImage(image)
+                                          : ImageCache::loadPixmap(source);
+            }
+            if (tileset->isCollection())
+                tileset->setTileImage(tile, pixmap, source);
+            else
+                tile->setImage(pixmap);
+        }
+
+        mChangedTilesets.insert(tileset);
+    } else if (ImageLayer *imageLayer = pendingImage.imageLayer) {
+        // The layer may have been removed from the map in the meantime
+        LayerIterator iterator(mMapDocument->map());
+        while (Layer *layer = iterator.next()) {
+            if (layer->asImageLayer() == imageLayer) {
+                imageLayer->loadFromImage(image, source);
+                mChangedImageLayers.insert(imageLayer);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Lets the views know about the images that were loaded since the last call.
+ * This is throttled, since repainting the map for each image would slow down
+ * loading maps that use many images.
+ */
+void MapLoader::flushChanges()
+{
+    mFlushTimer.stop();
+
+    if (!mMapDocument)
+        return;
+
+    TilesetManager *tilesetManager = TilesetManager::instance();
+
+    if (!mChangedTilesets.isEmpty())
+        mMapDocument->map()->invalidateDrawMargins();
+
+    for (Tileset *tileset : mChangedTilesets) {
+        emit tilesetManager->tilesetImagesChanged(tileset);
+        emit mMapDocument->tilesetTileOffsetChanged(tileset);
+    }
+
+    for (ImageLayer *imageLayer : mChangedImageLayers)
+        emit mMapDocument->imageLayerChanged(imageLayer);
+
+    mChangedTilesets.clear();
+    mChangedImageLayers.clear();
+
+    emit progressChanged(mLoadedImageCount, mImageCount);
+}
+
+void MapLoader::documentAboutToClose(Document *document)
+{
+    if (document != mMapDocument)
+        return;
+
+    mMapDocument = nullptr;
+    stopDecoding();
+    finish();
+}
+
+void MapLoader::stopDecoding()
+{
+    // Images that are no longer needed by anyone are not decoded
+    if (!mPendingImages.isEmpty()) {
+        ImageDecoder *imageDecoder = TilesetManager::instance()->imageDecoder();
+        for (auto it = mPendingImages.constBegin(); it != mPendingImages.constEnd(); ++it)
+            imageDecoder->release(it.key());
+
+        mPendingImages.clear();
+    }
+
+    mFlushTimer.stop();
+    mChangedTilesets.clear();
+    mChangedImageLayers.clear();
+}
+
+void MapLoader::finish()
+{
+    if (mFinished)
+        return;
+
+    if (mMapDocument) {
+        flushChanges();
+
+        // Now that the tile images are known, apply their size to tile
+        // objects that do not specify a size
+        QList<MapObject*> changedObjects;
+
+        LayerIterator iterator(mMapDocument->map());
+        while (Layer *layer = iterator.next()) {
+            ObjectGroup *objectGroup = layer->asObjectGroup();
+            if (!objectGroup)
+                continue;
+
+            for (MapObject *object : *objectGroup) {
+                const Tile *tile = object->cell().tile();
+                if (!tile || (object->width() != 0 && object->height() != 0))
+                    continue;
+
+                const QSizeF tileSize = tile->size();
+                if (object->width() == 0)
+                    object->setWidth(tileSize.width());
+                if (object->height() == 0)
+                    object->setHeight(tileSize.height());
+
+                changedObjects.append(object);
+            }
+        }
+
+        if (!changedObjects.isEmpty())
+            mMapDocument->mapObjectModel()->emitObjectsChanged(changedObjects);
+
+        // Images that failed to load now show up as broken links
+        mMapDocument->setLoadingImages(false);
+
+        DocumentManager::instance()->checkTilesetColumns(mMapDocument);
+    }
+
+    mFinished = true;
+    mTilesets.clear();
+
+    disconnect(DocumentManager::instance(), &DocumentManager::documentAboutToClose,
+               this, &MapLoader::documentAboutToClose);
+
+    emit finished();
+}
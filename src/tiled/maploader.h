@@ -0,0 +1,159 @@
+/*
+ * maploader.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mapreader.h"
+#include "tileset.h"
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+namespace Tiled {
+
+class ImageLayer;
+class Map;
+class MapFormat;
+
+namespace Internal {
+
+class Document;
+class MapDocument;
+
+/**
+ * Loads a map in the background, so that it can be shown before all of its
+ * images have been loaded.
+ *
+ * The map file and its external TSX tilesets are read on a worker thread,
+ * without loading any images. As soon as the structure of the map is known,
+ * a MapDocument is created and mapDocumentReady() is emitted. The images used
+ * by the tilesets and image layers are then decoded in parallel by the
+ * ImageDecoder of the TilesetManager, and applied to the map as they become
+ * available. The images of tiles in image collection tilesets are only
+ * loaded once they are used.
+ *
+ * The loader stays responsible for the document until finished() is emitted.
+ * Loading can be cancelled at any time, in which case the document is closed
+ * unless it was already modified.
+ */
+class MapLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    MapLoader(const QString &fileName, MapFormat *format,
+              QObject *parent = nullptr);
+    ~MapLoader();
+
+    const QString &fileName() const { return mFileName; }
+
+    /**
+     * Returns the document of the map being loaded, or null when the map has
+     * not been read yet.
+     */
+    MapDocument *mapDocument() const { return mMapDocument; }
+
+    int imageCount() const { return mImageCount; }
+    int loadedImageCount() const { return mLoadedImageCount; }
+
+    bool isFinished() const { return mFinished; }
+
+    void start();
+
+public slots:
+    /**
+     * Stops loading the map. When the document was already created, it is
+     * closed, unless it was modified in the meantime. A modified document is
+     * kept open with the images that were loaded so far.
+     */
+    void cancel();
+
+signals:
+    /**
+     * Emitted when the map has been read. The receiver should add the
+     * \a mapDocument to the DocumentManager, which takes ownership of it.
+     */
+    void mapDocumentReady(MapDocument *mapDocument);
+
+    void progressChanged(int loadedImages, int totalImages);
+
+    /**
+     * Emitted when the map could not be read.
+     */
+    void failed(const QString &error);
+
+    /**
+     * Emitted when the loader is done, including when loading failed or was
+     * cancelled.
+     */
+    void finished();
+
+private slots:
+    void mapRead();
+    void imageDecoded(const QString &key, const QImage &image);
+    void flushChanges();
+    void documentAboutToClose(Document *document);
+
+public:
+    struct ReadResult
+    {
+        ReadResult() : map(nullptr) {}
+
+        Map *map;
+        QVector<MapReader::PendingImage> pendingImages;
+        QString error;
+    };
+
+private:
+    QVector<MapReader::PendingImage> resolveExternalTilesets(ReadResult &result);
+    void startDecoding(const QVector<MapReader::PendingImage> &pendingImages);
+    void applyImage(const MapReader::PendingImage &pendingImage,
+                    const QImage &image);
+    void stopDecoding();
+    void finish();
+
+    QString mFileName;
+    QPointer<MapFormat> mFormat;
+    QPointer<MapDocument> mMapDocument;
+
+    QFutureWatcher<ReadResult> mReadWatcher;
+    QHash<QString, QVector<MapReader::PendingImage>> mPendingImages;
+    bool mCanceled;
+
+    // Keeps the tilesets receiving images alive while loading
+    QVector<SharedTileset> mTilesets;
+
+    QSet<Tileset*> mChangedTilesets;
+    QSet<ImageLayer*> mChangedImageLayers;
+    QTimer mFlushTimer;
+
+    int mImageCount;
+    int mLoadedImageCount;
+    bool mFinished;
+};
+
+} // namespace Internal
+} // namespace Tiled
@@ -60,6 +60,24 @@ using namespace Tiled::Internal;
 static const qreal darkeningFactor = 0.6;
 static const qreal opacityFactor = 0.4;
 
+// When a map has at least this many objects, its object groups are drawn by
+// their ObjectGroupItem rather than using an item for each object. This also
+// applies to individual object groups of this size.
+static const int batchedObjectThreshold = 5000;
+
+// The number of unselected on-demand object items (for example, the ones
+// created while hovering) that are kept around before releasing them.
+static const int maxIdleObjectItems = 256;
+
+// Items are created for the objects of batched object groups within this
+// distance from the visible area, relative to its size. They are released
+// again once they are more than twice this distance away.
+static const qreal viewportObjectItemsMargin = 0.5;
+
+// When more objects are near the visible area, for example because the view
+// is zoomed out, no items are created for them in advance.
+static const int maxViewportObjectItems = 1000;
+
 MapScene::MapScene(QObject *parent):
     QGraphicsScene(parent),
     mMapDocument(nullptr),
@@ -68,7 +86,10 @@ MapScene::MapScene(QObject *parent):
     mUnderMouse(false),
     mCurrentModifiers(Qt::NoModifier),
     mDarkRectangle(new QGraphicsRectItem),
-    mObjectSelectionItem(nullptr)
+    mObjectSelectionItem(nullptr),
+    mBatchObjectGroups(false),
+    mOnDemandReleaseThreshold(maxIdleObjectItems),
+    mViewportObjectItemsUpdatePending(false)
 {
     updateDefaultBackgroundColor();
 
@@ -118,6 +139,8 @@ void MapScene::setMapDocument(MapDocument *mapDocument)
             mSelectedObjectItems.clear();
             emit selectedObjectItemsChanged();
         }
+
+        mOnDemandObjectItems.clear();
     }
 
     mMapDocument = mapDocument;
@@ -178,6 +201,44 @@ void MapScene::setSelectedObjectItems(const QSet<MapObjectItem *> &items)
     mMapDocument->setSelectedObjects(selectedObjects);
 }
 
+MapObjectItem *MapScene::itemForObject(MapObject *object)
+{
+    if (MapObjectItem *item = mObjectItems.value(object))
+        return item;
+
+    ObjectGroup *objectGroup = object->objectGroup();
+    if (!objectGroup)
+        return nullptr;
+
+    ObjectGroupItem *ogItem = itemForObjectGroup(objectGroup);
+    if (!ogItem || !ogItem->isBatched())
+        return nullptr;
+
+    MapObjectItem *item = createObjectItem(object, ogItem,
+                                           ogItem->indexOfObject(object));
+    mOnDemandObjectItems.insert(item);
+    return item;
+}
+
+void MapScene::materializeObjectItems(const QRectF &rect)
+{
+    if (!mMapDocument)
+        return;
+
+    const auto objects = batchedObjectsInRect(rect);
+    for (MapObject *object : objects)
+        itemForObject(object);
+}
+
+void MapScene::setVisibleRect(const QRectF &rect)
+{
+    if (mVisibleRect == rect)
+        return;
+
+    mVisibleRect = rect;
+    scheduleViewportObjectItemsUpdate();
+}
+
 void MapScene::setSelectedTool(AbstractTool *tool)
 {
     mSelectedTool = tool;
@@ -187,6 +248,9 @@ void MapScene::refreshScene()
 {
     mLayerItems.clear();
     mObjectItems.clear();
+    mOnDemandObjectItems.clear();
+    mOnDemandReleaseThreshold = maxIdleObjectItems;
+    mKeepObjectItemsRect = QRectF();
 
     removeItem(mDarkRectangle);
     clear();
@@ -206,6 +270,13 @@ void MapScene::refreshScene()
     else
         setBackgroundBrush(mDefaultBackgroundColor);
 
+    // Creating an item for each object takes too long for large maps, so
+    // in that case the items are only created when needed
+    int objectCount = 0;
+    for (const ObjectGroup *objectGroup : map->objectGroups())
+        objectCount += objectGroup->objectCount();
+    mBatchObjectGroups = objectCount >= batchedObjectThreshold;
+
     createLayerItems(map->layers());
 
     TileSelectionItem *tileSelectionItem = new TileSelectionItem(mMapDocument);
@@ -217,6 +288,7 @@ void MapScene::refreshScene()
     addItem(mObjectSelectionItem);
 
     updateCurrentLayerHighlight();
+    scheduleViewportObjectItemsUpdate();
 }
 
 void MapScene::createLayerItems(const QList<Layer *> &layers)
@@ -241,20 +313,16 @@ LayerItem *MapScene::createLayerItem(Layer *layer)
 
     case Layer::ObjectGroupType: {
         auto og = static_cast<ObjectGroup*>(layer);
-        const ObjectGroup::DrawOrder drawOrder = og->drawOrder();
         ObjectGroupItem *ogItem = new ObjectGroupItem(og);
-        int objectIndex = 0;
-        for (MapObject *object : og->objects()) {
-            MapObjectItem *item = new MapObjectItem(object, mMapDocument,
-                                                    ogItem);
-            if (drawOrder == ObjectGroup::TopDownOrder)
-                item->setZValue(item->y());
-            else
-                item->setZValue(objectIndex);
-
-            mObjectItems.insert(object, item);
-            ++objectIndex;
+
+        if (mBatchObjectGroups || og->objectCount() >= batchedObjectThreshold) {
+            ogItem->enableBatchedRendering(mMapDocument);
+        } else {
+            int objectIndex = 0;
+            for (MapObject *object : og->objects())
+                createObjectItem(object, ogItem, objectIndex++);
         }
+
         layerItem = ogItem;
         break;
     }
@@ -285,6 +353,145 @@ LayerItem *MapScene::createLayerItem(Layer *layer)
     return layerItem;
 }
 
+ObjectGroupItem *MapScene::itemForObjectGroup(ObjectGroup *objectGroup) const
+{
+    return static_cast<ObjectGroupItem*>(mLayerItems.value(objectGroup));
+}
+
+MapObjectItem *MapScene::createObjectItem(MapObject *object,
+                                          ObjectGroupItem *ogItem,
+                                          int index)
+{
+    MapObjectItem *item = new MapObjectItem(object, mMapDocument, ogItem);
+    if (ogItem->objectGroup()->drawOrder() == ObjectGroup::TopDownOrder)
+        item->setZValue(item->y());
+    else
+        item->setZValue(index);
+
+    mObjectItems.insert(object, item);
+
+    if (ogItem->isBatched())
+        ogItem->setHasObjectItem(object, true);
+
+    return item;
+}
+
+/**
+ * Releases the on-demand items of objects in batched object groups that are
+ * no longer selected and not near the visible area. Nothing is released while
+ * a mouse button is pressed, since the active tool may be holding on to the
+ * items at that time.
+ */
+void MapScene::releaseObjectItems()
+{
+    if (QApplication::mouseButtons() != Qt::NoButton)
+        return;
+
+    for (auto it = mOnDemandObjectItems.begin(); it != mOnDemandObjectItems.end(); ) {
+        MapObjectItem *item = *it;
+        if (mSelectedObjectItems.contains(item) ||
+                item->sceneBoundingRect().intersects(mKeepObjectItemsRect)) {
+            ++it;
+            continue;
+        }
+
+        MapObject *object = item->mapObject();
+        if (ObjectGroupItem *ogItem = static_cast<ObjectGroupItem*>(item->parentItem()))
+            ogItem->setHasObjectItem(object, false);
+
+        mObjectItems.remove(object);
+        delete item;
+        it = mOnDemandObjectItems.erase(it);
+    }
+
+    mOnDemandReleaseThreshold = mOnDemandObjectItems.size() + maxIdleObjectItems;
+}
+
+/**
+ * Creates the items for the objects of batched object groups near the
+ * visible area, and releases the ones that are now too far away. While too
+ * many objects are near the visible area, no items are kept for them.
+ */
+void MapScene::updateViewportObjectItems()
+{
+    mViewportObjectItemsUpdatePending = false;
+
+    if (!mMapDocument || mVisibleRect.isEmpty())
+        return;
+
+    const qreal dx = mVisibleRect.width() * viewportObjectItemsMargin;
+    const qreal dy = mVisibleRect.height() * viewportObjectItemsMargin;
+
+    QList<MapObject*> objects = batchedObjectsInRect(mVisibleRect.adjusted(-dx, -dy, dx, dy));
+    if (objects.size() > maxViewportObjectItems) {
+        objects.clear();
+        mKeepObjectItemsRect = QRectF();
+    } else {
+        mKeepObjectItemsRect = mVisibleRect.adjusted(-2 * dx, -2 * dy, 2 * dx, 2 * dy);
+    }
+
+    releaseObjectItems();
+
+    for (MapObject *object : objects)
+        itemForObject(object);
+}
+
+void MapScene::scheduleViewportObjectItemsUpdate()
+{
+    if (mViewportObjectItemsUpdatePending)
+        return;
+
+    mViewportObjectItemsUpdatePending = true;
+    QMetaObject::invokeMethod(this, "updateViewportObjectItems", Qt::QueuedConnection);
+}
+
+/**
+ * Returns the visible objects of the visible batched object groups that are
+ * found around the given \a rect, in scene coordinates.
+ */
+QList<MapObject*> MapScene::batchedObjectsInRect(const QRectF &rect) const
+{
+    QList<MapObject*> result;
+
+    // Objects are drawn with some extra space around their shape, for their
+    // outline and for the marker of objects without a size
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const qreal margin = renderer->objectMargin();
+    const QRectF searchRect = rect.adjusted(-margin, -margin, margin, margin);
+
+    for (LayerItem *layerItem : mLayerItems) {
+        ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(layerItem);
+        if (!ogItem || !ogItem->isBatched())
+            continue;
+
+        ObjectGroup *objectGroup = ogItem->objectGroup();
+        if (objectGroup->isHidden())
+            continue;
+
+        const QRectF screenRect = searchRect.translated(-objectGroup->totalOffset());
+
+        QPolygonF pixelArea;
+        pixelArea << renderer->screenToPixelCoords(screenRect.topLeft())
+                  << renderer->screenToPixelCoords(screenRect.topRight())
+                  << renderer->screenToPixelCoords(screenRect.bottomRight())
+                  << renderer->screenToPixelCoords(screenRect.bottomLeft());
+
+        const auto objects = objectGroup->objectsInRect(pixelArea.boundingRect());
+        for (MapObject *object : objects)
+            if (object->isVisible())
+                result.append(object);
+    }
+
+    return result;
+}
+
+void MapScene::syncBatchedObjectGroupItems()
+{
+    for (LayerItem *layerItem : mLayerItems)
+        if (ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(layerItem))
+            ogItem->syncWithObjectGroup();
+}
+
 void MapScene::updateDefaultBackgroundColor()
 {
     mDefaultBackgroundColor = QGuiApplication::palette().dark().color();
@@ -424,6 +631,8 @@ void MapScene::mapChanged()
     for (MapObjectItem *item : mObjectItems)
         item->syncWithMapObject();
 
+    syncBatchedObjectGroupItems();
+
     const Map *map = mMapDocument->map();
     if (map->backgroundColor().isValid())
         setBackgroundBrush(map->backgroundColor());
@@ -457,9 +666,29 @@ void MapScene::layerAdded(Layer *layer)
 
 void MapScene::layerRemoved(Layer *layer)
 {
+    forgetObjectItems(layer);
     delete mLayerItems.take(layer);
 }
 
+/**
+ * Forgets about the object items that are deleted along with the item of the
+ * given \a layer.
+ */
+void MapScene::forgetObjectItems(Layer *layer)
+{
+    if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+        for (MapObject *object : objectGroup->objects()) {
+            if (MapObjectItem *item = mObjectItems.take(object)) {
+                mSelectedObjectItems.remove(item);
+                mOnDemandObjectItems.remove(item);
+            }
+        }
+    } else if (GroupLayer *groupLayer = layer->asGroupLayer()) {
+        for (Layer *childLayer : groupLayer->layers())
+            forgetObjectItems(childLayer);
+    }
+}
+
 // Returns whether layerB is drawn above layerA
 static bool isAbove(Layer *layerA, Layer *layerB)
 {
@@ -506,8 +735,15 @@ void MapScene::layerChanged(Layer *layer)
     QGraphicsItem *layerItem = mLayerItems.value(layer);
     Q_ASSERT(layerItem);
 
+    const bool wasVisible = layerItem->isVisible();
     layerItem->setVisible(layer->isVisible());
 
+    // Batched object groups don't determine their bounds while hidden
+    if (layerItem->isVisible() != wasVisible) {
+        syncBatchedObjectGroupItems();
+        scheduleViewportObjectItemsUpdate();
+    }
+
     qreal multiplier = 1;
     if (mHighlightCurrentLayer && isAbove(mMapDocument->currentLayer(), layer))
         multiplier = opacityFactor;
@@ -560,6 +796,8 @@ void MapScene::adaptToTilesetTileSizeChanges(Tileset *tileset)
         if (cell.tileset() == tileset)
             item->syncWithMapObject();
     }
+
+    syncBatchedObjectGroupItems();
 }
 
 void MapScene::adaptToTileSizeChanges(Tile *tile)
@@ -575,6 +813,8 @@ void MapScene::adaptToTileSizeChanges(Tile *tile)
         if (cell.tile() == tile)
             item->syncWithMapObject();
     }
+
+    syncBatchedObjectGroupItems();
 }
 
 void MapScene::tilesetReplaced(int index, Tileset *tileset)
@@ -588,33 +828,19 @@ void MapScene::tilesetReplaced(int index, Tileset *tileset)
  */
 void MapScene::objectsInserted(ObjectGroup *objectGroup, int first, int last)
 {
-    ObjectGroupItem *ogItem = nullptr;
-
-    // Find the object group item for the object group
-    for (QGraphicsItem *item : mLayerItems) {
-        if (ObjectGroupItem *ogi = dynamic_cast<ObjectGroupItem*>(item)) {
-            if (ogi->objectGroup() == objectGroup) {
-                ogItem = ogi;
-                break;
-            }
-        }
-    }
-
+    ObjectGroupItem *ogItem = itemForObjectGroup(objectGroup);
     Q_ASSERT(ogItem);
 
-    const ObjectGroup::DrawOrder drawOrder = objectGroup->drawOrder();
-
-    for (int i = first; i <= last; ++i) {
-        MapObject *object = objectGroup->objectAt(i);
-
-        MapObjectItem *item = new MapObjectItem(object, mMapDocument, ogItem);
-        if (drawOrder == ObjectGroup::TopDownOrder)
-            item->setZValue(item->y());
-        else
-            item->setZValue(i);
+    ogItem->objectsRearranged();
 
-        mObjectItems.insert(object, item);
+    // Batched object groups draw new objects themselves
+    if (ogItem->isBatched()) {
+        scheduleViewportObjectItemsUpdate();
+        return;
     }
+
+    for (int i = first; i <= last; ++i)
+        createObjectItem(objectGroup->objectAt(i), ogItem, i);
 }
 
 /**
@@ -624,12 +850,22 @@ void MapScene::objectsRemoved(const QList<MapObject*> &objects)
 {
     for (MapObject *o : objects) {
         auto i = mObjectItems.find(o);
-        Q_ASSERT(i != mObjectItems.end());
+        if (i == mObjectItems.end())
+            continue;   // Object from a batched object group without item
+
+        if (ObjectGroupItem *ogItem = static_cast<ObjectGroupItem*>(i.value()->parentItem()))
+            ogItem->setHasObjectItem(o, false);
 
         mSelectedObjectItems.remove(i.value());
+        mOnDemandObjectItems.remove(i.value());
         delete i.value();
         mObjectItems.erase(i);
     }
+
+    // The removed objects are no longer part of an object group
+    for (LayerItem *layerItem : mLayerItems)
+        if (ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(layerItem))
+            ogItem->objectsRearranged();
 }
 
 /**
@@ -637,12 +873,27 @@ void MapScene::objectsRemoved(const QList<MapObject*> &objects)
  */
 void MapScene::objectsChanged(const QList<MapObject*> &objects)
 {
+    QSet<ObjectGroupItem*> batchedItems;
+
     for (MapObject *object : objects) {
-        MapObjectItem *item = itemForObject(object);
-        Q_ASSERT(item);
+        if (MapObjectItem *item = mObjectItems.value(object)) {
+            item->syncWithMapObject();
+            continue;
+        }
 
-        item->syncWithMapObject();
+        ObjectGroupItem *ogItem = itemForObjectGroup(object->objectGroup());
+        Q_ASSERT(ogItem && ogItem->isBatched());
+        batchedItems.insert(ogItem);
     }
+
+    // The previous location of the objects is not known, so the whole
+    // object group is redrawn
+    for (ObjectGroupItem *ogItem : batchedItems)
+        ogItem->syncWithObjectGroup();
+
+    // Objects may have moved towards the visible area
+    if (!batchedItems.isEmpty())
+        scheduleViewportObjectItemsUpdate();
 }
 
 /**
@@ -651,14 +902,18 @@ void MapScene::objectsChanged(const QList<MapObject*> &objects)
 void MapScene::objectsIndexChanged(ObjectGroup *objectGroup,
                                    int first, int last)
 {
+    ObjectGroupItem *ogItem = itemForObjectGroup(objectGroup);
+    ogItem->objectsRearranged();
+
     if (objectGroup->drawOrder() != ObjectGroup::IndexOrder)
         return;
 
     for (int i = first; i <= last; ++i) {
-        MapObjectItem *item = itemForObject(objectGroup->objectAt(i));
-        Q_ASSERT(item);
+        MapObjectItem *item = mObjectItems.value(objectGroup->objectAt(i));
+        Q_ASSERT(item || ogItem->isBatched());
 
-        item->setZValue(i);
+        if (item)
+            item->setZValue(i);
     }
 }
 
@@ -676,12 +931,19 @@ void MapScene::updateSelectedObjectItems()
 
     mSelectedObjectItems = items;
     emit selectedObjectItemsChanged();
+
+    // Release the items of deselected objects once the change has been
+    // handled by everyone
+    if (!mOnDemandObjectItems.isEmpty())
+        QMetaObject::invokeMethod(this, "releaseObjectItems", Qt::QueuedConnection);
 }
 
 void MapScene::syncAllObjectItems()
 {
     for (MapObjectItem *item : mObjectItems)
         item->syncWithMapObject();
+
+    syncBatchedObjectGroupItems();
 }
 
 /**
@@ -707,12 +969,11 @@ void MapScene::setObjectLineWidth(qreal lineWidth)
         mMapDocument->renderer()->setObjectLineWidth(lineWidth);
 
         // Changing the line width can change the size of the object items
-        if (!mObjectItems.isEmpty()) {
-            for (MapObjectItem *item : mObjectItems)
-                item->syncWithMapObject();
+        for (MapObjectItem *item : mObjectItems)
+            item->syncWithMapObject();
 
-            update();
-        }
+        syncBatchedObjectGroupItems();
+        update();
     }
 }
 
@@ -725,8 +986,7 @@ void MapScene::setShowTileObjectOutlines(bool enabled)
 
     if (mMapDocument) {
         mMapDocument->renderer()->setFlag(ShowTileObjectOutlines, enabled);
-        if (!mObjectItems.isEmpty())
-            update();
+        update();
     }
 }
 
@@ -794,6 +1054,13 @@ void MapScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
     if (!mMapDocument)
         return;
 
+    // Don't keep accumulating the items created while hovering objects in
+    // batched object groups
+    if (mouseEvent->buttons() == Qt::NoButton &&
+            mOnDemandObjectItems.size() > mOnDemandReleaseThreshold) {
+        releaseObjectItems();
+    }
+
     QGraphicsScene::mouseMoveEvent(mouseEvent);
     if (mouseEvent->isAccepted())
         return;
@@ -827,6 +1094,8 @@ void MapScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
         mouseEvent->accept();
         mActiveTool->mouseReleased(mouseEvent);
     }
+
+    releaseObjectItems();
 }
 
 /**
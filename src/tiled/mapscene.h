@@ -95,9 +95,26 @@ public:
 
     /**
      * Returns the MapObjectItem associated with the given \a mapObject.
+     *
+     * For objects in batched object groups, the item is created on demand.
+     * Such items are released again when their object is no longer selected
+     * and not near the visible area.
      */
-    MapObjectItem *itemForObject(MapObject *object) const
-    { return mObjectItems.value(object); }
+    MapObjectItem *itemForObject(MapObject *object);
+
+    /**
+     * Makes sure items exist for the objects of batched object groups that
+     * are found around the given \a rect, in scene coordinates. This should
+     * be called before looking up object items using QGraphicsScene::items.
+     */
+    void materializeObjectItems(const QRectF &rect);
+
+    /**
+     * Sets the area of the scene that is visible in the view. Items are
+     * created for the objects of batched object groups near this area, and
+     * released again once the area moves away from them.
+     */
+    void setVisibleRect(const QRectF &rect);
 
     /**
      * Enables the selected tool at this map scene.
@@ -178,10 +195,22 @@ private slots:
     void updateSelectedObjectItems();
     void syncAllObjectItems();
 
+    void releaseObjectItems();
+    void updateViewportObjectItems();
+
 private:
     void createLayerItems(const QList<Layer *> &layers);
     LayerItem *createLayerItem(Layer *layer);
 
+    ObjectGroupItem *itemForObjectGroup(ObjectGroup *objectGroup) const;
+    MapObjectItem *createObjectItem(MapObject *object,
+                                    ObjectGroupItem *ogItem,
+                                    int index);
+    void syncBatchedObjectGroupItems();
+    void forgetObjectItems(Layer *layer);
+    QList<MapObject*> batchedObjectsInRect(const QRectF &rect) const;
+    void scheduleViewportObjectItemsUpdate();
+
     void updateDefaultBackgroundColor();
     void updateSceneRect();
     void updateCurrentLayerHighlight();
@@ -202,9 +231,16 @@ private:
     QGraphicsRectItem *mDarkRectangle;
     QColor mDefaultBackgroundColor;
     ObjectSelectionItem *mObjectSelectionItem;
+    bool mBatchObjectGroups;
 
     QMap<MapObject*, MapObjectItem*> mObjectItems;
     QSet<MapObjectItem*> mSelectedObjectItems;
+    QSet<MapObjectItem*> mOnDemandObjectItems;
+    int mOnDemandReleaseThreshold;
+
+    QRectF mVisibleRect;
+    QRectF mKeepObjectItemsRect;    // on-demand items in this area are kept
+    bool mViewportObjectItemsUpdatePending;
 };
 
 } // namespace Internal
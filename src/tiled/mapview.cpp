@@ -80,6 +80,10 @@ MapView::MapView(QWidget *parent, Mode mode)
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
 
     connect(mZoomable, SIGNAL(scaleChanged(qreal)), SLOT(adjustScale(qreal)));
+
+    // The scene creates items for the objects near the visible area
+    connect(horizontalScrollBar(), SIGNAL(valueChanged(int)), SLOT(updateVisibleRect()));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(updateVisibleRect()));
 }
 
 MapView::~MapView()
@@ -97,6 +101,8 @@ void MapView::adjustScale(qreal scale)
     setTransform(QTransform::fromScale(scale, scale));
     setRenderHint(QPainter::SmoothPixmapTransform,
                   mZoomable->smoothTransform());
+
+    updateVisibleRect();
 }
 
 void MapView::setUseOpenGL(bool useOpenGL)
@@ -215,6 +221,18 @@ void MapView::hideEvent(QHideEvent *event)
     QGraphicsView::hideEvent(event);
 }
 
+void MapView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    updateVisibleRect();
+}
+
+void MapView::updateVisibleRect()
+{
+    if (MapScene *scene = mapScene())
+        scene->setVisibleRect(mapToScene(viewport()->rect()).boundingRect());
+}
+
 void MapView::keyPressEvent(QKeyEvent *event)
 {
     if (Utils::isZoomInShortcut(event)) {
@@ -70,6 +70,7 @@ protected:
     bool event(QEvent *event) override;
 
     void hideEvent(QHideEvent *) override;
+    void resizeEvent(QResizeEvent *event) override;
 
     void keyPressEvent(QKeyEvent *event) override;
 
@@ -86,6 +87,7 @@ protected:
 private slots:
     void adjustScale(qreal scale);
     void setUseOpenGL(bool useOpenGL);
+    void updateVisibleRect();
 
 private:
     QPoint mLastMousePos;
@@ -20,23 +20,269 @@
 
 #include "objectgroupitem.h"
 
+#include "map.h"
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "mapobjectitem.h"
+#include "maprenderer.h"
+#include "mapview.h"
+#include "zoomable.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
 ObjectGroupItem::ObjectGroupItem(ObjectGroup *objectGroup, QGraphicsItem *parent)
     : LayerItem(objectGroup, parent)
+    , mMapDocument(nullptr)
+    , mBoundingRectDirty(false)
 {
     // Since we don't do any painting, we can spare us the call to paint()
     setFlag(QGraphicsItem::ItemHasNoContents);
 }
 
+void ObjectGroupItem::enableBatchedRendering(MapDocument *mapDocument)
+{
+    mMapDocument = mapDocument;
+
+    setFlag(QGraphicsItem::ItemHasNoContents, false);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+
+    syncWithObjectGroup();
+}
+
+void ObjectGroupItem::setHasObjectItem(MapObject *object, bool hasObjectItem)
+{
+    if (hasObjectItem)
+        mObjectsWithItems.insert(object);
+    else
+        mObjectsWithItems.remove(object);
+
+    if (isBatched())
+        update(objectBounds(object));
+}
+
+int ObjectGroupItem::indexOfObject(MapObject *object) const
+{
+    // Looking up the index of many objects is common when creating the items
+    // for a large selection, so the indexes are cached until the next change
+    if (mObjectIndexes.isEmpty()) {
+        const QList<MapObject*> &objects = objectGroup()->objects();
+        mObjectIndexes.reserve(objects.size());
+        for (int i = 0; i < objects.size(); ++i)
+            mObjectIndexes.insert(objects.at(i), i);
+    }
+
+    return mObjectIndexes.value(object, -1);
+}
+
+void ObjectGroupItem::objectsRearranged()
+{
+    mObjectIndexes.clear();
+
+    if (isBatched())
+        syncWithObjectGroup();
+}
+
+void ObjectGroupItem::syncWithObjectGroup()
+{
+    if (!isBatched())
+        return;
+
+    prepareGeometryChange();
+    mBoundingRectDirty = true;
+    update();
+}
+
+/**
+ * In batched mode, the bounding rect is determined on demand from the spatial
+ * index of the object group. While the object group is hidden, it is left
+ * empty so that the index doesn't need to be created.
+ */
 QRectF ObjectGroupItem::boundingRect() const
 {
-    return QRectF();
+    if (!mBoundingRectDirty)
+        return mBoundingRect;
+
+    if (objectGroup()->isHidden())
+        return QRectF();
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QRectF bounds = objectGroup()->indexedBounds();
+
+    QPolygonF screenArea;
+    screenArea << renderer->pixelToScreenCoords(bounds.topLeft())
+               << renderer->pixelToScreenCoords(bounds.topRight())
+               << renderer->pixelToScreenCoords(bounds.bottomRight())
+               << renderer->pixelToScreenCoords(bounds.bottomLeft());
+
+    // Leave room for the outline and the marker of objects without a size
+    const qreal margin = renderer->objectMargin();
+    mBoundingRect = screenArea.boundingRect().adjusted(-margin, -margin,
+                                                       margin, margin);
+    mBoundingRectDirty = false;
+
+    return mBoundingRect;
+}
+
+void ObjectGroupItem::paint(QPainter *painter,
+                            const QStyleOptionGraphicsItem *option,
+                            QWidget *widget)
+{
+    if (!isBatched())
+        return;
+
+    MapRenderer *renderer = mMapDocument->renderer();
+    const qreal scale = static_cast<MapView*>(widget->parent())->zoomable()->scale();
+    renderer->setPainterScale(scale);
+
+    // Look up the objects in the exposed area, taking into account the space
+    // taken by their outline and the marker of objects without a size
+    const qreal lineWidth = renderer->objectLineWidth();
+    const qreal margin = renderer->objectMargin(scale);
+    const QRectF exposedRect = option->exposedRect.adjusted(-margin, -margin,
+                                                            margin, margin);
+
+    QPolygonF pixelArea;
+    pixelArea << renderer->screenToPixelCoords(exposedRect.topLeft())
+              << renderer->screenToPixelCoords(exposedRect.topRight())
+              << renderer->screenToPixelCoords(exposedRect.bottomRight())
+              << renderer->screenToPixelCoords(exposedRect.bottomLeft());
+
+    QList<MapObject*> objects = objectGroup()->objectsInRect(pixelArea.boundingRect());
+
+    // The objects are returned in index order
+    if (objectGroup()->drawOrder() == ObjectGroup::TopDownOrder) {
+        std::stable_sort(objects.begin(), objects.end(),
+                         [renderer] (const MapObject *a, const MapObject *b) {
+            return renderer->pixelToScreenCoords(a->position()).y() <
+                    renderer->pixelToScreenCoords(b->position()).y();
+        });
+    }
+
+    // Consecutive rectangles and ellipses of the same color are drawn with
+    // a shared pen and brush. This is only done on orthogonal maps, where
+    // these objects are not projected.
+    const bool orthogonal = mMapDocument->map()->orientation() == Map::Orthogonal;
+    const qreal shadowDist = (lineWidth == 0 ? 1 : lineWidth) / scale;
+    const QPointF shadowOffset(shadowDist * 0.5, shadowDist * 0.5);
+
+    MapObject::Shape batchShape = MapObject::Rectangle;
+    QColor batchColor;
+    QVector<QRectF> batch;
+
+    auto flushBatch = [&] {
+        if (batch.isEmpty())
+            return;
+
+        QPen linePen(batchColor, lineWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+        linePen.setCosmetic(true);
+        QPen shadowPen(linePen);
+        shadowPen.setColor(Qt::black);
+
+        QColor brushColor = batchColor;
+        brushColor.setAlpha(50);
+
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing);
+
+        painter->translate(shadowOffset);
+        painter->setPen(shadowPen);
+        if (batchShape == MapObject::Rectangle) {
+            painter->drawRects(batch);
+        } else {
+            for (const QRectF &rect : batch)
+                painter->drawEllipse(rect);
+        }
+
+        painter->translate(-shadowOffset);
+        painter->setPen(linePen);
+        painter->setBrush(brushColor);
+        if (batchShape == MapObject::Rectangle) {
+            painter->drawRects(batch);
+        } else {
+            for (const QRectF &rect : batch)
+                painter->drawEllipse(rect);
+        }
+
+        painter->restore();
+        batch.clear();
+    };
+
+    // Determining the color involves looking up the object type
+    QHash<QString, QColor> colors;
+
+    for (const MapObject *object : objects) {
+        if (!object->isVisible() || mObjectsWithItems.contains(object))
+            continue;
+
+        const QString type = object->effectiveType();
+        auto colorIt = colors.find(type);
+        if (colorIt == colors.end())
+            colorIt = colors.insert(type, MapObjectItem::objectColor(object));
+        const QColor &color = colorIt.value();
+
+        MapObject::Shape shape = object->shape();
+        QRectF rect = object->bounds();
+
+        // Matches the special cases in OrthogonalRenderer::drawMapObject
+        if (shape == MapObject::Ellipse &&
+                ((rect.width() == qreal(0)) ^ (rect.height() == qreal(0)))) {
+            shape = MapObject::Rectangle;
+        }
+        if (rect.isNull())
+            rect = QRectF(rect.topLeft() - QPointF(10, 10), QSizeF(20, 20));
+
+        const bool batchable = orthogonal &&
+                object->cell().isEmpty() &&
+                object->rotation() == 0 &&
+                (shape == MapObject::Rectangle || shape == MapObject::Ellipse);
+
+        if (batchable) {
+            if (shape != batchShape || color != batchColor) {
+                flushBatch();
+                batchShape = shape;
+                batchColor = color;
+            }
+            batch.append(rect);
+            continue;
+        }
+
+        flushBatch();
+
+        // Same transformation as applied to a MapObjectItem
+        const QPointF screenPos = renderer->pixelToScreenCoords(object->position());
+
+        painter->save();
+        painter->translate(screenPos);
+        painter->rotate(object->rotation());
+        painter->translate(-screenPos);
+        renderer->drawMapObject(painter, object, color);
+        painter->restore();
+    }
+
+    flushBatch();
 }
 
-void ObjectGroupItem::paint(QPainter *,
-                            const QStyleOptionGraphicsItem *,
-                            QWidget *)
+QRectF ObjectGroupItem::objectBounds(const MapObject *object) const
 {
+    const MapRenderer *renderer = mMapDocument->renderer();
+    QRectF bounds = renderer->boundingRect(object);
+
+    if (object->rotation() != 0) {
+        const QPointF screenPos = renderer->pixelToScreenCoords(object->position());
+
+        QTransform transform;
+        transform.translate(screenPos.x(), screenPos.y());
+        transform.rotate(object->rotation());
+        transform.translate(-screenPos.x(), -screenPos.y());
+
+        bounds = transform.mapRect(bounds);
+    }
+
+    return bounds;
 }
@@ -24,12 +24,24 @@
 
 #include "objectgroup.h"
 
+#include <QHash>
+#include <QSet>
+
 namespace Tiled {
 namespace Internal {
 
+class MapDocument;
+
 /**
- * A graphics item representing an object group in a QGraphicsView. It only
- * serves to group together the objects belonging to the same object group.
+ * A graphics item representing an object group in a QGraphicsView. It
+ * normally only serves to group together the objects belonging to the same
+ * object group.
+ *
+ * For large object groups, the item can instead draw the objects itself. In
+ * this batched mode, only the objects in the exposed area are looked up in the
+ * spatial index of the object group, and MapObjectItem instances only exist
+ * for the objects near the visible area or that need to be interacted with
+ * (see MapScene::setVisibleRect).
  *
  * @see MapObjectItem
  */
@@ -40,11 +52,52 @@ public:
 
     ObjectGroup *objectGroup() const;
 
+    /**
+     * Makes this item draw the objects of its object group, except for the
+     * ones that have been marked as having their own item.
+     */
+    void enableBatchedRendering(MapDocument *mapDocument);
+    bool isBatched() const { return mMapDocument != nullptr; }
+
+    /**
+     * Marks whether the given \a object is displayed by its own MapObjectItem
+     * and should therefore not be drawn by this item.
+     */
+    void setHasObjectItem(MapObject *object, bool hasObjectItem);
+
+    /**
+     * Returns the index of the given \a object in the object group. Used for
+     * determining the stacking order of items created for batched objects.
+     */
+    int indexOfObject(MapObject *object) const;
+
+    /**
+     * Should be called when objects were added, removed or changed their
+     * order in the object group.
+     */
+    void objectsRearranged();
+
+    /**
+     * Should be called when the objects need to be redrawn, for example
+     * because objects changed, the map orientation or the object line width
+     * changed, or the object group was shown.
+     */
+    void syncWithObjectGroup();
+
     // QGraphicsItem
     QRectF boundingRect() const override;
     void paint(QPainter *painter,
                const QStyleOptionGraphicsItem *option,
                QWidget *widget = nullptr) override;
+
+private:
+    QRectF objectBounds(const MapObject *object) const;
+
+    MapDocument *mMapDocument;
+    mutable QRectF mBoundingRect;
+    mutable bool mBoundingRectDirty;
+    QSet<const MapObject*> mObjectsWithItems;
+    mutable QHash<const MapObject*, int> mObjectIndexes;
 };
 
 inline ObjectGroup *ObjectGroupItem::objectGroup() const
@@ -1035,11 +1035,37 @@ void ObjectSelectionTool::updateSelection(const QPointF &pos,
 
     QSet<MapObjectItem*> selectedItems;
 
-    const QList<QGraphicsItem *> &items = mapScene()->items(rect);
-    for (QGraphicsItem *item : items) {
-        MapObjectItem *mapObjectItem = dynamic_cast<MapObjectItem*>(item);
-        if (mapObjectItem)
-            selectedItems.insert(mapObjectItem);
+    QPainterPath selectionPath;
+    selectionPath.addRect(rect);
+
+    // Objects are drawn with some extra space around their shape, for their
+    // outline and for the marker of objects without a size
+    const MapRenderer *renderer = mapDocument()->renderer();
+    const qreal margin = renderer->objectMargin();
+    const QRectF searchRect = rect.adjusted(-margin, -margin, margin, margin);
+
+    for (ObjectGroup *objectGroup : mapDocument()->map()->objectGroups()) {
+        if (objectGroup->isHidden())
+            continue;
+
+        // Look up the candidates in the spatial index of the object group,
+        // which works in pixel coordinates
+        const QRectF screenRect = searchRect.translated(-objectGroup->totalOffset());
+
+        QPolygonF pixelArea;
+        pixelArea << renderer->screenToPixelCoords(screenRect.topLeft())
+                  << renderer->screenToPixelCoords(screenRect.topRight())
+                  << renderer->screenToPixelCoords(screenRect.bottomRight())
+                  << renderer->screenToPixelCoords(screenRect.bottomLeft());
+
+        const auto objects = objectGroup->objectsInRect(pixelArea.boundingRect());
+        for (MapObject *object : objects) {
+            MapObjectItem *item = mapScene()->itemForObject(object);
+            if (item && item->isVisible() &&
+                    item->collidesWithPath(item->mapFromScene(selectionPath))) {
+                selectedItems.insert(item);
+            }
+        }
     }
 
     if (modifiers & (Qt::ControlModifier | Qt::ShiftModifier))
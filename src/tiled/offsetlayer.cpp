@@ -42,6 +42,7 @@ OffsetLayer::OffsetLayer(MapDocument *mapDocument,
                          bool wrapY)
     : QUndoCommand(QCoreApplication::translate("Undo Commands",
                                                "Offset Layer"))
+    , CompressibleCommand(mapDocument->undoMemoryLimiter())
     , mMapDocument(mapDocument)
     , mDone(false)
     , mOriginalLayer(layer)
@@ -88,6 +89,8 @@ OffsetLayer::~OffsetLayer()
 void OffsetLayer::undo()
 {
     Q_ASSERT(mDone);
+    if (!ensureLoaded())
+        return;
     LayerModel *layerModel = mMapDocument->layerModel();
     if (mOffsetLayer)
         layerModel->replaceLayer(mOffsetLayer, mOriginalLayer);
@@ -99,6 +102,8 @@ void OffsetLayer::undo()
 void OffsetLayer::redo()
 {
     Q_ASSERT(!mDone);
+    if (!ensureLoaded())
+        return;
     LayerModel *layerModel = mMapDocument->layerModel();
     if (mOffsetLayer)
         layerModel->replaceLayer(mOriginalLayer, mOffsetLayer);
@@ -106,3 +111,32 @@ void OffsetLayer::redo()
         layerModel->setLayerOffset(mOriginalLayer, mNewOffset);
     mDone = true;
 }
+
+qint64 OffsetLayer::dataSize() const
+{
+    if (const TileLayer *layer = inactiveTileLayer())
+        return qint64(layer->width()) * layer->height() * sizeof(Cell);
+    return 0;
+}
+
+QByteArray OffsetLayer::saveData()
+{
+    return inactiveTileLayer()->takeCells();
+}
+
+void OffsetLayer::loadData(const QByteArray &data)
+{
+    inactiveTileLayer()->restoreCells(data);
+}
+
+/**
+ * Returns the tile layer that is currently not part of the map, if any.
+ */
+TileLayer *OffsetLayer::inactiveTileLayer() const
+{
+    if (!mOffsetLayer)
+        return nullptr;
+
+    Layer *layer = mDone ? mOriginalLayer : mOffsetLayer;
+    return layer->asTileLayer();
+}
@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include "undomemorylimiter.h"
+
 #include <QRect>
 #include <QPoint>
 #include <QUndoCommand>
@@ -28,6 +30,7 @@
 namespace Tiled {
 
 class Layer;
+class TileLayer;
 
 namespace Internal {
 
@@ -36,7 +39,7 @@ class MapDocument;
 /**
  * Undo command that offsets a map layer.
  */
-class OffsetLayer : public QUndoCommand
+class OffsetLayer : public QUndoCommand, public CompressibleCommand
 {
 public:
     /**
@@ -55,7 +58,14 @@ public:
     void undo() override;
     void redo() override;
 
+protected:
+    qint64 dataSize() const override;
+    QByteArray saveData() override;
+    void loadData(const QByteArray &data) override;
+
 private:
+    TileLayer *inactiveTileLayer() const;
+
     MapDocument *mMapDocument;
     bool mDone;
     Layer *mOriginalLayer;
@@ -27,6 +27,8 @@
 
 #include <QCoreApplication>
 
+#include <cstring>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -37,17 +39,12 @@ PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
                                const TileLayer *source,
                                QUndoCommand *parent)
     : QUndoCommand(parent)
+    , CompressibleCommand(mapDocument->undoMemoryLimiter())
     , mMapDocument(mapDocument)
     , mTarget(target)
-    , mSource(source->clone())
-    , mX(x)
-    , mY(y)
-    , mPaintedRegion(source->region().translated(QPoint(x, y) - source->position()))
     , mMergeable(false)
 {
-    mErased = mTarget->copy(mX - mTarget->x(),
-                            mY - mTarget->y(),
-                            mSource->width(), mSource->height());
+    record(source, x, y, source->mask().translated(QPoint(x, y) - source->position()));
     setText(QCoreApplication::translate("Undo Commands", "Paint"));
 }
 
@@ -59,30 +56,24 @@ PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
                                const QRegion &paintRegion,
                                QUndoCommand *parent)
     : QUndoCommand(parent)
+    , CompressibleCommand(mapDocument->undoMemoryLimiter())
     , mMapDocument(mapDocument)
     , mTarget(target)
-    , mSource(source->clone())
-    , mX(x)
-    , mY(y)
-    , mPaintedRegion(paintRegion)
     , mMergeable(false)
 {
-    mErased = mTarget->copy(mX - mTarget->x(),
-                            mY - mTarget->y(),
-                            mSource->width(), mSource->height());
+    record(source, x, y, paintRegion);
     setText(QCoreApplication::translate("Undo Commands", "Paint"));
 }
 
-PaintTileLayer::~PaintTileLayer()
-{
-    delete mSource;
-    delete mErased;
-}
-
 void PaintTileLayer::undo()
 {
+    if (!ensureLoaded())
+        return;
+
     TilePainter painter(mMapDocument, mTarget);
-    painter.setCells(mX, mY, mErased, mPaintedRegion);
+    painter.setCells(mPaintedRegion, [this] (int x, int y) -> const Cell & {
+        return chunkAt(x, y).erased[indexInChunk(x, y)];
+    });
 
     QUndoCommand::undo(); // undo child commands
 }
@@ -91,8 +82,13 @@ void PaintTileLayer::redo()
 {
     QUndoCommand::redo(); // redo child commands
 
+    if (!ensureLoaded())
+        return;
+
     TilePainter painter(mMapDocument, mTarget);
-    painter.setCells(mX, mY, mSource, mPaintedRegion);
+    painter.setCells(mPaintedRegion, [this] (int x, int y) -> const Cell & {
+        return chunkAt(x, y).painted[indexInChunk(x, y)];
+    });
 }
 
 bool PaintTileLayer::mergeWith(const QUndoCommand *other)
@@ -103,33 +99,119 @@ bool PaintTileLayer::mergeWith(const QUndoCommand *other)
           o->mMergeable))
         return false;
 
-    const QRegion newRegion = o->mPaintedRegion.subtracted(mPaintedRegion);
-    const QRegion combinedRegion = mPaintedRegion.united(o->mPaintedRegion);
-    const QRect bounds = QRect(mX, mY, mSource->width(), mSource->height());
-    const QRect combinedBounds = combinedRegion.boundingRect();
-
-    // Resize the erased tiles and source layers when necessary
-    if (bounds != combinedBounds) {
-        const QPoint shift = bounds.topLeft() - combinedBounds.topLeft();
-        mErased->resize(combinedBounds.size(), shift);
-        mSource->resize(combinedBounds.size(), shift);
+    if (!ensureLoaded())
+        return false;
+    o->ensureLoaded();
+
+    // Only the cells that were not painted yet need their erased cell
+    const TileMask newRegion = o->mPaintedRegion.subtracted(mPaintedRegion);
+
+    for (int y = newRegion.top(); y <= newRegion.bottom(); ++y) {
+        for (const TileMask::Span &span : newRegion.row(y)) {
+            for (int x = span.left; x <= span.right; ++x) {
+                const int index = indexInChunk(x, y);
+                chunkAt(x, y).erased[index] = o->chunkAt(x, y).erased[index];
+            }
+        }
     }
 
-    mX = combinedBounds.left();
-    mY = combinedBounds.top();
-    mPaintedRegion = combinedRegion;
+    // The other command was painted last, so its cells take precedence
+    const TileMask &otherRegion = o->mPaintedRegion;
 
-    // Copy the painted tiles from the other command over
-    const QPoint pos = QPoint(o->mX, o->mY) - combinedBounds.topLeft();
-    mSource->merge(pos, o->mSource);
+    for (int y = otherRegion.top(); y <= otherRegion.bottom(); ++y) {
+        for (const TileMask::Span &span : otherRegion.row(y)) {
+            for (int x = span.left; x <= span.right; ++x) {
+                const int index = indexInChunk(x, y);
+                chunkAt(x, y).painted[index] = o->chunkAt(x, y).painted[index];
+            }
+        }
+    }
 
-    // Copy the newly erased tiles from the other command over
-    foreach (const QRect &rect, newRegion.rects())
-        for (int y = rect.top(); y <= rect.bottom(); ++y)
-            for (int x = rect.left(); x <= rect.right(); ++x)
-                mErased->setCell(x - mX,
-                                 y - mY,
-                                 o->mErased->cellAt(x - o->mX, y - o->mY));
+    mPaintedRegion.unite(otherRegion);
 
     return true;
 }
+
+qint64 PaintTileLayer::dataSize() const
+{
+    return qint64(mChunks.size()) * (sizeof(quint64) + sizeof(Chunk));
+}
+
+QByteArray PaintTileLayer::saveData()
+{
+    // Cells only contain a tileset pointer, a tile ID and some flags, so the
+    // chunks can be stored as raw bytes. They compress well, since most
+    // cells refer to the same tileset.
+    QByteArray data;
+    data.reserve(int(dataSize()));
+
+    for (auto it = mChunks.constBegin(), end = mChunks.constEnd(); it != end; ++it) {
+        const quint64 key = it.key();
+        data.append(reinterpret_cast<const char*>(&key), sizeof(key));
+        data.append(reinterpret_cast<const char*>(&it.value()), sizeof(Chunk));
+    }
+
+    mChunks.clear();
+    mChunks.squeeze();
+
+    return data;
+}
+
+void PaintTileLayer::loadData(const QByteArray &data)
+{
+    const int recordSize = sizeof(quint64) + sizeof(Chunk);
+
+    mChunks.reserve(data.size() / recordSize);
+
+    for (int offset = 0; offset + recordSize <= data.size(); offset += recordSize) {
+        quint64 key;
+        memcpy(&key, data.constData() + offset, sizeof(key));
+        memcpy(&mChunks[key], data.constData() + offset + sizeof(key), sizeof(Chunk));
+    }
+}
+
+quint64 PaintTileLayer::chunkKey(int x, int y)
+{
+    return (quint64(quint32(y >> ChunkBits)) << 32) | quint32(x >> ChunkBits);
+}
+
+int PaintTileLayer::indexInChunk(int x, int y)
+{
+    return (y & ChunkMask) * ChunkSize + (x & ChunkMask);
+}
+
+/**
+ * Remembers the cells painted by \a source at (\a x, \a y) within the
+ * given \a paintRegion, along with the cells they will replace.
+ */
+void PaintTileLayer::record(const TileLayer *source, int x, int y,
+                            const TileMask &paintRegion)
+{
+    // Only cells covered by both the source and the target can change
+    mPaintedRegion = paintRegion;
+    mPaintedRegion &= QRect(x, y, source->width(), source->height());
+    mPaintedRegion &= mTarget->bounds();
+
+    for (int cy = mPaintedRegion.top(); cy <= mPaintedRegion.bottom(); ++cy) {
+        for (const TileMask::Span &span : mPaintedRegion.row(cy)) {
+            for (int cx = span.left; cx <= span.right; ++cx) {
+                Chunk &chunk = chunkAt(cx, cy);
+                const int index = indexInChunk(cx, cy);
+                chunk.erased[index] = mTarget->cellAt(cx - mTarget->x(), cy - mTarget->y());
+                chunk.painted[index] = source->cellAt(cx - x, cy - y);
+            }
+        }
+    }
+}
+
+PaintTileLayer::Chunk &PaintTileLayer::chunkAt(int x, int y)
+{
+    return mChunks[chunkKey(x, y)];
+}
+
+const PaintTileLayer::Chunk &PaintTileLayer::chunkAt(int x, int y) const
+{
+    const auto it = mChunks.constFind(chunkKey(x, y));
+    Q_ASSERT(it != mChunks.constEnd());
+    return it.value();
+}
@@ -20,23 +20,28 @@
 
 #pragma once
 
+#include "tilelayer.h"
 #include "undocommands.h"
+#include "undomemorylimiter.h"
 
+#include <QHash>
 #include <QRegion>
 #include <QUndoCommand>
 
 namespace Tiled {
-
-class TileLayer;
-
 namespace Internal {
 
 class MapDocument;
 
 /**
  * A command that paints one tile layer on top of another tile layer.
+ *
+ * Only the cells that are actually painted are remembered, along with the
+ * cells they replaced. They are stored in blocks of 16x16 cells, so that a
+ * long stroke across a large map doesn't need memory for its whole bounding
+ * rectangle.
  */
-class PaintTileLayer : public QUndoCommand
+class PaintTileLayer : public QUndoCommand, public CompressibleCommand
 {
 public:
     /**
@@ -71,8 +76,6 @@ public:
                    const QRegion &paintRegion,
                    QUndoCommand *parent = nullptr);
 
-    ~PaintTileLayer();
-
     /**
      * Sets whether this undo command can be merged with an existing command.
      */
@@ -84,13 +87,41 @@ public:
     int id() const override { return Cmd_PaintTileLayer; }
     bool mergeWith(const QUndoCommand *other) override;
 
+protected:
+    qint64 dataSize() const override;
+    QByteArray saveData() override;
+    void loadData(const QByteArray &data) override;
+
 private:
+    enum {
+        ChunkBits = 4,
+        ChunkSize = 1 << ChunkBits,
+        ChunkMask = ChunkSize - 1
+    };
+
+    /**
+     * The cells before and after painting for a block of cells. Only the
+     * cells within the painted region are used.
+     */
+    struct Chunk
+    {
+        Cell erased[ChunkSize * ChunkSize];
+        Cell painted[ChunkSize * ChunkSize];
+    };
+
+    static quint64 chunkKey(int x, int y);
+    static int indexInChunk(int x, int y);
+
+    void record(const TileLayer *source, int x, int y,
+                const TileMask &paintRegion);
+
+    Chunk &chunkAt(int x, int y);
+    const Chunk &chunkAt(int x, int y) const;
+
     MapDocument *mMapDocument;
     TileLayer *mTarget;
-    TileLayer *mSource;
-    TileLayer *mErased;
-    int mX, mY;
-    QRegion mPaintedRegion;
+    TileMask mPaintedRegion;
+    QHash<quint64, Chunk> mChunks;
     bool mMergeable;
 };
 
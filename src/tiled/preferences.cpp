@@ -22,10 +22,12 @@
 #include "preferences.h"
 
 #include "documentmanager.h"
+#include "imagecache.h"
 #include "languagemanager.h"
 #include "mapdocument.h"
 #include "pluginmanager.h"
 #include "savefile.h"
+#include "tilesetcache.h"
 #include "tilesetmanager.h"
 
 #include <QDebug>
@@ -61,13 +63,21 @@ Preferences::Preferences()
     mMapRenderOrder = static_cast<Map::RenderOrder>
             (intValue("MapRenderOrder", Map::RightDown));
     mDtdEnabled = boolValue("DtdEnabled");
+    mEmbeddedImageFormat = static_cast<EmbeddedImageFormat>
+            (intValue("EmbeddedImageFormat", EmbedPng));
     mSafeSavingEnabled = boolValue("SafeSavingEnabled", true);
+    mTilesetCacheEnabled = boolValue("TilesetCache", false);
     mReloadTilesetsOnChange = boolValue("ReloadTilesets", true);
+    mUndoMemoryLimit = intValue("UndoMemoryLimit", 256);
+    mImageCacheSize = intValue("ImageCacheSize", 256);
     mStampsDirectory = stringValue("StampsDirectory");
     mObjectTypesFile = stringValue("ObjectTypesFile");
     mSettings->endGroup();
 
     SaveFile::setSafeSavingEnabled(mSafeSavingEnabled);
+    TilesetCache::setCacheDirectory(mTilesetCacheEnabled ? tilesetCacheDirectory()
+                                                          : QString());
+    ImageCache::setMaximumCost(qint64(mImageCacheSize) * 1024 * 1024);
 
     // Retrieve interface settings
     mSettings->beginGroup(QLatin1String("Interface"));
@@ -375,6 +385,17 @@ void Preferences::setDtdEnabled(bool enabled)
     mSettings->setValue(QLatin1String("Storage/DtdEnabled"), enabled);
 }
 
+EmbeddedImageFormat Preferences::embeddedImageFormat() const
+{
+    return mEmbeddedImageFormat;
+}
+
+void Preferences::setEmbeddedImageFormat(EmbeddedImageFormat format)
+{
+    mEmbeddedImageFormat = format;
+    mSettings->setValue(QLatin1String("Storage/EmbeddedImageFormat"), format);
+}
+
 void Preferences::setSafeSavingEnabled(bool enabled)
 {
     mSafeSavingEnabled = enabled;
@@ -382,6 +403,24 @@ void Preferences::setSafeSavingEnabled(bool enabled)
     SaveFile::setSafeSavingEnabled(enabled);
 }
 
+void Preferences::setTilesetCacheEnabled(bool enabled)
+{
+    mTilesetCacheEnabled = enabled;
+    mSettings->setValue(QLatin1String("Storage/TilesetCache"), enabled);
+    TilesetCache::setCacheDirectory(enabled ? tilesetCacheDirectory()
+                                            : QString());
+}
+
+/**
+ * Returns the directory where precompiled tilesets are stored when the
+ * tileset cache is enabled.
+ */
+QString Preferences::tilesetCacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + QLatin1String("/tilesets");
+}
+
 QString Preferences::language() const
 {
     return mLanguage;
@@ -418,6 +457,37 @@ void Preferences::setReloadTilesetsOnChanged(bool value)
     tilesetManager->setReloadTilesetsOnChange(mReloadTilesetsOnChange);
 }
 
+/**
+ * Sets the amount of memory the undo history of each document may use before
+ * older changes get compressed or moved to disk, in megabytes. A limit of 0
+ * means there is no limit.
+ */
+void Preferences::setUndoMemoryLimit(int megabytes)
+{
+    if (mUndoMemoryLimit == megabytes)
+        return;
+
+    mUndoMemoryLimit = megabytes;
+    mSettings->setValue(QLatin1String("Storage/UndoMemoryLimit"),
+                        mUndoMemoryLimit);
+    emit undoMemoryLimitChanged(mUndoMemoryLimit);
+}
+
+/**
+ * Sets the amount of memory used for keeping loaded images around that are
+ * not currently in use, in megabytes.
+ */
+void Preferences::setImageCacheSize(int megabytes)
+{
+    if (mImageCacheSize == megabytes)
+        return;
+
+    mImageCacheSize = megabytes;
+    mSettings->setValue(QLatin1String("Storage/ImageCacheSize"),
+                        mImageCacheSize);
+    ImageCache::setMaximumCost(qint64(mImageCacheSize) * 1024 * 1024);
+}
+
 void Preferences::setUseOpenGL(bool useOpenGL)
 {
     if (mUseOpenGL == useOpenGL)
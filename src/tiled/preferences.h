@@ -91,15 +91,26 @@ public:
     bool dtdEnabled() const;
     void setDtdEnabled(bool enabled);
 
+    EmbeddedImageFormat embeddedImageFormat() const;
+    void setEmbeddedImageFormat(EmbeddedImageFormat format);
+
     bool safeSavingEnabled() const;
     void setSafeSavingEnabled(bool enabled);
 
+    bool tilesetCacheEnabled() const;
+    void setTilesetCacheEnabled(bool enabled);
+    static QString tilesetCacheDirectory();
+
     QString language() const;
     void setLanguage(const QString &language);
 
     bool reloadTilesetsOnChange() const;
     void setReloadTilesetsOnChanged(bool value);
 
+    int undoMemoryLimit() const { return mUndoMemoryLimit; }
+
+    int imageCacheSize() const { return mImageCacheSize; }
+
     bool useOpenGL() const { return mUseOpenGL; }
     void setUseOpenGL(bool useOpenGL);
 
@@ -166,6 +177,8 @@ public slots:
     void setShowTilesetGrid(bool showTilesetGrid);
     void setAutomappingDrawing(bool enabled);
     void setOpenLastFilesOnStartup(bool load);
+    void setUndoMemoryLimit(int megabytes);
+    void setImageCacheSize(int megabytes);
     void setPluginEnabled(const QString &fileName, bool enabled);
 
     void clearRecentFiles();
@@ -190,6 +203,8 @@ signals:
 
     void useOpenGLChanged(bool useOpenGL);
 
+    void undoMemoryLimitChanged(int megabytes);
+
     void languageChanged();
 
     void objectTypesChanged();
@@ -235,9 +250,13 @@ private:
     Map::LayerDataFormat mLayerDataFormat;
     Map::RenderOrder mMapRenderOrder;
     bool mDtdEnabled;
+    EmbeddedImageFormat mEmbeddedImageFormat;
     bool mSafeSavingEnabled;
+    bool mTilesetCacheEnabled;
     QString mLanguage;
     bool mReloadTilesetsOnChange;
+    int mUndoMemoryLimit;
+    int mImageCacheSize;
     bool mUseOpenGL;
     ObjectTypes mObjectTypes;
 
@@ -277,6 +296,11 @@ inline bool Preferences::safeSavingEnabled() const
     return mSafeSavingEnabled;
 }
 
+inline bool Preferences::tilesetCacheEnabled() const
+{
+    return mTilesetCacheEnabled;
+}
+
 inline Preferences::ObjectLabelVisiblity Preferences::objectLabelVisibility() const
 {
     return mObjectLabelVisibility;
@@ -63,6 +63,15 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
     mUi->styleCombo->setItemData(0, Preferences::SystemDefaultStyle);
     mUi->styleCombo->setItemData(1, Preferences::TiledStyle);
 
+    mUi->embeddedImageFormat->addItems(QStringList()
+                                       << QApplication::translate("PreferencesDialog", "PNG")
+                                       << QApplication::translate("PreferencesDialog", "Compressed pixels")
+                                       << QApplication::translate("PreferencesDialog", "WebP (lossless)"));
+
+    mUi->embeddedImageFormat->setItemData(0, EmbedPng);
+    mUi->embeddedImageFormat->setItemData(1, EmbedPixelData);
+    mUi->embeddedImageFormat->setItemData(2, EmbedWebP);
+
     PluginListModel *pluginListModel = new PluginListModel(this);
     QSortFilterProxyModel *pluginProxyModel = new QSortFilterProxyModel(this);
     pluginProxyModel->setSortLocaleAware(true);
@@ -84,6 +93,14 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
             preferences, &Preferences::setOpenLastFilesOnStartup);
     connect(mUi->safeSaving, &QCheckBox::toggled,
             preferences, &Preferences::setSafeSavingEnabled);
+    connect(mUi->tilesetCache, &QCheckBox::toggled,
+            preferences, &Preferences::setTilesetCacheEnabled);
+    connect(mUi->undoMemoryLimit, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            preferences, &Preferences::setUndoMemoryLimit);
+    connect(mUi->imageCacheSize, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            preferences, &Preferences::setImageCacheSize);
+    connect(mUi->embeddedImageFormat, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, &PreferencesDialog::embeddedImageFormatChanged);
 
     connect(mUi->languageCombo, SIGNAL(currentIndexChanged(int)),
             SLOT(languageSelected(int)));
@@ -146,6 +163,14 @@ void PreferencesDialog::fromPreferences()
     mUi->enableDtd->setChecked(prefs->dtdEnabled());
     mUi->openLastFiles->setChecked(prefs->openLastFilesOnStartup());
     mUi->safeSaving->setChecked(prefs->safeSavingEnabled());
+    mUi->tilesetCache->setChecked(prefs->tilesetCacheEnabled());
+    mUi->undoMemoryLimit->setValue(prefs->undoMemoryLimit());
+    mUi->imageCacheSize->setValue(prefs->imageCacheSize());
+
+    int embeddedImageFormatIndex = mUi->embeddedImageFormat->findData(prefs->embeddedImageFormat());
+    if (embeddedImageFormatIndex == -1)
+        embeddedImageFormatIndex = 0;
+    mUi->embeddedImageFormat->setCurrentIndex(embeddedImageFormatIndex);
     if (mUi->openGL->isEnabled())
         mUi->openGL->setChecked(prefs->useOpenGL());
 
@@ -190,6 +215,16 @@ void PreferencesDialog::retranslateUi()
 
     mUi->styleCombo->setItemText(0, QApplication::translate("PreferencesDialog", "Native"));
     mUi->styleCombo->setItemText(1, QApplication::translate("PreferencesDialog", "Tiled Fusion"));
+
+    mUi->embeddedImageFormat->setItemText(0, QApplication::translate("PreferencesDialog", "PNG"));
+    mUi->embeddedImageFormat->setItemText(1, QApplication::translate("PreferencesDialog", "Compressed pixels"));
+    mUi->embeddedImageFormat->setItemText(2, QApplication::translate("PreferencesDialog", "WebP (lossless)"));
+}
+
+void PreferencesDialog::embeddedImageFormatChanged()
+{
+    const int format = mUi->embeddedImageFormat->currentData().toInt();
+    Preferences::instance()->setEmbeddedImageFormat(static_cast<EmbeddedImageFormat>(format));
 }
 
 void PreferencesDialog::styleComboChanged()
@@ -55,6 +55,7 @@ private:
     void retranslateUi();
 
     void styleComboChanged();
+    void embeddedImageFormatChanged();
 
     void autoUpdateToggled(bool checked);
     void checkForUpdates();
@@ -224,6 +224,8 @@ bool RaiseLowerHelper::initContext()
 
     // The list of related items are all items from the same object group
     // that share space with the selected items.
+    mMapScene->materializeObjectItems(shape.boundingRect());
+
     const QList<QGraphicsItem*> items = mMapScene->items(shape,
                                                          Qt::IntersectsItemShape,
                                                          Qt::AscendingOrder);
@@ -38,6 +38,7 @@ ResizeTileLayer::ResizeTileLayer(MapDocument *mapDocument,
     : QUndoCommand(QCoreApplication::translate("Undo Commands",
                                                "Resize Layer"),
                    parent)
+    , CompressibleCommand(mapDocument->undoMemoryLimiter())
     , mMapDocument(mapDocument)
     , mDone(false)
     , mOriginalLayer(layer)
@@ -58,6 +59,8 @@ ResizeTileLayer::~ResizeTileLayer()
 void ResizeTileLayer::undo()
 {
     Q_ASSERT(mDone);
+    if (!ensureLoaded())
+        return;
     LayerModel *layerModel = mMapDocument->layerModel();
     layerModel->replaceLayer(mResizedLayer, mOriginalLayer);
     mDone = false;
@@ -66,7 +69,33 @@ void ResizeTileLayer::undo()
 void ResizeTileLayer::redo()
 {
     Q_ASSERT(!mDone);
+    if (!ensureLoaded())
+        return;
     LayerModel *layerModel = mMapDocument->layerModel();
     layerModel->replaceLayer(mOriginalLayer, mResizedLayer);
     mDone = true;
 }
+
+qint64 ResizeTileLayer::dataSize() const
+{
+    const TileLayer *layer = inactiveLayer();
+    return qint64(layer->width()) * layer->height() * sizeof(Cell);
+}
+
+QByteArray ResizeTileLayer::saveData()
+{
+    return inactiveLayer()->takeCells();
+}
+
+void ResizeTileLayer::loadData(const QByteArray &data)
+{
+    inactiveLayer()->restoreCells(data);
+}
+
+/**
+ * Returns the layer that is currently not part of the map.
+ */
+TileLayer *ResizeTileLayer::inactiveLayer() const
+{
+    return mDone ? mOriginalLayer : mResizedLayer;
+}
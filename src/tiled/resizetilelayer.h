@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "undomemorylimiter.h"
+
 #include <QPoint>
 #include <QSize>
 #include <QUndoCommand>
@@ -36,7 +38,7 @@ class MapDocument;
 /**
  * Undo command that resizes a map layer.
  */
-class ResizeTileLayer : public QUndoCommand
+class ResizeTileLayer : public QUndoCommand, public CompressibleCommand
 {
 public:
     /**
@@ -54,7 +56,14 @@ public:
     void undo() override;
     void redo() override;
 
+protected:
+    qint64 dataSize() const override;
+    QByteArray saveData() override;
+    void loadData(const QByteArray &data) override;
+
 private:
+    TileLayer *inactiveLayer() const;
+
     MapDocument *mMapDocument;
     bool mDone;
     TileLayer *mOriginalLayer;
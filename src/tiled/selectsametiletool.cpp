@@ -45,13 +45,13 @@ void SelectSameTileTool::tilePositionChanged(const QPoint &tilePos)
     if (!tileLayer)
         return;
 
-    QRegion resultRegion;
+    TileMask resultRegion;
     if (tileLayer->contains(tilePos)) {
         const Cell &matchCell = tileLayer->cellAt(tilePos);
-        resultRegion = tileLayer->region([&] (const Cell &cell) { return cell == matchCell; });
+        resultRegion = tileLayer->mask([&] (const Cell &cell) { return cell == matchCell; });
     }
     mSelectedRegion = resultRegion;
-    brushItem()->setTileRegion(mSelectedRegion);
+    brushItem()->setTileRegion(mSelectedRegion.toRegion());
 }
 
 void SelectSameTileTool::mousePressed(QGraphicsSceneMouseEvent *event)
@@ -64,24 +64,23 @@ void SelectSameTileTool::mousePressed(QGraphicsSceneMouseEvent *event)
 
     MapDocument *document = mapDocument();
 
-    QRegion selection;
+    TileMask selection;
 
     // Left button modifies selection, right button clears selection
     if (button == Qt::LeftButton) {
-        selection = document->selectedArea();
+        selection = mSelectedRegion;
 
         if (modifiers == Qt::ShiftModifier)
-            selection += mSelectedRegion;
+            selection += TileMask(document->selectedArea());
         else if (modifiers == Qt::ControlModifier)
-            selection -= mSelectedRegion;
+            selection = TileMask(document->selectedArea()).subtracted(mSelectedRegion);
         else if (modifiers == (Qt::ControlModifier | Qt::ShiftModifier))
-            selection &= mSelectedRegion;
-        else
-            selection = mSelectedRegion;
+            selection &= TileMask(document->selectedArea());
     }
 
-    if (selection != document->selectedArea()) {
-        QUndoCommand *cmd = new ChangeSelectedArea(document, selection);
+    const QRegion selectedArea = selection.toRegion();
+    if (selectedArea != document->selectedArea()) {
+        QUndoCommand *cmd = new ChangeSelectedArea(document, selectedArea);
         document->undoStack()->push(cmd);
     }
 }
@@ -51,7 +51,7 @@ protected:
 
 private:
 
-    QRegion mSelectedRegion;
+    TileMask mSelectedRegion;
 };
 
 } // namespace Internal
@@ -27,17 +27,11 @@
 #include "mapdocument.h"
 #include "mapscene.h"
 #include "painttilelayer.h"
-#include "randompicker.h"
-#include "staggeredrenderer.h"
 #include "terrain.h"
-#include "tile.h"
 #include "tilelayer.h"
-#include "tileset.h"
 
 #include <QVector>
 
-#include <climits>
-
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -54,8 +48,15 @@ TerrainBrush::TerrainBrush(QObject *parent)
     , mMirrorDiagonally(false)
     , mLineReferenceX(0)
     , mLineReferenceY(0)
+    , mHasStartPointList(false)
+    , mTimeBudget(10)
 {
     setBrushMode(PaintTile);
+
+    mContinueTimer.setSingleShot(true);
+    mContinueTimer.setInterval(0);
+    connect(&mContinueTimer, &QTimer::timeout,
+            this, &TerrainBrush::continueBrushUpdate);
 }
 
 TerrainBrush::~TerrainBrush()
@@ -169,6 +170,8 @@ void TerrainBrush::mapDocumentChanged(MapDocument *oldDocument,
     AbstractTileTool::mapDocumentChanged(oldDocument, newDocument);
 
     // Reset the brush, since it probably became invalid
+    mContinueTimer.stop();
+    mFiller.clear();
     brushItem()->clear();
 }
 
@@ -216,6 +219,9 @@ void TerrainBrush::capture()
 
 void TerrainBrush::doPaint(bool mergeable)
 {
+    // Make sure the brush is up to date before painting it
+    finishBrushUpdate();
+
     TileLayer *stamp = brushItem()->tileLayer().data();
 
     if (!stamp)
@@ -236,98 +242,18 @@ void TerrainBrush::doPaint(bool mergeable)
     emit mapDocument()->regionEdited(brushItem()->tileRegion(), tileLayer);
 }
 
-static Tile *findBestTile(const Tileset &tileset, unsigned terrain, unsigned considerationMask)
-{
-    // we should have hooked 0xFFFFFFFF terrains outside this function
-    Q_ASSERT(terrain != 0xFFFFFFFF);
-
-    RandomPicker<Tile*> matches;
-    int penalty = INT_MAX;
-
-    // TODO: this is a slow linear search, perhaps we could use a better find algorithm...
-    for (Tile *t : tileset.tiles()) {
-        if ((t->terrain() & considerationMask) != (terrain & considerationMask))
-            continue;
-
-        // calculate the tile transition penalty based on shortest distance to target terrain type
-        int tr = tileset.terrainTransitionPenalty(t->terrain() >> 24, terrain >> 24);
-        int tl = tileset.terrainTransitionPenalty((t->terrain() >> 16) & 0xFF, (terrain >> 16) & 0xFF);
-        int br = tileset.terrainTransitionPenalty((t->terrain() >> 8) & 0xFF, (terrain >> 8) & 0xFF);
-        int bl = tileset.terrainTransitionPenalty(t->terrain() & 0xFF, terrain & 0xFF);
-
-        // if there is no path to the destination terrain, this isn't a useful transition
-        if (tr < 0 || tl < 0 || br < 0 || bl < 0)
-            continue;
-
-        // add tile to the candidate list
-        int transitionPenalty = tr + tl + br + bl;
-        if (transitionPenalty <= penalty) {
-            if (transitionPenalty < penalty)
-                matches.clear();
-            penalty = transitionPenalty;
-
-            matches.add(t, t->probability());
-        }
-    }
-
-    // choose a candidate at random, with consideration for probability
-    if (!matches.isEmpty())
-        return matches.pick();
-
-    // TODO: conveniently, the null tile doesn't currently work, but when it does, we need to signal a failure to find any matches some other way
-    return nullptr;
-}
-
-static unsigned terrain(const Tile *tile)
-{
-    return tile ? tile->terrain() : 0xFFFFFFFF;
-}
-
-static unsigned short topEdge(const Tile *tile)
-{
-    return terrain(tile) >> 16;
-}
-
-static unsigned short bottomEdge(const Tile *tile)
-{
-    return terrain(tile) & 0xFFFF;
-}
-
-static unsigned short leftEdge(const Tile *tile)
-{
-    unsigned t = terrain(tile);
-    return((t >> 16) & 0xFF00) | ((t >> 8) & 0xFF);
-}
-
-static unsigned short rightEdge(const Tile *tile)
-{
-    unsigned t = terrain(tile);
-    return ((t >> 8) & 0xFF00) | (t & 0xFF);
-}
-
-namespace {
-
-struct ConsiderationPoint : public QPoint
-{
-    ConsiderationPoint()
-        : paintCorner(0)
-    {}
-
-    ConsiderationPoint(QPoint p, int paintCorner = 0)
-        : QPoint(p)
-        , paintCorner(paintCorner)
-    {}
-
-    int paintCorner;
-};
-
-} // anonymous namespace
-
 void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
 {
     mPaintX = cursorPos.x();
     mPaintY = cursorPos.y();
 
+    // remember the start points, in case the update needs to start over
+    mHasStartPointList = list != nullptr;
+    if (list)
+        mStartPointList = *list;
+    else
+        mStartPointList.clear();
+
     // get the current tile layer
     TileLayer *currentLayer = currentTileLayer();
     Q_ASSERT(currentLayer);
@@ -335,7 +261,6 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
     const QPoint layerPosition = currentLayer->position();
     const int layerWidth = currentLayer->width();
     const int layerHeight = currentLayer->height();
-    const int numTiles = layerWidth * layerHeight;
     int paintCorner = 0;
 
     cursorPos -= layerPosition;
@@ -354,238 +279,100 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
 
     // if the cursor is outside of the map, bail out
     if (!currentLayer->contains(cursorPos)) {
+        mContinueTimer.stop();
+        mFiller.clear();
         brushItem()->clear();
         return;
     }
 
-    Tileset *terrainTileset = nullptr;
-    int terrainId = -1;
-    if (mTerrain) {
-        terrainTileset = mTerrain->tileset();
-        terrainId = mTerrain->id();
-    }
-
-    // allocate a buffer to build the terrain tilemap (TODO: this could be retained per layer to save regular allocation)
-    Tile **newTerrain = new Tile*[numTiles];
-
-    // allocate a buffer of flags for each tile that may be considered (TODO: this could be retained per layer to save regular allocation)
-    char *checked = new char[numTiles];
-    memset(checked, 0, numTiles);
-
     // create a consideration list, and push the start points
-    QVector<ConsiderationPoint> transitionList;
+    QVector<TerrainFiller::Point> startPoints;
 
     if (list) { // if we were supplied a list of start points
-        transitionList.reserve(list->size());
+        startPoints.reserve(list->size());
         for (QPoint p : *list) {
             p -= layerPosition;
             if (currentLayer->contains(p))
-                transitionList.append(p);
+                startPoints.append(p);
         }
     } else {
-        transitionList.append(ConsiderationPoint(cursorPos, paintCorner));
+        startPoints.append(TerrainFiller::Point(cursorPos, paintCorner));
     }
 
     if (mMirrorDiagonally) {
-        const int w = currentLayer->width();
-        const int h = currentLayer->height();
-
-        for (int i = 0, e = transitionList.size(); i < e; ++i) {
-            const auto &p = transitionList.at(i);
-            transitionList.append(ConsiderationPoint(QPoint(w - p.x() - 1,
-                                                            h - p.y() - 1),
-                                                     p.paintCorner ^ 3));
+        for (int i = 0, e = startPoints.size(); i < e; ++i) {
+            const auto &p = startPoints.at(i);
+            startPoints.append(TerrainFiller::Point(QPoint(layerWidth - p.x() - 1,
+                                                           layerHeight - p.y() - 1),
+                                                    p.paintCorner ^ 3));
         }
     }
 
-    int initialTiles = transitionList.size();
-
-    QRect brushRect(cursorPos, cursorPos);
-
-    // produce terrain with transitions using a simple, relative naive approach (considers each tile once, and doesn't allow re-consideration if selection was bad)
-    while (!transitionList.isEmpty()) {
-        // get the next point in the consideration list
-        ConsiderationPoint p = transitionList.takeFirst();
-        int x = p.x(), y = p.y();
-        int i = y*layerWidth + x;
-
-        // if we have already considered this point, skip to the next
-        // TODO: we might want to allow re-consideration if prior tiles... but not for now, this would risk infinite loops
-        if (checked[i])
-            continue;
-
-        // to support isometric staggered, make edges into variables
-        QPoint upPoint(x, y-1);
-        QPoint bottomPoint(x, y+1);
-        QPoint leftPoint(x-1, y);
-        QPoint rightPoint(x+1, y);
-
-        if (auto renderer = dynamic_cast<StaggeredRenderer*>(mapDocument()->renderer())) {
-            upPoint = renderer->topRight(x, y);
-            bottomPoint = renderer->bottomLeft(x, y);
-            leftPoint = renderer->topLeft(x, y);
-            rightPoint = renderer->bottomRight(x, y);
-        }
+    mFiller.begin(currentLayer, mapDocument()->renderer(), mTerrain,
+                  mBrushMode == PaintVertex, startPoints);
 
-        int upperIndex = upPoint.y()*layerWidth + upPoint.x();
-        int bottomIndex = bottomPoint.y()*layerWidth + bottomPoint.x();
-        int leftIndex = leftPoint.y()*layerWidth + leftPoint.x();
-        int rightIndex = rightPoint.y()*layerWidth + rightPoint.x();
-
-        const Tile *tile = currentLayer->cellAt(p).tile();
-        const unsigned currentTerrain = ::terrain(tile);
-
-        // get the tileset for this tile
-        Tileset *tileset = nullptr;
-        if (terrainTileset) {
-            // if we are painting a terrain, then we'll use the terrains tileset
-            tileset = terrainTileset;
-        } else if (tile) {
-            // if we're erasing terrain, use the individual tiles tileset (to search for transitions)
-            tileset = tile->tileset();
-        } else {
-            // no tile here and we're erasing terrain, not much we can do
-            continue;
-        }
+    if (mFiller.proceed(mTimeBudget))
+        applyFillResult();
+    else
+        mContinueTimer.start();
+}
 
-        // calculate the ideal tile for this position
-        unsigned preferredTerrain = 0xFFFFFFFF;
-        unsigned mask = 0;
-
-        if (initialTiles) {
-            // for the initial tiles, we will insert the selected terrain and add the surroundings for consideration
-            if (mBrushMode == PaintTile) {
-                // set the whole tile to the selected terrain
-                preferredTerrain = makeTerrain(terrainId);
-                mask = 0xFFFFFFFF;
-            } else {
-                // Bail out if encountering a tile from a different tileset
-                if (tile && tile->tileset() != tileset)
-                    continue;
-
-                // calculate the corner mask
-                mask = 0xFF << (3 - p.paintCorner)*8;
-
-                // mask in the selected terrain
-                preferredTerrain = (currentTerrain & ~mask) | (terrainId << (3 - p.paintCorner)*8);
-            }
-
-            --initialTiles;
-
-            // if there's nothing to paint... skip this tile
-            if (preferredTerrain == currentTerrain && (!tile || tile->tileset() == tileset))
-                continue;
-        } else {
-            // Bail out if encountering a tile from a different tileset
-            if (tile && tile->tileset() != tileset)
-                continue;
-
-            // following tiles each need consideration against their surroundings
-            preferredTerrain = currentTerrain;
-            mask = 0;
-
-            // depending which connections have been set, we update the preferred terrain of the tile accordingly
-            if (currentLayer->contains(upPoint) && checked[upperIndex]) {
-                preferredTerrain = (::terrain(newTerrain[upperIndex]) << 16) | (preferredTerrain & 0x0000FFFF);
-                mask |= 0xFFFF0000;
-            }
-            if (currentLayer->contains(bottomPoint) && checked[bottomIndex]) {
-                preferredTerrain = (::terrain(newTerrain[bottomIndex]) >> 16) | (preferredTerrain & 0xFFFF0000);
-                mask |= 0x0000FFFF;
-            }
-            if (currentLayer->contains(leftPoint) && checked[leftIndex]) {
-                preferredTerrain = ((::terrain(newTerrain[leftIndex]) << 8) & 0xFF00FF00) | (preferredTerrain & 0x00FF00FF);
-                mask |= 0xFF00FF00;
-            }
-            if (currentLayer->contains(rightPoint) && checked[rightIndex]) {
-                preferredTerrain = ((::terrain(newTerrain[rightIndex]) >> 8) & 0x00FF00FF) | (preferredTerrain & 0xFF00FF00);
-                mask |= 0x00FF00FF;
-            }
-        }
+void TerrainBrush::continueBrushUpdate()
+{
+    if (!mFiller.layer())
+        return;
 
-        // find the most appropriate tile in the tileset
-        // if all quadrants are set to 'no terrain', then the 'empty' tile is the only choice we can deduce
-        Tile *paste = nullptr;
-        if (preferredTerrain != 0xFFFFFFFF) {
-            paste = findBestTile(*tileset, preferredTerrain, mask);
-            if (!paste)
-                continue;
+    // Start over when the layer or the map changed in the meantime
+    if (isFillOutdated()) {
+        mFiller.clear();
+        if (currentTileLayer() && brushItem()->isVisible()) {
+            const QVector<QPoint> list = mStartPointList;
+            updateBrush(QPoint(mPaintX, mPaintY),
+                        mHasStartPointList ? &list : nullptr);
         }
+        return;
+    }
 
-        // add tile to the brush
-        newTerrain[i] = paste;
-        checked[i] = true;
+    if (mFiller.proceed(mTimeBudget))
+        applyFillResult();
+    else
+        mContinueTimer.start();
+}
 
-        // expand the brush rect to fit the edit set
-        brushRect |= QRect(p, p);
+void TerrainBrush::finishBrushUpdate()
+{
+    if (!mFiller.layer() || mFiller.isFinished())
+        return;
 
-        // consider surrounding tiles if terrain constraints were not satisfied
-        if (currentLayer->contains(upPoint) && !checked[upperIndex]) {
-            const Tile *above = currentLayer->cellAt(upPoint).tile();
-            if (topEdge(paste) != bottomEdge(above))
-                transitionList.append(upPoint);
-        }
-        if (currentLayer->contains(bottomPoint) && !checked[bottomIndex]) {
-            const Tile *below = currentLayer->cellAt(bottomPoint).tile();
-            if (bottomEdge(paste) != topEdge(below))
-                transitionList.append(bottomPoint);
-        }
-        if (currentLayer->contains(leftPoint) && !checked[leftIndex]) {
-            const Tile *left = currentLayer->cellAt(leftPoint).tile();
-            if (leftEdge(paste) != rightEdge(left))
-                transitionList.append(leftPoint);
-        }
-        if (currentLayer->contains(rightPoint) && !checked[rightIndex]) {
-            const Tile *right = currentLayer->cellAt(rightPoint).tile();
-            if (rightEdge(paste) != leftEdge(right))
-                transitionList.append(rightPoint);
-        }
-    }
+    mContinueTimer.stop();
 
-    // create a stamp for the terrain block
-    QRegion brushRegion;
-    SharedTileLayer stamp = SharedTileLayer(new TileLayer(QString(),
-                                                          brushRect.left(),
-                                                          brushRect.top(),
-                                                          brushRect.width(),
-                                                          brushRect.height()));
-
-    for (int y = brushRect.top(); y <= brushRect.bottom(); ++y) {
-        for (int x = brushRect.left(); x <= brushRect.right(); ++x) {
-            int i = y * layerWidth + x;
-            if (!checked[i])
-                continue;
-
-            stamp->setCell(x - brushRect.left(),
-                           y - brushRect.top(),
-                           Cell(newTerrain[i]));
-
-            // detect the affected region in ranges, which makes things faster
-            const int rangeStart = x;
-
-            for (++x; x <= brushRect.right() + 1; ++x) {
-                i = y * layerWidth + x;
-                if (x == brushRect.right() + 1 || !checked[i]) {
-                    const int rangeEnd = x;
-                    brushRegion += QRect(rangeStart, y,
-                                         rangeEnd - rangeStart, 1);
-                    break;
-                } else {
-                    stamp->setCell(x - brushRect.left(),
-                                   y - brushRect.top(),
-                                   Cell(newTerrain[i]));
-                }
-            }
-        }
+    // Abort the fill when the layer or the map changed in the meantime,
+    // rather than completing it for a layer that may no longer exist
+    if (isFillOutdated()) {
+        mFiller.clear();
+        brushItem()->clear();
+        return;
     }
 
-    // Translate to map coordinate space
-    stamp->setPosition(brushRect.topLeft() + layerPosition);
-    brushRegion.translate(layerPosition);
+    mFiller.proceed();
+    applyFillResult();
+}
 
-    // set the new tile layer as the brush
-    brushItem()->setTileLayer(stamp, brushRegion);
+/**
+ * Returns whether the pending fill was started for a layer that is no longer
+ * the current one, or that has changed size, or for a different renderer.
+ */
+bool TerrainBrush::isFillOutdated() const
+{
+    const TileLayer *currentLayer = currentTileLayer();
+    return !currentLayer ||
+            currentLayer != mFiller.layer() ||
+            currentLayer->size() != mFiller.layerSize() ||
+            mapDocument()->renderer() != mFiller.renderer();
+}
 
-    delete[] checked;
-    delete[] newTerrain;
+void TerrainBrush::applyFillResult()
+{
+    // set the new tile layer as the brush
+    brushItem()->setTileLayer(mFiller.stamp(), mFiller.region());
 }
@@ -23,8 +23,11 @@
 #pragma once
 
 #include "abstracttiletool.h"
+#include "terrainfiller.h"
 #include "tilelayer.h"
 
+#include <QTimer>
+
 namespace Tiled {
 
 class Tile;
@@ -81,6 +84,15 @@ public:
         setTilePositionMethod(mode == PaintTile ? OnTiles : BetweenTiles);
     }
 
+    /**
+     * Sets the time in milliseconds the brush may spend on updating its
+     * preview before returning to the event loop. The rest of the update is
+     * completed asynchronously. A budget of 0 means the preview is always
+     * updated right away.
+     */
+    void setTimeBudget(int milliseconds) { mTimeBudget = milliseconds; }
+    int timeBudget() const { return mTimeBudget; }
+
 signals:
     void terrainCaptured(Terrain *terrain);
 
@@ -106,6 +118,20 @@ private:
      */
     void updateBrush(QPoint cursorPos, const QVector<QPoint> *list = nullptr);
 
+    /**
+     * Continues an update of the brush that ran out of time.
+     */
+    void continueBrushUpdate();
+
+    /**
+     * Completes any pending update of the brush right away.
+     */
+    void finishBrushUpdate();
+
+    bool isFillOutdated() const;
+
+    void applyFillResult();
+
     /**
      * The terrain we are currently painting.
      */
@@ -140,6 +166,17 @@ private:
      * When drawing circles this will be the midpoint.
      */
     int mLineReferenceX, mLineReferenceY;
+
+    /**
+     * The start points passed to the last updateBrush() call, used when the
+     * update needs to start over.
+     */
+    QVector<QPoint> mStartPointList;
+    bool mHasStartPointList;
+
+    TerrainFiller mFiller;
+    QTimer mContinueTimer;
+    int mTimeBudget;
 };
 
 } // namespace Internal
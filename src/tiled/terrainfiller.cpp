@@ -0,0 +1,381 @@
+/*
+ * terrainfiller.cpp
+ * Copyright 2012, Manu Evans <turkeyman@gmail.com>
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "terrainfiller.h"
+
+#include "randompicker.h"
+#include "staggeredrenderer.h"
+#include "terrain.h"
+#include "tile.h"
+#include "tileset.h"
+
+#include <QElapsedTimer>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+static Tile *findBestTile(const Tileset &tileset, unsigned terrain, unsigned considerationMask)
+{
+    // we should have hooked 0xFFFFFFFF terrains outside this function
+    Q_ASSERT(terrain != 0xFFFFFFFF);
+
+    // the tileset looks up the tiles with the lowest transition penalty
+    const QVector<Tile*> candidates = tileset.bestTerrainTiles(terrain, considerationMask);
+
+    RandomPicker<Tile*> matches;
+    for (Tile *t : candidates)
+        matches.add(t, t->probability());
+
+    // choose a candidate at random, with consideration for probability
+    if (!matches.isEmpty())
+        return matches.pick();
+
+    // TODO: conveniently, the null tile doesn't currently work, but when it does, we need to signal a failure to find any matches some other way
+    return nullptr;
+}
+
+static unsigned terrain(const Tile *tile)
+{
+    return tile ? tile->terrain() : 0xFFFFFFFF;
+}
+
+static unsigned short topEdge(const Tile *tile)
+{
+    return terrain(tile) >> 16;
+}
+
+static unsigned short bottomEdge(const Tile *tile)
+{
+    return terrain(tile) & 0xFFFF;
+}
+
+static unsigned short leftEdge(const Tile *tile)
+{
+    unsigned t = terrain(tile);
+    return((t >> 16) & 0xFF00) | ((t >> 8) & 0xFF);
+}
+
+static unsigned short rightEdge(const Tile *tile)
+{
+    unsigned t = terrain(tile);
+    return ((t >> 8) & 0xFF00) | (t & 0xFF);
+}
+
+TerrainFiller::TerrainFiller()
+    : mLayer(nullptr)
+    , mRenderer(nullptr)
+    , mStaggeredRenderer(nullptr)
+    , mTerrainTileset(nullptr)
+    , mTerrainId(-1)
+    , mPaintCorners(false)
+    , mHead(0)
+    , mStartPointCount(0)
+{
+}
+
+void TerrainFiller::begin(const TileLayer *layer,
+                          const MapRenderer *renderer,
+                          const Terrain *terrain,
+                          bool paintCorners,
+                          const QVector<Point> &startPoints)
+{
+    clear();
+
+    mLayer = layer;
+    mRenderer = renderer;
+    mStaggeredRenderer = dynamic_cast<const StaggeredRenderer*>(renderer);
+    mLayerPosition = layer->position();
+    mPaintCorners = paintCorners;
+
+    if (terrain) {
+        mTerrainTileset = terrain->tileset();
+        mTerrainId = terrain->id();
+    } else {
+        mTerrainTileset = nullptr;
+        mTerrainId = -1;
+    }
+
+    // The scratch buffers only need to be reallocated when the layer size
+    // changes. Otherwise they were reset by clear().
+    if (mLayerSize != layer->size()) {
+        mLayerSize = layer->size();
+
+        const int numTiles = mLayerSize.width() * mLayerSize.height();
+        mNewTerrain.fill(nullptr, numTiles);
+        mChecked.fill(false, numTiles);
+        mCheckedIndices.clear();
+    }
+
+    mQueue = startPoints;
+    mStartPointCount = startPoints.size();
+}
+
+bool TerrainFiller::proceed(int timeBudget)
+{
+    Q_ASSERT(mLayer || isFinished());
+
+    QElapsedTimer timer;
+    if (timeBudget > 0)
+        timer.start();
+
+    // produce terrain with transitions using a simple, relative naive approach (considers each tile once, and doesn't allow re-consideration if selection was bad)
+    int considered = 0;
+    while (mHead < mQueue.size()) {
+        // the start points are at the front of the queue
+        const bool isStartPoint = mHead < mStartPointCount;
+        const Point p = mQueue.at(mHead++);
+        consider(p, isStartPoint);
+
+        // checking the time is relatively expensive, so only do it once in a while
+        if (timeBudget > 0 && (++considered & 0x3F) == 0) {
+            if (timer.elapsed() >= timeBudget)
+                break;
+        }
+    }
+
+    if (!isFinished())
+        return false;
+
+    // the queue is no longer needed, but keep its memory for the next fill
+    mQueue.resize(0);
+    mHead = 0;
+
+    // the result does not depend on the layer, which may go away
+    mLayer = nullptr;
+    mRenderer = nullptr;
+    mStaggeredRenderer = nullptr;
+    return true;
+}
+
+void TerrainFiller::clear()
+{
+    for (int index : mCheckedIndices)
+        mChecked.clearBit(index);
+
+    mCheckedIndices.resize(0);
+    mQueue.resize(0);
+    mHead = 0;
+    mStartPointCount = 0;
+    mBrushRect = QRect();
+    mLayer = nullptr;
+    mRenderer = nullptr;
+    mStaggeredRenderer = nullptr;
+}
+
+void TerrainFiller::setChecked(int index)
+{
+    mChecked.setBit(index);
+    mCheckedIndices.append(index);
+}
+
+void TerrainFiller::consider(const Point &p, bool isStartPoint)
+{
+    const int layerWidth = mLayerSize.width();
+    const int x = p.x(), y = p.y();
+    const int i = y * layerWidth + x;
+
+    // if we have already considered this point, skip to the next
+    // TODO: we might want to allow re-consideration if prior tiles... but not for now, this would risk infinite loops
+    if (isChecked(i))
+        return;
+
+    // to support isometric staggered, make edges into variables
+    QPoint upPoint(x, y-1);
+    QPoint bottomPoint(x, y+1);
+    QPoint leftPoint(x-1, y);
+    QPoint rightPoint(x+1, y);
+
+    if (mStaggeredRenderer) {
+        upPoint = mStaggeredRenderer->topRight(x, y);
+        bottomPoint = mStaggeredRenderer->bottomLeft(x, y);
+        leftPoint = mStaggeredRenderer->topLeft(x, y);
+        rightPoint = mStaggeredRenderer->bottomRight(x, y);
+    }
+
+    const int upperIndex = upPoint.y()*layerWidth + upPoint.x();
+    const int bottomIndex = bottomPoint.y()*layerWidth + bottomPoint.x();
+    const int leftIndex = leftPoint.y()*layerWidth + leftPoint.x();
+    const int rightIndex = rightPoint.y()*layerWidth + rightPoint.x();
+
+    const bool hasUp = mLayer->contains(upPoint);
+    const bool hasBottom = mLayer->contains(bottomPoint);
+    const bool hasLeft = mLayer->contains(leftPoint);
+    const bool hasRight = mLayer->contains(rightPoint);
+
+    const Tile *tile = mLayer->cellAt(p).tile();
+    const unsigned currentTerrain = ::terrain(tile);
+
+    // get the tileset for this tile
+    Tileset *tileset = nullptr;
+    if (mTerrainTileset) {
+        // if we are painting a terrain, then we'll use the terrains tileset
+        tileset = mTerrainTileset;
+    } else if (tile) {
+        // if we're erasing terrain, use the individual tiles tileset (to search for transitions)
+        tileset = tile->tileset();
+    } else {
+        // no tile here and we're erasing terrain, not much we can do
+        return;
+    }
+
+    // calculate the ideal tile for this position
+    unsigned preferredTerrain = 0xFFFFFFFF;
+    unsigned mask = 0;
+
+    if (isStartPoint) {
+        // for the initial tiles, we will insert the selected terrain and add the surroundings for consideration
+        if (!mPaintCorners) {
+            // set the whole tile to the selected terrain
+            preferredTerrain = makeTerrain(mTerrainId);
+            mask = 0xFFFFFFFF;
+        } else {
+            // Bail out if encountering a tile from a different tileset
+            if (tile && tile->tileset() != tileset)
+                return;
+
+            // calculate the corner mask
+            mask = 0xFF << (3 - p.paintCorner)*8;
+
+            // mask in the selected terrain
+            preferredTerrain = (currentTerrain & ~mask) | (mTerrainId << (3 - p.paintCorner)*8);
+        }
+
+        // if there's nothing to paint... skip this tile
+        if (preferredTerrain == currentTerrain && (!tile || tile->tileset() == tileset))
+            return;
+    } else {
+        // Bail out if encountering a tile from a different tileset
+        if (tile && tile->tileset() != tileset)
+            return;
+
+        // following tiles each need consideration against their surroundings
+        preferredTerrain = currentTerrain;
+        mask = 0;
+
+        // depending which connections have been set, we update the preferred terrain of the tile accordingly
+        if (hasUp && isChecked(upperIndex)) {
+            preferredTerrain = (::terrain(mNewTerrain.at(upperIndex)) << 16) | (preferredTerrain & 0x0000FFFF);
+            mask |= 0xFFFF0000;
+        }
+        if (hasBottom && isChecked(bottomIndex)) {
+            preferredTerrain = (::terrain(mNewTerrain.at(bottomIndex)) >> 16) | (preferredTerrain & 0xFFFF0000);
+            mask |= 0x0000FFFF;
+        }
+        if (hasLeft && isChecked(leftIndex)) {
+            preferredTerrain = ((::terrain(mNewTerrain.at(leftIndex)) << 8) & 0xFF00FF00) | (preferredTerrain & 0x00FF00FF);
+            mask |= 0xFF00FF00;
+        }
+        if (hasRight && isChecked(rightIndex)) {
+            preferredTerrain = ((::terrain(mNewTerrain.at(rightIndex)) >> 8) & 0x00FF00FF) | (preferredTerrain & 0xFF00FF00);
+            mask |= 0x00FF00FF;
+        }
+    }
+
+    // find the most appropriate tile in the tileset
+    // if all quadrants are set to 'no terrain', then the 'empty' tile is the only choice we can deduce
+    Tile *paste = nullptr;
+    if (preferredTerrain != 0xFFFFFFFF) {
+        paste = findBestTile(*tileset, preferredTerrain, mask);
+        if (!paste)
+            return;
+    }
+
+    // add tile to the brush
+    mNewTerrain[i] = paste;
+    setChecked(i);
+
+    // expand the brush rect to fit the edit set
+    mBrushRect |= QRect(p, p);
+
+    // consider surrounding tiles if terrain constraints were not satisfied
+    if (hasUp && !isChecked(upperIndex)) {
+        const Tile *above = mLayer->cellAt(upPoint).tile();
+        if (topEdge(paste) != bottomEdge(above))
+            mQueue.append(upPoint);
+    }
+    if (hasBottom && !isChecked(bottomIndex)) {
+        const Tile *below = mLayer->cellAt(bottomPoint).tile();
+        if (bottomEdge(paste) != topEdge(below))
+            mQueue.append(bottomPoint);
+    }
+    if (hasLeft && !isChecked(leftIndex)) {
+        const Tile *left = mLayer->cellAt(leftPoint).tile();
+        if (leftEdge(paste) != rightEdge(left))
+            mQueue.append(leftPoint);
+    }
+    if (hasRight && !isChecked(rightIndex)) {
+        const Tile *right = mLayer->cellAt(rightPoint).tile();
+        if (rightEdge(paste) != leftEdge(right))
+            mQueue.append(rightPoint);
+    }
+}
+
+SharedTileLayer TerrainFiller::stamp() const
+{
+    Q_ASSERT(isFinished());
+
+    if (mBrushRect.isNull())
+        return SharedTileLayer();
+
+    SharedTileLayer stamp = SharedTileLayer(new TileLayer(QString(),
+                                                          mBrushRect.left() + mLayerPosition.x(),
+                                                          mBrushRect.top() + mLayerPosition.y(),
+                                                          mBrushRect.width(),
+                                                          mBrushRect.height()));
+
+    for (int index : mCheckedIndices) {
+        const int x = index % mLayerSize.width();
+        const int y = index / mLayerSize.width();
+        stamp->setCell(x - mBrushRect.left(),
+                       y - mBrushRect.top(),
+                       Cell(mNewTerrain.at(index)));
+    }
+
+    return stamp;
+}
+
+QRegion TerrainFiller::region() const
+{
+    Q_ASSERT(isFinished());
+
+    QRegion region;
+    const int layerWidth = mLayerSize.width();
+
+    for (int y = mBrushRect.top(); y <= mBrushRect.bottom(); ++y) {
+        const int rowStart = y * layerWidth;
+
+        for (int x = mBrushRect.left(); x <= mBrushRect.right(); ++x) {
+            if (!isChecked(rowStart + x))
+                continue;
+
+            // detect the affected region in ranges, which makes things faster
+            const int rangeStart = x;
+            while (x < mBrushRect.right() && isChecked(rowStart + x + 1))
+                ++x;
+
+            region += QRect(rangeStart + mLayerPosition.x(),
+                            y + mLayerPosition.y(),
+                            x - rangeStart + 1, 1);
+        }
+    }
+
+    return region;
+}
@@ -0,0 +1,150 @@
+/*
+ * terrainfiller.h
+ * Copyright 2012, Manu Evans <turkeyman@gmail.com>
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "tilelayer.h"
+
+#include <QBitArray>
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+
+class MapRenderer;
+class StaggeredRenderer;
+class Terrain;
+class Tile;
+class Tileset;
+
+namespace Internal {
+
+/**
+ * Works out which tiles need to change when painting terrain, including the
+ * transitions to the surrounding tiles.
+ *
+ * The tiles to consider are processed from a work queue, so the computation
+ * can be spread over several calls to proceed() with a time budget. The
+ * scratch buffers are sized to the layer and retained between fills, so that
+ * only the touched part of the layer needs to be reset for the next fill.
+ */
+class TerrainFiller
+{
+public:
+    /**
+     * A position to consider, in layer coordinates. For the start points,
+     * \a paintCorner is the corner to paint when painting vertices.
+     */
+    struct Point : public QPoint
+    {
+        Point()
+            : paintCorner(0)
+        {}
+
+        Point(QPoint p, int paintCorner = 0)
+            : QPoint(p)
+            , paintCorner(paintCorner)
+        {}
+
+        int paintCorner;
+    };
+
+    TerrainFiller();
+
+    /**
+     * Starts a new fill on \a layer, painting \a terrain (or erasing terrain
+     * when it is null) at the given \a startPoints. When \a paintCorners is
+     * true, only the corner of each start point is painted instead of the
+     * whole tile.
+     *
+     * The \a renderer is used to determine the neighbours of each tile.
+     *
+     * Any fill that was still in progress is abandoned.
+     */
+    void begin(const TileLayer *layer,
+               const MapRenderer *renderer,
+               const Terrain *terrain,
+               bool paintCorners,
+               const QVector<Point> &startPoints);
+
+    /**
+     * Processes queued positions until the fill is finished, or until
+     * \a timeBudget milliseconds have passed. A budget of 0 means there is no
+     * time limit.
+     *
+     * Returns whether the fill is finished. A finished fill releases the
+     * reference to the layer, but keeps its result.
+     */
+    bool proceed(int timeBudget = 0);
+
+    /**
+     * Abandons the current fill and releases the reference to the layer.
+     */
+    void clear();
+
+    bool isFinished() const { return mHead == mQueue.size(); }
+
+    const TileLayer *layer() const { return mLayer; }
+    const MapRenderer *renderer() const { return mRenderer; }
+    QSize layerSize() const { return mLayerSize; }
+
+    /**
+     * Returns the tiles changed by a finished fill, as a stamp positioned in
+     * map coordinates.
+     */
+    SharedTileLayer stamp() const;
+
+    /**
+     * Returns the region changed by a finished fill, in map coordinates.
+     */
+    QRegion region() const;
+
+private:
+    void consider(const Point &p, bool isStartPoint);
+    void setChecked(int index);
+
+    bool isChecked(int index) const { return mChecked.testBit(index); }
+
+    const TileLayer *mLayer;
+    const MapRenderer *mRenderer;
+    const StaggeredRenderer *mStaggeredRenderer;
+    QSize mLayerSize;
+    QPoint mLayerPosition;
+
+    Tileset *mTerrainTileset;
+    int mTerrainId;
+    bool mPaintCorners;
+
+    QVector<Point> mQueue;
+    int mHead;
+    int mStartPointCount;
+    QRect mBrushRect;
+
+    // Scratch buffers retained between fills
+    QVector<Tile*> mNewTerrain;
+    QBitArray mChecked;
+    QVector<int> mCheckedIndices;
+};
+
+} // namespace Internal
+} // namespace Tiled
@@ -13,7 +13,7 @@ win32|!isEmpty(TILED_LINUX_ARCHIVE) {
     DESTDIR = ../../bin
 }
 
-QT += widgets
+QT += widgets concurrent
 
 contains(QT_CONFIG, opengl):!macx:!minQtVersion(5, 4, 0) {
     QT += opengl
@@ -90,6 +90,8 @@ SOURCES += aboutdialog.cpp \
     automappingmanager.cpp \
     automappingutils.cpp  \
     autoupdater.cpp \
+    batchautomapper.cpp \
+    batchexporter.cpp \
     brokenlinks.cpp \
     brushitem.cpp \
     bucketfilltool.cpp \
@@ -135,6 +137,7 @@ SOURCES += aboutdialog.cpp \
     eraser.cpp \
     erasetiles.cpp \
     exportasimagedialog.cpp \
+    exportmanifest.cpp \
     eyevisibilitydelegate.cpp \
     filechangedwarning.cpp \
     fileedit.cpp \
@@ -157,6 +160,7 @@ SOURCES += aboutdialog.cpp \
     mapdocumentactionhandler.cpp \
     mapdocument.cpp \
     mapeditor.cpp \
+    maploader.cpp \
     mapobjectitem.cpp \
     mapobjectmodel.cpp \
     mapscene.cpp \
@@ -208,6 +212,7 @@ SOURCES += aboutdialog.cpp \
     swaptiles.cpp \
     terrainbrush.cpp \
     terraindock.cpp \
+    terrainfiller.cpp \
     terrainmodel.cpp \
     terrainview.cpp \
     texteditordialog.cpp \
@@ -237,6 +242,7 @@ SOURCES += aboutdialog.cpp \
     toolmanager.cpp \
     treeviewcombobox.cpp \
     undodock.cpp \
+    undomemorylimiter.cpp \
     utils.cpp \
     varianteditorfactory.cpp \
     variantpropertymanager.cpp \
@@ -259,6 +265,8 @@ HEADERS += aboutdialog.h \
     automappingmanager.h \
     automappingutils.h \
     autoupdater.h \
+    batchautomapper.h \
+    batchexporter.h \
     brokenlinks.h \
     brushitem.h \
     bucketfilltool.h \
@@ -305,6 +313,7 @@ HEADERS += aboutdialog.h \
     eraser.h \
     erasetiles.h \
     exportasimagedialog.h \
+    exportmanifest.h \
     eyevisibilitydelegate.h \
     filechangedwarning.h \
     fileedit.h \
@@ -327,6 +336,7 @@ HEADERS += aboutdialog.h \
     mapdocumentactionhandler.h \
     mapdocument.h \
     mapeditor.h \
+    maploader.h \
     mapobjectitem.h \
     mapobjectmodel.h \
     mapscene.h \
@@ -381,6 +391,7 @@ HEADERS += aboutdialog.h \
     swaptiles.h \
     terrainbrush.h \
     terraindock.h \
+    terrainfiller.h \
     terrainmodel.h \
     terrainview.h \
     texteditordialog.h \
@@ -411,6 +422,7 @@ HEADERS += aboutdialog.h \
     treeviewcombobox.h \
     undocommands.h \
     undodock.h \
+    undomemorylimiter.h \
     utils.h \
     varianteditorfactory.h \
     variantpropertymanager.h \
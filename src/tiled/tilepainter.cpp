@@ -24,6 +24,7 @@
 #include "mapdocument.h"
 #include "map.h"
 
+#include <QBitArray>
 #include <QQueue>
 
 using namespace Tiled;
@@ -112,6 +113,30 @@ void TilePainter::setCells(int x, int y,
     emit mMapDocument->regionChanged(region, mTileLayer);
 }
 
+void TilePainter::setCells(const TileMask &region,
+                           const std::function<const Cell &(int x, int y)> &cellAt)
+{
+    TileMask paintable = region;
+    paintable &= paintableRegion(region.boundingRect());
+
+    if (paintable.isEmpty())
+        return;
+
+    DrawMarginsWatcher watcher(mMapDocument, mTileLayer);
+
+    for (int y = paintable.top(); y <= paintable.bottom(); ++y) {
+        for (const TileMask::Span &span : paintable.row(y)) {
+            for (int x = span.left; x <= span.right; ++x) {
+                mTileLayer->setCell(x - mTileLayer->x(),
+                                    y - mTileLayer->y(),
+                                    cellAt(x, y));
+            }
+        }
+    }
+
+    emit mMapDocument->regionChanged(paintable.toRegion(), mTileLayer);
+}
+
 void TilePainter::drawCells(int x, int y, TileLayer *tileLayer)
 {
     const QRegion region = paintableRegion(x, y,
@@ -185,17 +210,41 @@ void TilePainter::erase(const QRegion &region)
     emit mMapDocument->regionChanged(paintable, mTileLayer);
 }
 
-static QRegion fillRegion(const TileLayer *layer, QPoint fillOrigin,
+/**
+ * Converts the set bits in \a bitmap, which stores \a width bits per row, to
+ * a mask. Only the given \a bounds are scanned.
+ */
+static TileMask bitmapToMask(const QBitArray &bitmap, int width,
+                             const QRect &bounds)
+{
+    TileMask mask;
+
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        const int startOfLine = y * width;
+
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            if (!bitmap.testBit(startOfLine + x))
+                continue;
+
+            const int left = x;
+            while (x < bounds.right() && bitmap.testBit(startOfLine + x + 1))
+                ++x;
+
+            mask.addSpan(y, left, x);
+        }
+    }
+
+    return mask;
+}
+
+static TileMask fillRegion(const TileLayer *layer, QPoint fillOrigin,
                           Map::Orientation orientation,
                           Map::StaggerAxis staggerAxis,
                           Map::StaggerIndex staggerIndex)
 {
-    // Create that region that will hold the fill
-    QRegion fillRegion;
-
     // Silently quit if parameters are unsatisfactory
     if (!layer->contains(fillOrigin))
-        return fillRegion;
+        return TileMask();
 
     // Cache cell that we will match other cells against
     const Cell matchCell = layer->cellAt(fillOrigin);
@@ -214,6 +263,12 @@ static QRegion fillRegion(const TileLayer *layer, QPoint fillOrigin,
     QVector<bool> processedCellsVec(layerWidth * layerHeight);
     bool *processedCells = processedCellsVec.data();
 
+    // Create a bitmap that will hold the fill. It is converted to a mask at
+    // the end, since uniting regions one line at a time gets very slow for
+    // large fills.
+    QBitArray filledCells(layerWidth * layerHeight);
+    QRect fillBounds;
+
     // Loop through queued positions and fill them, while at the same time
     // checking adjacent positions to see if they should be added
     while (!fillPositions.isEmpty()) {
@@ -234,8 +289,9 @@ static QRegion fillRegion(const TileLayer *layer, QPoint fillOrigin,
             processedCells[startOfLine + right] = true;
         }
 
-        // Add cells between left and right to the region
-        fillRegion += QRegion(left, currentPoint.y(), right - left + 1, 1);
+        // Mark cells between left and right as filled
+        filledCells.fill(true, startOfLine + left, startOfLine + right + 1);
+        fillBounds |= QRect(left, currentPoint.y(), right - left + 1, 1);
 
         bool leftColumnIsStaggered = false;
         bool rightColumnIsStaggered = false;
@@ -305,26 +361,27 @@ static QRegion fillRegion(const TileLayer *layer, QPoint fillOrigin,
         }
     }
 
-    return fillRegion;
+    return bitmapToMask(filledCells, layerWidth, fillBounds);
 }
 
 QRegion TilePainter::computePaintableFillRegion(const QPoint &fillOrigin) const
 {
-    QRegion region = computeFillRegion(fillOrigin);
+    TileMask mask = computeFillRegion(fillOrigin);
 
     const QRegion &selection = mMapDocument->selectedArea();
     if (!selection.isEmpty())
-        region &= selection;
+        mask &= TileMask(selection);
 
-    return region;
+    return mask.toRegion();
 }
 
-QRegion TilePainter::computeFillRegion(const QPoint &fillOrigin) const
+TileMask TilePainter::computeFillRegion(const QPoint &fillOrigin) const
 {
     Map *map = mMapDocument->map();
-    QRegion region = fillRegion(mTileLayer, fillOrigin - mTileLayer->position(),
-                                map->orientation(), map->staggerAxis(), map->staggerIndex());
-    return region.translated(mTileLayer->position());
+    TileMask mask = fillRegion(mTileLayer, fillOrigin - mTileLayer->position(),
+                               map->orientation(), map->staggerAxis(), map->staggerIndex());
+    mask.translate(mTileLayer->position());
+    return mask;
 }
 
 bool TilePainter::isDrawable(int x, int y) const
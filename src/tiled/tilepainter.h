@@ -72,6 +72,13 @@ public:
      */
     void setCells(int x, int y, TileLayer *tileLayer, const QRegion &mask);
 
+    /**
+     * Sets the cells within the given \a region to the cells returned by
+     * \a cellAt, which is called with coordinates relative to the map origin.
+     */
+    void setCells(const TileMask &region,
+                  const std::function<const Cell &(int x, int y)> &cellAt);
+
     /**
      * Draws the cells in the given tile layer at the given coordinates. The
      * coordinates \a x and \a y are relative to the map origin.
@@ -102,7 +109,7 @@ public:
      * at \a fillOrigin that are connected. Does not take into account the
      * current selection.
      */
-    QRegion computeFillRegion(const QPoint &fillOrigin) const;
+    TileMask computeFillRegion(const QPoint &fillOrigin) const;
 
     /**
      * Returns true if the given cell is drawable.
@@ -25,6 +25,7 @@
 #include "addremovetiles.h"
 #include "changetileterrain.h"
 #include "erasetiles.h"
+#include "imagecache.h"
 #include "maintoolbar.h"
 #include "mapdocument.h"
 #include "mapobject.h"
@@ -603,7 +604,7 @@ void TilesetEditor::addTiles(const QStringList &files)
             if (!rememberOption)
                 continue;
         }
-        const QPixmap image(file);
+        const QPixmap image = ImageCache::loadPixmap(file);
         if (!image.isNull()) {
             loadedFiles.append(LoadedFile { file, image });
         } else {
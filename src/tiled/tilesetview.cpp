@@ -26,6 +26,7 @@
 #include "stylehelper.h"
 #include "terrain.h"
 #include "tile.h"
+#include "tileimageloader.h"
 #include "tileset.h"
 #include "tilesetdocument.h"
 #include "tilesetmodel.h"
@@ -368,10 +369,10 @@ QSize TileDelegate::sizeHint(const QStyleOptionViewItem & /* option */,
     const int extra = mTilesetView->drawGrid() ? 1 : 0;
 
     if (const Tile *tile = m->tileAt(index)) {
-        const QPixmap &image = tile->image();
-        QSize tileSize = image.size();
+        // Avoid loading deferred images just to lay out the view
+        QSize tileSize = tile->size();
 
-        if (image.isNull()) {
+        if (tileSize.isEmpty()) {
             Tileset *tileset = m->tileset();
             if (tileset->isCollection()) {
                 tileSize = QSize(32, 32);
@@ -436,6 +437,11 @@ TilesetView::TilesetView(QWidget *parent)
             this, &TilesetView::updateBackgroundColor);
 
     connect(mZoomable, SIGNAL(scaleChanged(qreal)), SLOT(adjustScale()));
+
+    connect(verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &TilesetView::prefetchTileImages);
+    connect(verticalScrollBar(), &QScrollBar::rangeChanged,
+            this, &TilesetView::prefetchTileImages);
 }
 
 void TilesetView::setTilesetDocument(TilesetDocument *tilesetDocument)
@@ -483,6 +489,40 @@ void TilesetView::setModel(QAbstractItemModel *model)
 {
     QTableView::setModel(model);
     updateBackgroundColor();
+    prefetchTileImages();
+}
+
+/**
+ * Starts loading the images of the tiles around the visible area in the
+ * background, so that they are ready when they are scrolled into view. Only
+ * relevant for image collection tilesets, since their tile images are only
+ * loaded once they are used.
+ */
+void TilesetView::prefetchTileImages()
+{
+    const TilesetModel *model = tilesetModel();
+    if (!model || !model->tileset()->isCollection())
+        return;
+
+    // Include a page above and below the visible area
+    const int pageHeight = viewport()->height();
+    int firstRow = rowAt(-pageHeight);
+    int lastRow = rowAt(pageHeight * 2);
+    if (firstRow == -1)
+        firstRow = 0;
+    if (lastRow == -1)
+        lastRow = model->rowCount() - 1;
+
+    QList<Tile*> tiles;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = 0; column < model->columnCount(); ++column) {
+            if (Tile *tile = model->tileAt(model->index(row, column)))
+                if (tile->hasDeferredImage())
+                    tiles.append(tile);
+        }
+    }
+
+    TileImageLoader::prefetch(tiles);
 }
 
 void TilesetView::setMarkAnimatedTiles(bool enabled)
@@ -137,6 +137,7 @@ private slots:
     void setDrawGrid(bool drawGrid);
 
     void adjustScale();
+    void prefetchTileImages();
 
 private:
     void applyTerrain();
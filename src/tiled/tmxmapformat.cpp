@@ -56,6 +56,7 @@ bool TmxMapFormat::write(const Map *map, const QString &fileName)
 
     MapWriter writer;
     writer.setDtdEnabled(prefs->dtdEnabled());
+    writer.setEmbeddedImageFormat(prefs->embeddedImageFormat());
 
     bool result = writer.writeMap(map, fileName);
     if (!result)
@@ -137,6 +138,7 @@ bool TsxTilesetFormat::write(const Tileset &tileset, const QString &fileName)
 
     MapWriter writer;
     writer.setDtdEnabled(prefs->dtdEnabled());
+    writer.setEmbeddedImageFormat(prefs->embeddedImageFormat());
 
     bool result = writer.writeTileset(tileset, fileName);
     if (!result)
@@ -0,0 +1,311 @@
+/*
+ * undomemorylimiter.cpp
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "undomemorylimiter.h"
+
+#include "preferences.h"
+
+#include <QApplication>
+#include <QMessageBox>
+#include <QTemporaryFile>
+#include <QUndoStack>
+
+#include <iterator>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+static const qint64 MegaByte = 1024 * 1024;
+
+CompressibleCommand::CompressibleCommand(UndoMemoryLimiter *memoryLimiter)
+    : mMemoryLimiter(memoryLimiter)
+    , mCountedUsage(0)
+    , mUsageChanged(false)
+    , mState(InMemory)
+    , mSwapOffset(0)
+    , mSwapSize(0)
+{
+    mMemoryLimiter->addCommand(this);
+}
+
+CompressibleCommand::~CompressibleCommand()
+{
+    mMemoryLimiter->removeCommand(this);
+
+    if (mState == Swapped)
+        mMemoryLimiter->releaseSwap();
+}
+
+qint64 CompressibleCommand::memoryUsage() const
+{
+    switch (mState) {
+    case InMemory:
+        return dataSize();
+    case Compressed:
+        return mCompressedData.size();
+    case Swapped:
+    case Lost:
+        break;
+    }
+    return 0;
+}
+
+bool CompressibleCommand::ensureLoaded() const
+{
+    // Restoring the data doesn't change the logical state of the command
+    CompressibleCommand *self = const_cast<CompressibleCommand*>(this);
+    if (mState == Compressed || mState == Swapped)
+        self->load();
+
+    mMemoryLimiter->usageChanged(self);
+    return mState == InMemory;
+}
+
+void CompressibleCommand::compress()
+{
+    Q_ASSERT(mState == InMemory);
+
+    if (dataSize() == 0)
+        return;
+
+    mCompressedData = qCompress(saveData());
+    mState = Compressed;
+}
+
+void CompressibleCommand::load()
+{
+    bool ok = true;
+
+    if (mState == Swapped) {
+        ok = mMemoryLimiter->swapIn(mSwapOffset, mSwapSize, &mCompressedData);
+        mMemoryLimiter->releaseSwap();
+    }
+
+    const QByteArray data = ok ? qUncompress(mCompressedData) : QByteArray();
+    mCompressedData = QByteArray();
+
+    // Without its data the command can't be undone or redone anymore
+    if (data.isEmpty()) {
+        mState = Lost;
+        mMemoryLimiter->dataLost();
+        return;
+    }
+
+    loadData(data);
+    mState = InMemory;
+}
+
+
+UndoMemoryLimiter::UndoMemoryLimiter(QUndoStack *undoStack)
+    : QObject(undoStack)
+    , mMemoryUsage(0)
+    , mSwapFile(nullptr)
+    , mSwappedCount(0)
+    , mDataLost(false)
+{
+    Preferences *prefs = Preferences::instance();
+    mLimit = prefs->undoMemoryLimit() * MegaByte;
+
+    connect(undoStack, &QUndoStack::indexChanged,
+            this, &UndoMemoryLimiter::enforceLimit);
+    connect(prefs, &Preferences::undoMemoryLimitChanged,
+            this, &UndoMemoryLimiter::undoMemoryLimitChanged);
+}
+
+void UndoMemoryLimiter::setLimit(qint64 limit)
+{
+    mLimit = limit;
+    enforceLimit();
+}
+
+qint64 UndoMemoryLimiter::memoryUsage() const
+{
+    return mMemoryUsage;
+}
+
+void UndoMemoryLimiter::enforceLimit()
+{
+    // Only the commands that were used since the last time can have changed
+    for (CompressibleCommand *command : mChangedCommands) {
+        command->mUsageChanged = false;
+        updateUsage(command);
+    }
+    mChangedCommands.resize(0);
+
+    if (mLimit <= 0 || mMemoryUsage <= mLimit)
+        return;
+
+    // Compress the oldest commands first. The newest command is left alone,
+    // since it is likely to be merged with or undone.
+    const auto candidatesEnd = std::prev(mCommands.end());
+
+    for (auto it = mCommands.begin(); it != candidatesEnd && mMemoryUsage > mLimit; ++it) {
+        CompressibleCommand *command = *it;
+        if (command->mState != CompressibleCommand::InMemory)
+            continue;
+
+        command->compress();
+        updateUsage(command);
+    }
+
+    // If that wasn't enough, move the compressed data to the swap file
+    for (auto it = mCommands.begin(); it != candidatesEnd && mMemoryUsage > mLimit; ++it) {
+        CompressibleCommand *command = *it;
+        if (command->mState != CompressibleCommand::Compressed)
+            continue;
+
+        const QByteArray &data = command->mCompressedData;
+        if (!swapOut(data, &command->mSwapOffset))
+            break;
+
+        command->mSwapSize = data.size();
+        command->mCompressedData = QByteArray();
+        command->mState = CompressibleCommand::Swapped;
+        updateUsage(command);
+    }
+}
+
+void UndoMemoryLimiter::undoMemoryLimitChanged(int megabytes)
+{
+    setLimit(megabytes * MegaByte);
+}
+
+void UndoMemoryLimiter::addCommand(CompressibleCommand *command)
+{
+    command->mIterator = mCommands.insert(mCommands.end(), command);
+
+    // The data is only set up by the subclass, so count it later
+    usageChanged(command);
+}
+
+void UndoMemoryLimiter::removeCommand(CompressibleCommand *command)
+{
+    mCommands.erase(command->mIterator);
+    mMemoryUsage -= command->mCountedUsage;
+
+    if (command->mUsageChanged)
+        mChangedCommands.removeOne(command);
+}
+
+/**
+ * Marks the memory usage of \a command as possibly changed. It is updated
+ * the next time the limit is enforced.
+ */
+void UndoMemoryLimiter::usageChanged(CompressibleCommand *command)
+{
+    if (!command->mUsageChanged) {
+        command->mUsageChanged = true;
+        mChangedCommands.append(command);
+    }
+}
+
+void UndoMemoryLimiter::updateUsage(CompressibleCommand *command)
+{
+    const qint64 usage = command->memoryUsage();
+    mMemoryUsage += usage - command->mCountedUsage;
+    command->mCountedUsage = usage;
+}
+
+/**
+ * Appends \a data to the swap file, which is created when necessary. Returns
+ * whether the data was written, and its position in \a offset.
+ */
+bool UndoMemoryLimiter::swapOut(const QByteArray &data, qint64 *offset)
+{
+    if (!mSwapFile) {
+        mSwapFile = new QTemporaryFile(this);
+        if (!mSwapFile->open()) {
+            delete mSwapFile;
+            mSwapFile = nullptr;
+            return false;
+        }
+    }
+
+    *offset = mSwapFile->size();
+
+    if (!mSwapFile->seek(*offset) || mSwapFile->write(data) != data.size())
+        return false;
+
+    ++mSwappedCount;
+    return true;
+}
+
+/**
+ * Reads back \a size bytes of swapped data at \a offset into \a data.
+ * Returns whether all of the data could be read.
+ */
+bool UndoMemoryLimiter::swapIn(qint64 offset, int size, QByteArray *data)
+{
+    Q_ASSERT(mSwapFile);
+
+    if (!mSwapFile->seek(offset))
+        return false;
+
+    *data = mSwapFile->read(size);
+    return data->size() == size;
+}
+
+/**
+ * Called when swapped data is no longer needed. Space in the swap file is
+ * reclaimed once none of the commands refer to it anymore.
+ */
+void UndoMemoryLimiter::releaseSwap()
+{
+    if (--mSwappedCount == 0)
+        mSwapFile->resize(0);
+}
+
+/**
+ * Called when a command failed to restore its data. The undo history no
+ * longer matches the document, so it is discarded once the command that
+ * failed has returned.
+ */
+void UndoMemoryLimiter::dataLost()
+{
+    if (mDataLost)
+        return;
+
+    mDataLost = true;
+    QMetaObject::invokeMethod(this, "discardUndoHistory", Qt::QueuedConnection);
+}
+
+void UndoMemoryLimiter::discardUndoHistory()
+{
+    QUndoStack *undoStack = static_cast<QUndoStack*>(parent());
+    const bool modified = !undoStack->isClean();
+
+    undoStack->clear();
+    mDataLost = false;
+
+    // Clearing the stack marks the document as unmodified, which it isn't
+#if QT_VERSION >= 0x050800
+    if (modified)
+        undoStack->resetClean();
+#else
+    Q_UNUSED(modified)
+#endif
+
+    QMessageBox::warning(QApplication::activeWindow(),
+                         tr("Undo History Lost"),
+                         tr("Part of the undo history could not be read back "
+                            "from the temporary file, so the undo history has "
+                            "been cleared. Your changes to the document are "
+                            "kept."));
+}
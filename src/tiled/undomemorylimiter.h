@@ -0,0 +1,167 @@
+/*
+ * undomemorylimiter.h
+ * Copyright 2017, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QVector>
+
+#include <list>
+
+class QTemporaryFile;
+class QUndoStack;
+
+namespace Tiled {
+namespace Internal {
+
+class UndoMemoryLimiter;
+
+/**
+ * An undo command that reports the memory it holds on to, and that allows
+ * this memory to be reclaimed by the UndoMemoryLimiter.
+ *
+ * Subclasses serialize their data in saveData(), after which the data is
+ * compressed and possibly written to a temporary file. Before using their
+ * data, subclasses call ensureLoaded(), which passes it back to loadData()
+ * when needed.
+ */
+class CompressibleCommand
+{
+public:
+    explicit CompressibleCommand(UndoMemoryLimiter *memoryLimiter);
+    virtual ~CompressibleCommand();
+
+    /**
+     * Returns the approximate amount of memory held by this command, in
+     * bytes.
+     */
+    qint64 memoryUsage() const;
+
+protected:
+    /**
+     * Returns the size of the data that can be released by saveData(), in
+     * bytes. Returns 0 when there is nothing to release.
+     */
+    virtual qint64 dataSize() const = 0;
+
+    /**
+     * Returns the data of this command, releasing the memory it used.
+     */
+    virtual QByteArray saveData() = 0;
+
+    /**
+     * Restores the data that was previously returned by saveData().
+     */
+    virtual void loadData(const QByteArray &data) = 0;
+
+    /**
+     * Makes sure the data of this command is available again. Should be
+     * called before the data is accessed or changed, since it also lets the
+     * UndoMemoryLimiter know that the memory usage may have changed.
+     *
+     * Returns false when the data could not be restored, in which case the
+     * command should leave the document alone. The undo history is then
+     * discarded by the UndoMemoryLimiter.
+     */
+    bool ensureLoaded() const;
+
+private:
+    friend class UndoMemoryLimiter;
+
+    enum State {
+        InMemory,
+        Compressed,
+        Swapped,
+        Lost
+    };
+
+    void compress();
+    void load();
+
+    UndoMemoryLimiter *mMemoryLimiter;
+    std::list<CompressibleCommand*>::iterator mIterator;
+    qint64 mCountedUsage;
+    bool mUsageChanged;
+    State mState;
+    QByteArray mCompressedData;
+    qint64 mSwapOffset;
+    int mSwapSize;
+};
+
+/**
+ * Keeps the memory used by the commands on an undo stack within a limit. When
+ * the limit is exceeded, the data of the oldest commands is compressed. When
+ * this is not enough, the compressed data is moved to a temporary file.
+ *
+ * The limit is taken from the preferences.
+ *
+ * Commands register themselves on construction and unregister on
+ * destruction. The limiter is a child of the undo stack, so it outlives the
+ * commands on the stack.
+ */
+class UndoMemoryLimiter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UndoMemoryLimiter(QUndoStack *undoStack);
+
+    /**
+     * Sets the memory limit in bytes. A limit of 0 disables the limit.
+     */
+    void setLimit(qint64 limit);
+    qint64 limit() const { return mLimit; }
+
+    /**
+     * Returns the approximate amount of memory used by the registered
+     * commands, in bytes, as of the last time the limit was enforced.
+     */
+    qint64 memoryUsage() const;
+
+private slots:
+    void enforceLimit();
+    void discardUndoHistory();
+    void undoMemoryLimitChanged(int megabytes);
+
+private:
+    friend class CompressibleCommand;
+
+    void addCommand(CompressibleCommand *command);
+    void removeCommand(CompressibleCommand *command);
+    void usageChanged(CompressibleCommand *command);
+    void updateUsage(CompressibleCommand *command);
+
+    bool swapOut(const QByteArray &data, qint64 *offset);
+    bool swapIn(qint64 offset, int size, QByteArray *data);
+    void releaseSwap();
+    void dataLost();
+
+    std::list<CompressibleCommand*> mCommands;
+    QVector<CompressibleCommand*> mChangedCommands;
+    qint64 mMemoryUsage;
+    qint64 mLimit;
+    QTemporaryFile *mSwapFile;
+    int mSwappedCount;
+    bool mDataLost;
+};
+
+} // namespace Internal
+} // namespace Tiled
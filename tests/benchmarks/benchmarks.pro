@@ -0,0 +1,36 @@
+include(../../src/libtiled/libtiled.pri)
+
+QT += testlib
+CONFIG += c++11
+TEMPLATE = app
+
+macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/Frameworks
+} else {
+    LIBS += -L$$OUT_PWD/../../lib
+}
+
+!win32:!macx:!cygwin {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../../lib
+
+    # It is not possible to use ORIGIN in QMAKE_RPATHDIR, so a bit manually
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$$join(QMAKE_RPATHDIR, ":")\'
+    QMAKE_RPATHDIR =
+}
+
+# The JSON and Lua exporters are built in as static plugins
+DEFINES += QT_STATICPLUGIN JSON_LIBRARY LUA_LIBRARY
+
+# Input
+INCLUDEPATH += ../../src/plugins/json \
+    ../../src/plugins/lua
+
+SOURCES += test_benchmarks.cpp \
+    ../../src/plugins/json/jsonplugin.cpp \
+    ../../src/plugins/json/jsonstreamreader.cpp \
+    ../../src/plugins/json/jsonstreamwriter.cpp \
+    ../../src/plugins/json/qjsonparser/json.cpp \
+    ../../src/plugins/lua/luaplugin.cpp \
+    ../../src/plugins/lua/luatablewriter.cpp
+HEADERS += ../../src/plugins/json/jsonplugin.h \
+    ../../src/plugins/lua/luaplugin.h
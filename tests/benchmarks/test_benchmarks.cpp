@@ -0,0 +1,655 @@
+#include "gidmapper.h"
+#include "jsonplugin.h"
+#include "luaplugin.h"
+#include "map.h"
+#include "mapobject.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+/**
+ * The parameters of the generated map, which can be changed on the command
+ * line to benchmark with larger or smaller maps.
+ */
+struct MapParameters
+{
+    int size = 256;
+    int layers = 4;
+    int tilesets = 4;
+    int objects = 1000;
+
+    QJsonObject toJson() const
+    {
+        QJsonObject object;
+        object.insert(QLatin1String("size"), size);
+        object.insert(QLatin1String("layers"), layers);
+        object.insert(QLatin1String("tilesets"), tilesets);
+        object.insert(QLatin1String("objects"), objects);
+        return object;
+    }
+};
+
+/**
+ * Collects the time spent per iteration of each QBENCHMARK loop, so that the
+ * results can be saved and compared to those of another build.
+ */
+class BenchmarkResults
+{
+public:
+    struct Result
+    {
+        qint64 nsecs = 0;
+        int iterations = 0;
+
+        double msecsPerIteration() const
+        { return iterations ? nsecs / 1e6 / iterations : 0.0; }
+    };
+
+    void add(qint64 nsecs)
+    {
+        QString name = QString::fromLatin1(QTest::currentTestFunction());
+        if (const char *dataTag = QTest::currentDataTag())
+            name += QLatin1Char('/') + QString::fromLatin1(dataTag);
+
+        Result &result = mResults[name];
+        result.nsecs += nsecs;
+        ++result.iterations;
+    }
+
+    bool save(const QString &fileName, const MapParameters &parameters) const;
+    bool compare(const QString &fileName, const MapParameters &parameters) const;
+
+private:
+    QMap<QString, Result> mResults;
+};
+
+bool BenchmarkResults::save(const QString &fileName,
+                            const MapParameters &parameters) const
+{
+    QJsonObject results;
+    for (auto it = mResults.begin(); it != mResults.end(); ++it) {
+        QJsonObject result;
+        result.insert(QLatin1String("msecsPerIteration"), it->msecsPerIteration());
+        result.insert(QLatin1String("iterations"), it->iterations);
+        results.insert(it.key(), result);
+    }
+
+    QJsonObject root;
+    root.insert(QLatin1String("parameters"), parameters.toJson());
+    root.insert(QLatin1String("results"), results);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning().noquote() << "Could not write" << fileName;
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+    return true;
+}
+
+/**
+ * Prints the change of each result compared to the results stored in the
+ * given baseline file.
+ */
+bool BenchmarkResults::compare(const QString &fileName,
+                               const MapParameters &parameters) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning().noquote() << "Could not read" << fileName;
+        return false;
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value(QLatin1String("parameters")).toObject() != parameters.toJson())
+        qWarning().noquote() << "The baseline was measured with a different map";
+
+    const QJsonObject baseline = root.value(QLatin1String("results")).toObject();
+
+    for (auto it = mResults.begin(); it != mResults.end(); ++it) {
+        const QJsonValue value = baseline.value(it.key());
+        if (value.isUndefined())
+            continue;
+
+        const double before = value.toObject().value(QLatin1String("msecsPerIteration")).toDouble();
+        const double after = it->msecsPerIteration();
+        const double change = before > 0 ? (after - before) / before * 100 : 0;
+
+        qWarning().noquote() << QString(QLatin1String("%1: %2 ms -> %3 ms (%4%5%)"))
+                                .arg(it.key())
+                                .arg(before, 0, 'f', 3)
+                                .arg(after, 0, 'f', 3)
+                                .arg(QString::fromLatin1(change >= 0 ? "+" : ""))
+                                .arg(change, 0, 'f', 1);
+    }
+
+    return true;
+}
+
+/**
+ * Adds the time until it goes out of scope to the benchmark results.
+ */
+class ScopedMeasurement
+{
+public:
+    explicit ScopedMeasurement(BenchmarkResults &results)
+        : mResults(results)
+    {
+        mTimer.start();
+    }
+
+    ~ScopedMeasurement()
+    {
+        mResults.add(mTimer.nsecsElapsed());
+    }
+
+private:
+    BenchmarkResults &mResults;
+    QElapsedTimer mTimer;
+};
+
+class test_Benchmarks : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit test_Benchmarks(const MapParameters &parameters)
+        : mParameters(parameters)
+    {}
+
+    const BenchmarkResults &results() const { return mResults; }
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void writeMap_data();
+    void writeMap();
+    void readMap_data();
+    void readMap();
+
+    void writeJson_data();
+    void writeJson();
+    void readJson_data();
+    void readJson();
+    void writeLua_data();
+    void writeLua();
+
+    void encodeLayerData_data();
+    void encodeLayerData();
+    void decodeLayerData_data();
+    void decodeLayerData();
+
+    void tileLayer_data();
+    void tileLayer();
+
+private:
+    Map *createMap() const;
+    QString filePath(const QString &fileName) const;
+    const TileLayer *firstTileLayer() const;
+
+    MapParameters mParameters;
+    BenchmarkResults mResults;
+    QTemporaryDir mDir;
+    QScopedPointer<Map> mMap;
+};
+
+static void addLayerDataFormatRows()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("xml") << int(Map::XML);
+    QTest::newRow("base64") << int(Map::Base64);
+    QTest::newRow("base64-gzip") << int(Map::Base64Gzip);
+    QTest::newRow("base64-zlib") << int(Map::Base64Zlib);
+    QTest::newRow("csv") << int(Map::CSV);
+}
+
+/**
+ * The JSON and Lua formats write the layer data as an array for both the XML
+ * and the CSV layer data format, so only the latter is included.
+ */
+static void addPluginLayerDataFormatRows()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("csv") << int(Map::CSV);
+    QTest::newRow("base64") << int(Map::Base64);
+    QTest::newRow("base64-gzip") << int(Map::Base64Gzip);
+    QTest::newRow("base64-zlib") << int(Map::Base64Zlib);
+}
+
+static void addBinaryLayerDataFormatRows()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("base64") << int(Map::Base64);
+    QTest::newRow("base64-gzip") << int(Map::Base64Gzip);
+    QTest::newRow("base64-zlib") << int(Map::Base64Zlib);
+}
+
+/**
+ * Creates a map with the configured size and amount of layers, tilesets and
+ * objects. The contents are pseudo-random, but the same on every run.
+ */
+Map *test_Benchmarks::createMap() const
+{
+    QImage image(256, 256, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgb(x, y, (x * y) & 0xff));
+
+    const QString imageFileName = filePath(QLatin1String("tiles.png"));
+    image.save(imageFileName);
+
+    Map *map = new Map(Map::Orthogonal, mParameters.size, mParameters.size, 32, 32);
+
+    for (int i = 0; i < mParameters.tilesets; ++i) {
+        SharedTileset tileset = Tileset::create(QString(QLatin1String("Tiles %1")).arg(i), 32, 32);
+        tileset->loadFromImage(image, imageFileName);
+        tileset->findTile(0)->setProperty(QLatin1String("name"), QLatin1String("first"));
+        map->addTileset(tileset);
+    }
+
+    quint32 seed = 1;
+    auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+
+    for (int i = 0; i < mParameters.layers && mParameters.tilesets > 0; ++i) {
+        TileLayer *tileLayer = new TileLayer(QString(QLatin1String("Layer %1")).arg(i),
+                                             0, 0, mParameters.size, mParameters.size);
+
+        for (int y = 0; y < mParameters.size; ++y) {
+            for (int x = 0; x < mParameters.size; ++x) {
+                const quint32 value = random();
+                if (value % 8 == 0)
+                    continue;
+
+                Tileset *tileset = map->tilesetAt((value >> 3) % mParameters.tilesets).data();
+                Cell cell(tileset->findTile((value >> 6) % tileset->tileCount()));
+                cell.setFlippedHorizontally(value & (1 << 20));
+                tileLayer->setCell(x, y, cell);
+            }
+        }
+
+        map->addLayer(tileLayer);
+    }
+
+    if (mParameters.objects > 0) {
+        ObjectGroup *objectGroup = new ObjectGroup(QLatin1String("Objects"), 0, 0);
+        const int mapSize = mParameters.size * 32;
+
+        for (int i = 0; i < mParameters.objects; ++i) {
+            const QPointF pos(random() % mapSize, random() % mapSize);
+            MapObject *object = new MapObject(QString::number(i), QLatin1String("type"),
+                                              pos, QSizeF(32, 16));
+            object->setId(map->takeNextObjectId());
+            object->setProperty(QLatin1String("index"), i);
+
+            if (i % 3 == 0) {
+                object->setShape(MapObject::Polygon);
+                object->setPolygon(QPolygonF() << QPointF(0, 0) << QPointF(32, 0)
+                                               << QPointF(32, 32) << QPointF(0, 16));
+            }
+
+            objectGroup->addObject(object);
+        }
+
+        map->addLayer(objectGroup);
+    }
+
+    return map;
+}
+
+QString test_Benchmarks::filePath(const QString &fileName) const
+{
+    return QDir(mDir.path()).filePath(fileName);
+}
+
+const TileLayer *test_Benchmarks::firstTileLayer() const
+{
+    for (Layer *layer : mMap->layers())
+        if (TileLayer *tileLayer = layer->asTileLayer())
+            return tileLayer;
+    return nullptr;
+}
+
+void test_Benchmarks::initTestCase()
+{
+    QVERIFY(mDir.isValid());
+    mMap.reset(createMap());
+}
+
+void test_Benchmarks::cleanupTestCase()
+{
+    mMap.reset();
+}
+
+void test_Benchmarks::writeMap_data()
+{
+    addLayerDataFormatRows();
+}
+
+void test_Benchmarks::writeMap()
+{
+    QFETCH(int, format);
+    mMap->setLayerDataFormat(static_cast<Map::LayerDataFormat>(format));
+
+    MapWriter writer;
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    QBENCHMARK {
+        ScopedMeasurement measurement(mResults);
+        buffer.seek(0);
+        writer.writeMap(mMap.data(), &buffer, mDir.path());
+    }
+
+    QVERIFY(buffer.pos() > 0);
+}
+
+void test_Benchmarks::readMap_data()
+{
+    addLayerDataFormatRows();
+}
+
+void test_Benchmarks::readMap()
+{
+    QFETCH(int, format);
+    mMap->setLayerDataFormat(static_cast<Map::LayerDataFormat>(format));
+
+    const QString fileName = filePath(QLatin1String("map.tmx"));
+    MapWriter writer;
+    QVERIFY2(writer.writeMap(mMap.data(), fileName), qPrintable(writer.errorString()));
+
+    QBENCHMARK {
+        ScopedMeasurement measurement(mResults);
+        MapReader reader;
+        QScopedPointer<Map> map(reader.readMap(fileName));
+        QVERIFY2(map, qPrintable(reader.errorString()));
+    }
+}
+
+void test_Benchmarks::writeJson_data()
+{
+    addPluginLayerDataFormatRows();
+}
+
+void test_Benchmarks::writeJson()
+{
+    QFETCH(int, format);
+    mMap->setLayerDataFormat(static_cast<Map::LayerDataFormat>(format));
+
+    Json::JsonMapFormat jsonFormat(Json::JsonMapFormat::Json);
+    const QString fileName = filePath(QLatin1String("map.json"));
+
+    QBENCHMARK {
+        ScopedMeasurement measurement(mResults);
+        QVERIFY2(jsonFormat.write(mMap.data(), fileName), qPrintable(jsonFormat.errorString()));
+    }
+}
+
+void test_Benchmarks::readJson_data()
+{
+    addPluginLayerDataFormatRows();
+}
+
+void test_Benchmarks::readJson()
+{
+    QFETCH(int, format);
+    mMap->setLayerDataFormat(static_cast<Map::LayerDataFormat>(format));
+
+    Json::JsonMapFormat jsonFormat(Json::JsonMapFormat::Json);
+    const QString fileName = filePath(QLatin1String("map.json"));
+    QVERIFY2(jsonFormat.write(mMap.data(), fileName), qPrintable(jsonFormat.errorString()));
+
+    QBENCHMARK {
+        ScopedMeasurement measurement(mResults);
+        QScopedPointer<Map> map(jsonFormat.read(fileName));
+        QVERIFY2(map, qPrintable(jsonFormat.errorString()));
+    }
+}
+
+void test_Benchmarks::writeLua_data()
+{
+    addPluginLayerDataFormatRows();
+}
+
+void test_Benchmarks::writeLua()
+{
+    QFETCH(int, format);
+    mMap->setLayerDataFormat(static_cast<Map::LayerDataFormat>(format));
+
+    Lua::LuaPlugin plugin;
+    const QString fileName = filePath(QLatin1String("map.lua"));
+
+    QBENCHMARK {
+        ScopedMeasurement measurement(mResults);
+        QVERIFY2(plugin.write(mMap.data(), fileName), qPrintable(plugin.errorString()));
+    }
+}
+
+void test_Benchmarks::encodeLayerData_data()
+{
+    addBinaryLayerDataFormatRows();
+}
+
+void test_Benchmarks::encodeLayerData()
+{
+    QFETCH(int, format);
+
+    const TileLayer *tileLayer = firstTileLayer();
+    if (!tileLayer)
+        QSKIP("The map has no tile layers");
+
+    const GidMapper gidMapper(mMap->tilesets());
+    QByteArray data;
+
+    QBENCHMARK {
+        ScopedMeasurement measurement(mResults);
+        data = gidMapper.encodeLayerData(*tileLayer,
+                                         static_cast<Map::LayerDataFormat>(format));
+    }
+
+    QVERIFY(!data.isEmpty());
+}
+
+void test_Benchmarks::decodeLayerData_data()
+{
+    addBinaryLayerDataFormatRows();
+}
+
+void test_Benchmarks::decodeLayerData()
+{
+    QFETCH(int, format);
+    const auto layerDataFormat = static_cast<Map::LayerDataFormat>(format);
+
+    const TileLayer *tileLayer = firstTileLayer();
+    if (!tileLayer)
+        QSKIP("The map has no tile layers");
+
+    const GidMapper gidMapper(mMap->tilesets());
+    const QByteArray data = gidMapper.encodeLayerData(*tileLayer, layerDataFormat);
+
+    TileLayer decoded(QLatin1String("Decoded"), 0, 0,
+                      tileLayer->width(), tileLayer->height());
+
+    QBENCHMARK {
+        ScopedMeasurement measurement(mResults);
+        QCOMPARE(gidMapper.decodeLayerData(decoded, data, layerDataFormat),
+                 GidMapper::NoError);
+    }
+
+    QCOMPARE(decoded.cellAt(1, 1), tileLayer->cellAt(1, 1));
+}
+
+enum TileLayerOperation {
+    ReadCells,
+    WriteCells,
+    Copy,
+    Merge,
+    Flip,
+    Rotate,
+    Region,
+    UsedTilesets,
+    CloneAndResize
+};
+
+void test_Benchmarks::tileLayer_data()
+{
+    QTest::addColumn<int>("operation");
+
+    QTest::newRow("read cells") << int(ReadCells);
+    QTest::newRow("write cells") << int(WriteCells);
+    QTest::newRow("copy") << int(Copy);
+    QTest::newRow("merge") << int(Merge);
+    QTest::newRow("flip") << int(Flip);
+    QTest::newRow("rotate") << int(Rotate);
+    QTest::newRow("region") << int(Region);
+    QTest::newRow("used tilesets") << int(UsedTilesets);
+    QTest::newRow("clone and resize") << int(CloneAndResize);
+}
+
+void test_Benchmarks::tileLayer()
+{
+    QFETCH(int, operation);
+
+    const TileLayer *original = firstTileLayer();
+    if (!original)
+        QSKIP("The map has no tile layers");
+
+    QScopedPointer<TileLayer> tileLayer(static_cast<TileLayer*>(original->clone()));
+    const int width = tileLayer->width();
+    const int height = tileLayer->height();
+
+    // An irregular area covering half of the layer
+    QRegion area;
+    for (int y = 0; y < height; y += 2)
+        area += QRect(y % width, y, width - y % width, 1);
+
+    QScopedPointer<TileLayer> stamp(tileLayer->copy(area));
+    const Cell cell = tileLayer->cellAt(0, 0);
+    int count = 0;
+
+    QBENCHMARK {
+        ScopedMeasurement measurement(mResults);
+
+        switch (operation) {
+        case ReadCells:
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x)
+                    count += tileLayer->cellAt(x, y).isEmpty();
+            break;
+        case WriteCells:
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x)
+                    tileLayer->setCell(x, y, cell);
+            break;
+        case Copy:
+            delete tileLayer->copy(area);
+            break;
+        case Merge:
+            tileLayer->merge(QPoint(0, 0), stamp.data());
+            break;
+        case Flip:
+            tileLayer->flip(FlipHorizontally);
+            break;
+        case Rotate:
+            tileLayer->rotate(RotateRight);
+            break;
+        case Region:
+            count += tileLayer->region().rectCount();
+            break;
+        case UsedTilesets:
+            count += tileLayer->usedTilesets().size();
+            break;
+        case CloneAndResize: {
+            QScopedPointer<Layer> clone(tileLayer->clone());
+            static_cast<TileLayer*>(clone.data())->resize(QSize(width + 16, height + 16),
+                                                           QPoint(8, 8));
+            break;
+        }
+        }
+    }
+
+    QVERIFY(count >= 0);
+}
+
+/**
+ * Runs the benchmarks. Next to the usual QTest options, the following options
+ * are supported:
+ *
+ *   -size <n>          width and height of the generated map in tiles
+ *   -layers <n>        number of tile layers
+ *   -tilesets <n>      number of tilesets
+ *   -objects <n>       number of objects
+ *   -save <file>       saves the results as JSON
+ *   -baseline <file>   compares the results to those saved earlier
+ */
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    MapParameters parameters;
+    QString saveFileName;
+    QString baselineFileName;
+    QStringList testArguments;
+
+    const QStringList arguments = app.arguments();
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString &argument = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+
+        if (hasValue && argument == QLatin1String("-size"))
+            parameters.size = arguments.at(++i).toInt();
+        else if (hasValue && argument == QLatin1String("-layers"))
+            parameters.layers = arguments.at(++i).toInt();
+        else if (hasValue && argument == QLatin1String("-tilesets"))
+            parameters.tilesets = arguments.at(++i).toInt();
+        else if (hasValue && argument == QLatin1String("-objects"))
+            parameters.objects = arguments.at(++i).toInt();
+        else if (hasValue && argument == QLatin1String("-save"))
+            saveFileName = arguments.at(++i);
+        else if (hasValue && argument == QLatin1String("-baseline"))
+            baselineFileName = arguments.at(++i);
+        else
+            testArguments.append(argument);
+    }
+
+    // Objects are placed at random positions on the map, so it can't be empty
+    if (parameters.size <= 0 || parameters.layers < 0 ||
+            parameters.tilesets < 0 || parameters.objects < 0) {
+        qWarning().noquote() << "The map size needs to be positive, and the"
+                             << "numbers of layers, tilesets and objects can't be negative";
+        return 1;
+    }
+
+    test_Benchmarks benchmarks(parameters);
+    const int result = QTest::qExec(&benchmarks, testArguments);
+
+    if (!baselineFileName.isEmpty())
+        benchmarks.results().compare(baselineFileName, parameters);
+    if (!saveFileName.isEmpty() && !benchmarks.results().save(saveFileName, parameters))
+        return 1;
+
+    return result;
+}
+
+#include "test_benchmarks.moc"
@@ -0,0 +1,157 @@
+#include "imagecache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_ImageCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void sharedImages();
+    void missingFile();
+    void pixmapWithoutImage();
+    void releaseUnreferenced();
+    void reloadChangedFile();
+    void evictUnreferenced();
+
+private:
+    QString saveImage(const QString &name, int width, int height,
+                      const QColor &color = Qt::red);
+
+    QTemporaryDir mDir;
+};
+
+QString test_ImageCache::saveImage(const QString &name, int width, int height,
+                                   const QColor &color)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    image.fill(color);
+
+    const QString fileName = QDir(mDir.path()).filePath(name);
+    image.save(fileName, "png");
+    return fileName;
+}
+
+void test_ImageCache::init()
+{
+    ImageCache::clear();
+    ImageCache::setMaximumCost(256 * 1024 * 1024);
+}
+
+void test_ImageCache::cleanup()
+{
+    ImageCache::clear();
+}
+
+void test_ImageCache::sharedImages()
+{
+    const QString fileName = saveImage(QLatin1String("shared.png"), 16, 16);
+
+    const QImage first = ImageCache::loadImage(fileName);
+    const QImage second = ImageCache::loadImage(fileName);
+
+    QVERIFY(!first.isNull());
+    QCOMPARE(first.size(), QSize(16, 16));
+
+    // Both handles share the data of the cached image
+    QCOMPARE(first.constBits(), second.constBits());
+
+    // Equivalent paths map to the same entry
+    const QString otherPath = QDir(mDir.path()).filePath(QLatin1String("./shared.png"));
+    QCOMPARE(ImageCache::loadImage(otherPath).constBits(), first.constBits());
+
+    const QPixmap pixmap = ImageCache::loadPixmap(fileName);
+    QCOMPARE(pixmap.size(), QSize(16, 16));
+    QCOMPARE(ImageCache::loadPixmap(fileName).cacheKey(), pixmap.cacheKey());
+}
+
+void test_ImageCache::missingFile()
+{
+    const QString fileName = QDir(mDir.path()).filePath(QLatin1String("missing.png"));
+
+    QVERIFY(ImageCache::loadImage(fileName).isNull());
+    QVERIFY(ImageCache::loadPixmap(fileName).isNull());
+    QCOMPARE(ImageCache::totalCost(), qint64(0));
+}
+
+void test_ImageCache::pixmapWithoutImage()
+{
+    const QString fileName = saveImage(QLatin1String("pixmap.png"), 16, 16);
+
+    // The decoded image is not kept once it was converted to a pixmap
+    const QPixmap pixmap = ImageCache::loadPixmap(fileName);
+    QCOMPARE(ImageCache::totalCost(),
+             qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8);
+}
+
+void test_ImageCache::releaseUnreferenced()
+{
+    const QString fileName = saveImage(QLatin1String("release.png"), 16, 16);
+
+    // A decoded image that is not used elsewhere is dropped once converted
+    ImageCache::loadImage(fileName);
+    QPixmap pixmap = ImageCache::loadPixmap(fileName);
+    QCOMPARE(ImageCache::totalCost(),
+             qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8);
+
+    // Releasing keeps what is still in use
+    ImageCache::release(fileName);
+    QVERIFY(ImageCache::totalCost() > 0);
+
+    pixmap = QPixmap();
+    ImageCache::release(fileName);
+    QCOMPARE(ImageCache::totalCost(), qint64(0));
+}
+
+void test_ImageCache::reloadChangedFile()
+{
+    const QString fileName = saveImage(QLatin1String("changed.png"), 16, 16);
+    QCOMPARE(ImageCache::loadImage(fileName).size(), QSize(16, 16));
+
+    // A different size is noticed, even within the same second
+    saveImage(QLatin1String("changed.png"), 32, 32);
+    QCOMPARE(ImageCache::loadImage(fileName).size(), QSize(32, 32));
+
+    // Explicitly removing the file from the cache also works
+    const QImage before = ImageCache::loadImage(fileName);
+    ImageCache::remove(fileName);
+    QVERIFY(ImageCache::loadImage(fileName).constBits() != before.constBits());
+}
+
+void test_ImageCache::evictUnreferenced()
+{
+    const QString fileA = saveImage(QLatin1String("a.png"), 64, 64);
+    const QString fileB = saveImage(QLatin1String("b.png"), 64, 64);
+    const QString fileC = saveImage(QLatin1String("c.png"), 64, 64);
+    const qint64 imageSize = 64 * 64 * 4;
+
+    ImageCache::setMaximumCost(imageSize);
+
+    QImage a = ImageCache::loadImage(fileA);
+    const QImage b = ImageCache::loadImage(fileB);
+
+    // Images in use are kept, even though this exceeds the budget
+    QCOMPARE(ImageCache::totalCost(), 2 * imageSize);
+
+    // Once no longer referenced, an image is evicted when making room for
+    // another image
+    a = QImage();
+    const QImage c = ImageCache::loadImage(fileC);
+    QCOMPARE(ImageCache::totalCost(), 2 * imageSize);
+
+    // Loading it again requires decoding it again
+    a = ImageCache::loadImage(fileA);
+    QVERIFY(!a.isNull());
+    QCOMPARE(ImageCache::totalCost(), 3 * imageSize);
+}
+
+QTEST_MAIN(test_ImageCache)
+#include "test_imagecache.moc"
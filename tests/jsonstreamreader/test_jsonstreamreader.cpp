@@ -0,0 +1,153 @@
+#include "jsonstreamreader.h"
+#include "qjsonparser/json.h"
+
+#include "map.h"
+#include "maptovariantconverter.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "varianttomapconverter.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Json;
+
+class test_JsonStreamReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sameAsJsonReader_data();
+    void sameAsJsonReader();
+    void invalid_data();
+    void invalid();
+    void tileData();
+    void readMap();
+};
+
+void test_JsonStreamReader::sameAsJsonReader_data()
+{
+    QTest::addColumn<QByteArray>("json");
+
+    QTest::newRow("literals") << QByteArray("[true, false, null]");
+    QTest::newRow("numbers") << QByteArray("[0, -12, +3, 1.5, -2e3, 4E-2, 9007199254740993]");
+    QTest::newRow("strings") << QByteArray("[\"\", \"caf\xc3\xa9\", \"a\\/b\\n\\t\\\"q\\\"\\\\\", \"\\u20ac\\u00e9\"]");
+    QTest::newRow("nested") << QByteArray("{\"a\": {\"b\": [[], {}, [1, {\"c\": \"d\"}]]},\n"
+                                          " \"e\" : 2 }");
+    QTest::newRow("whitespace") << QByteArray("\r\n\t{ \"a\" :\t[ 1 ,2 ] }\n");
+    QTest::newRow("bom") << QByteArray("\xef\xbb\xbf{\"a\": 1}");
+    QTest::newRow("utf-16") << QByteArray("{\0\"\0a\0\"\0:\0 \0""1\0}\0", 16);
+    QTest::newRow("data with strings") << QByteArray("{\"data\": [1, \"2\", 3]}");
+    QTest::newRow("data with doubles") << QByteArray("{\"data\": [1, 2.5]}");
+    QTest::newRow("data with negative") << QByteArray("{\"data\": [1, -2]}");
+    QTest::newRow("data too large") << QByteArray("{\"data\": [1, 4294967296]}");
+    QTest::newRow("data as string") << QByteArray("{\"data\": \"eJzjYGBgAAAABAAB\"}");
+}
+
+void test_JsonStreamReader::sameAsJsonReader()
+{
+    QFETCH(QByteArray, json);
+
+    JsonReader jsonReader;
+    QVERIFY(jsonReader.parse(json));
+
+    JsonStreamReader reader;
+    QVERIFY(reader.parse(json));
+    QCOMPARE(reader.result(), jsonReader.result());
+}
+
+void test_JsonStreamReader::invalid_data()
+{
+    QTest::addColumn<QByteArray>("json");
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("unterminated object") << QByteArray("{\"a\": 1");
+    QTest::newRow("unterminated string") << QByteArray("[\"abc]");
+    QTest::newRow("missing colon") << QByteArray("{\"a\" 1}");
+    QTest::newRow("missing comma") << QByteArray("[1 2]");
+    QTest::newRow("trailing data") << QByteArray("{} {}");
+    QTest::newRow("bad literal") << QByteArray("[truex]");
+    QTest::newRow("unterminated data") << QByteArray("{\"data\": [1, 2");
+}
+
+void test_JsonStreamReader::invalid()
+{
+    QFETCH(QByteArray, json);
+
+    JsonStreamReader reader;
+    QVERIFY(!reader.parse(json));
+    QVERIFY(!reader.result().isValid());
+    QVERIFY(reader.errorOffset() >= 0);
+}
+
+void test_JsonStreamReader::tileData()
+{
+    JsonStreamReader reader;
+    QVERIFY(reader.parse("{\"data\": [0, 1,2 , 4294967295],\n \"other\": [1, 2]}"));
+
+    const QVariantMap map = reader.result().toMap();
+    const QVariant data = map.value(QLatin1String("data"));
+    QCOMPARE(data.userType(), qMetaTypeId<QVector<unsigned>>());
+    QCOMPARE(data.value<QVector<unsigned>>(),
+             QVector<unsigned>() << 0 << 1 << 2 << 4294967295u);
+
+    // Only arrays stored as "data" are read as tile data
+    QCOMPARE(map.value(QLatin1String("other")).userType(), int(QMetaType::QVariantList));
+}
+
+void test_JsonStreamReader::readMap()
+{
+    Map map(Map::Orthogonal, 4, 3, 16, 16);
+    map.setLayerDataFormat(Map::CSV);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("Tiles"), 16, 16);
+    for (int i = 0; i < 4; ++i) {
+        // Giving the tiles a type makes sure they are written
+        Tile *tile = tileset->addTile(QPixmap(16, 16));
+        tile->setType(QLatin1String("ground"));
+    }
+    map.addTileset(tileset);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("Ground"), 0, 0, 4, 3);
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            if (x == y)
+                continue;
+            Cell cell(tileset->tileAt((x + y) % 4));
+            cell.setFlippedVertically(x == 3);
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+    map.addLayer(tileLayer);
+
+    MapToVariantConverter mapToVariant;
+    JsonWriter writer;
+    QVERIFY(writer.stringify(mapToVariant.toVariant(map, QDir::current())));
+
+    JsonStreamReader reader;
+    QVERIFY(reader.parse(writer.result().toUtf8()));
+
+    VariantToMapConverter variantToMap;
+    QScopedPointer<Map> readMap(variantToMap.toMap(reader.result(), QDir::current()));
+    QVERIFY2(readMap, qPrintable(variantToMap.errorString()));
+
+    const TileLayer *readLayer = readMap->layerAt(0)->asTileLayer();
+    QVERIFY(readLayer);
+    QCOMPARE(readLayer->size(), tileLayer->size());
+
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            const Cell &expected = tileLayer->cellAt(x, y);
+            const Cell &actual = readLayer->cellAt(x, y);
+            QCOMPARE(actual.isEmpty(), expected.isEmpty());
+            if (expected.isEmpty())
+                continue;
+            QCOMPARE(actual.tileId(), expected.tileId());
+            QCOMPARE(actual.flippedVertically(), expected.flippedVertically());
+        }
+    }
+}
+
+QTEST_MAIN(test_JsonStreamReader)
+#include "test_jsonstreamreader.moc"
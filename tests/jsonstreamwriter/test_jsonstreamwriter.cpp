@@ -0,0 +1,131 @@
+#include "jsonstreamwriter.h"
+#include "qjsonparser/json.h"
+
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "maptovariantconverter.h"
+#include "objectgroup.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QBuffer>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Json;
+
+/**
+ * Creates a map using the various kinds of values that end up in the JSON
+ * output, including strings that need escaping.
+ */
+static Map *createMap()
+{
+    Map *map = new Map(Map::Orthogonal, 5, 4, 16, 16);
+    map->setProperty(QLatin1String("name"), QString::fromUtf8("caf\xc3\xa9 \"quoted\" a/b\n"));
+    map->setProperty(QLatin1String("float"), 0.1);
+    map->setProperty(QLatin1String("bool"), true);
+    map->setProperty(QLatin1String("int"), 42);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("Tiles"), 16, 16);
+    for (int i = 0; i < 4; ++i)
+        tileset->addTile(QPixmap(16, 16));
+    map->addTileset(tileset);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("Ground"), 0, 0, 5, 4);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 5; ++x) {
+            if ((x + y) % 3 == 0)
+                continue;
+            Cell cell(tileset->tileAt((x + y) % 4));
+            cell.setFlippedHorizontally(x == 2);
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+    tileLayer->setOpacity(0.5);
+    map->addLayer(tileLayer);
+
+    ObjectGroup *objectGroup = new ObjectGroup(QLatin1String("Objects"), 0, 0);
+    MapObject *object = new MapObject(QLatin1String("Tab\there"), QLatin1String("spawn"),
+                                      QPointF(1.5, 2.25), QSizeF(10, 20));
+    object->setRotation(33.3);
+    objectGroup->addObject(object);
+    map->addLayer(objectGroup);
+
+    map->addLayer(new ImageLayer(QLatin1String("Background"), 0, 0));
+
+    return map;
+}
+
+class test_JsonStreamWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sameAsJsonWriter_data();
+    void sameAsJsonWriter();
+    void tileset();
+};
+
+void test_JsonStreamWriter::sameAsJsonWriter_data()
+{
+    QTest::addColumn<bool>("autoFormatting");
+
+    QTest::newRow("formatted") << true;
+    QTest::newRow("compact") << false;
+}
+
+void test_JsonStreamWriter::sameAsJsonWriter()
+{
+    QFETCH(bool, autoFormatting);
+
+    QScopedPointer<Map> map(createMap());
+
+    MapToVariantConverter converter;
+    const QVariant variant = converter.toVariant(*map, QDir::current());
+
+    JsonWriter jsonWriter;
+    jsonWriter.setAutoFormatting(autoFormatting);
+    QVERIFY(jsonWriter.stringify(variant));
+
+    // The streaming writer gets the tile data without a QVariant per tile
+    MapToVariantConverter vectorConverter;
+    vectorConverter.setTileDataAsVector(true);
+    const QVariant vectorVariant = vectorConverter.toVariant(*map, QDir::current());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    {
+        JsonStreamWriter writer(&buffer);
+        writer.setAutoFormatting(autoFormatting);
+        QVERIFY(writer.write(vectorVariant));
+    }
+
+    QCOMPARE(buffer.data(), jsonWriter.result().toLatin1());
+}
+
+void test_JsonStreamWriter::tileset()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("Tiles"), 32, 32, 1, 2);
+    tileset->setProperty(QLatin1String("description"), QString::fromUtf8("\xe2\x82\xac and \\"));
+
+    MapToVariantConverter converter;
+    const QVariant variant = converter.toVariant(*tileset, QDir::current());
+
+    JsonWriter jsonWriter;
+    jsonWriter.setAutoFormatting(true);
+    QVERIFY(jsonWriter.stringify(variant));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    JsonStreamWriter writer(&buffer);
+    writer.setAutoFormatting(true);
+    QVERIFY(writer.write(variant));
+    writer.flush();
+
+    QCOMPARE(buffer.data(), jsonWriter.result().toLatin1());
+}
+
+QTEST_MAIN(test_JsonStreamWriter)
+#include "test_jsonstreamwriter.moc"
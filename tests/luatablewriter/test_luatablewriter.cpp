@@ -0,0 +1,179 @@
+#include "luatablewriter.h"
+
+#include "gidmapper.h"
+#include "luaplugin.h"
+#include "map.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QBuffer>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Lua;
+
+static const int LayerSize = 512;
+
+/**
+ * The ways in which the Lua plugin can write tile layer data.
+ */
+enum TileDataMode {
+    LuaTable,       // a table with the global tile ID of each cell
+    Base64Zlib      // a base64 encoded string of compressed data
+};
+
+/**
+ * Returns the global tile IDs of a layer filled with a repeating pattern of
+ * tiles from a tileset with 100 tiles.
+ */
+static QVector<unsigned> createTileData(int width, int height)
+{
+    QVector<unsigned> gids(width * height);
+    for (int i = 0; i < gids.size(); ++i)
+        gids[i] = (i * 7) % 101;
+    return gids;
+}
+
+/**
+ * Writes the tile data the way it was done before writeValues was available.
+ */
+static void writeTileDataPerValue(LuaTableWriter &writer,
+                                  const QVector<unsigned> &gids,
+                                  int width, int height)
+{
+    writer.writeStartTable("data");
+    for (int y = 0; y < height; ++y) {
+        if (y > 0)
+            writer.prepareNewLine();
+
+        for (int x = 0; x < width; ++x)
+            writer.writeValue(gids.at(y * width + x));
+    }
+    writer.writeEndTable();
+}
+
+static void writeTileDataPerRow(LuaTableWriter &writer,
+                                const QVector<unsigned> &gids,
+                                int width, int height)
+{
+    writer.writeStartTable("data");
+    for (int y = 0; y < height; ++y) {
+        if (y > 0)
+            writer.prepareNewLine();
+
+        writer.writeValues(gids.constData() + y * width, width);
+    }
+    writer.writeEndTable();
+}
+
+class test_LuaTableWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeValues();
+    void writeValuesLimits();
+
+    void benchmarkTileData_data();
+    void benchmarkTileData();
+};
+
+void test_LuaTableWriter::writeValues()
+{
+    const QVector<unsigned> gids = createTileData(5, 3);
+
+    QBuffer perValue;
+    perValue.open(QIODevice::WriteOnly);
+    {
+        LuaTableWriter writer(&perValue);
+        writer.writeStartReturnTable();
+        writer.writeKeyAndValue("width", 5);
+        writeTileDataPerValue(writer, gids, 5, 3);
+        writer.writeEndTable();
+        writer.writeEndDocument();
+    }
+
+    QBuffer perRow;
+    perRow.open(QIODevice::WriteOnly);
+    {
+        LuaTableWriter writer(&perRow);
+        writer.writeStartReturnTable();
+        writer.writeKeyAndValue("width", 5);
+        writeTileDataPerRow(writer, gids, 5, 3);
+        writer.writeEndTable();
+        writer.writeEndDocument();
+    }
+
+    QCOMPARE(perRow.data(), perValue.data());
+}
+
+void test_LuaTableWriter::writeValuesLimits()
+{
+    const unsigned values[] = { 0, 9, 10, 4294967295u };
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    LuaTableWriter writer(&buffer);
+    writer.writeStartTable();
+    writer.setSuppressNewlines(true);
+    writer.writeValues(values, 4);
+    writer.writeValues(values, 0);
+    writer.writeEndTable();
+
+    QCOMPARE(buffer.data(), QByteArray("{ 0, 9, 10, 4294967295 }"));
+}
+
+void test_LuaTableWriter::benchmarkTileData_data()
+{
+    QTest::addColumn<int>("mode");
+
+    QTest::newRow("lua table") << int(LuaTable);
+    QTest::newRow("base64 zlib") << int(Base64Zlib);
+}
+
+/**
+ * Compares the ways tile layer data can be written by the Lua plugin.
+ */
+void test_LuaTableWriter::benchmarkTileData()
+{
+    QFETCH(int, mode);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("Tiles"), 16, 16);
+    for (int i = 0; i < 100; ++i)
+        tileset->addTile(QPixmap());
+
+    GidMapper gidMapper;
+    gidMapper.insert(1, tileset.data());
+
+    const QVector<unsigned> gids = createTileData(LayerSize, LayerSize);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("Ground"), 0, 0, LayerSize, LayerSize);
+    for (int y = 0; y < LayerSize; ++y) {
+        for (int x = 0; x < LayerSize; ++x) {
+            bool ok;
+            tileLayer->setCell(x, y, gidMapper.gidToCell(gids.at(y * LayerSize + x), ok));
+        }
+    }
+
+    Map map(Map::Orthogonal, LayerSize, LayerSize, 16, 16);
+    map.setLayerDataFormat(mode == Base64Zlib ? Map::Base64Zlib : Map::CSV);
+    map.addTileset(tileset);
+    map.addLayer(tileLayer);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = QDir(dir.path()).filePath(QLatin1String("map.lua"));
+
+    Lua::LuaPlugin plugin;
+
+    QBENCHMARK {
+        QVERIFY2(plugin.write(&map, fileName), qPrintable(plugin.errorString()));
+    }
+
+    QVERIFY(QFileInfo(fileName).size() > 0);
+}
+
+QTEST_MAIN(test_LuaTableWriter)
+#include "test_luatablewriter.moc"
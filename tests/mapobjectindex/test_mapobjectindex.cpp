@@ -0,0 +1,256 @@
+#include "mapobject.h"
+#include "mapobjectindex.h"
+#include "objectgroup.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+/**
+ * Adds \a count randomly placed rectangle objects to the \a objectGroup.
+ * Some of them are large and some of them have no size.
+ */
+static void addRandomObjects(ObjectGroup &objectGroup, int count, uint seed)
+{
+    qsrand(seed);
+
+    for (int i = 0; i < count; ++i) {
+        const QPointF pos(qrand() % 10000 - 1000, qrand() % 10000 - 1000);
+        QSizeF size;
+
+        switch (qrand() % 4) {
+        case 0: break;
+        case 1: size = QSizeF(qrand() % 5000, qrand() % 5000); break;
+        default: size = QSizeF(qrand() % 100, qrand() % 100); break;
+        }
+
+        objectGroup.addObject(new MapObject(QString(), QString(), pos, size));
+    }
+}
+
+/**
+ * Finds the objects whose bounds intersect \a rect by going over all objects.
+ */
+static QList<MapObject*> objectsInRectSlow(const ObjectGroup &objectGroup,
+                                           const QRectF &rect)
+{
+    QList<MapObject*> objects;
+    for (MapObject *object : objectGroup.objects()) {
+        const QRectF bounds = object->bounds();
+        if (bounds.left() <= rect.right() && rect.left() <= bounds.right() &&
+                bounds.top() <= rect.bottom() && rect.top() <= bounds.bottom())
+            objects.append(object);
+    }
+    return objects;
+}
+
+class test_MapObjectIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void insertAndQuery();
+    void update();
+    void largeObjects();
+    void reorder();
+    void boundingRect();
+
+    void objectGroupQueries();
+    void objectGroupFollowsChanges();
+    void rotatedObject();
+
+    void benchmarkQuery();
+    void benchmarkLinearScan();
+};
+
+void test_MapObjectIndex::insertAndQuery()
+{
+    MapObject a, b, c;
+
+    MapObjectIndex index(10);
+    index.insert(&a, QRectF(0, 0, 5, 5));
+    index.insert(&b, QRectF(20, 20, 0, 0));
+    index.insert(&c, QRectF(-15, -15, 40, 40));
+
+    QCOMPARE(index.size(), 3);
+    QCOMPARE(index.at(QPointF(2, 2)), QList<MapObject*>() << &a << &c);
+    QCOMPARE(index.at(QPointF(20, 20)), QList<MapObject*>() << &b << &c);
+    QCOMPARE(index.at(QPointF(30, 30)), QList<MapObject*>());
+
+    // Touching counts as intersecting
+    QCOMPARE(index.intersecting(QRectF(5, 5, 15, 15)),
+             QList<MapObject*>() << &a << &b << &c);
+
+    index.remove(&c);
+    QCOMPARE(index.at(QPointF(2, 2)), QList<MapObject*>() << &a);
+    QVERIFY(!index.contains(&c));
+}
+
+void test_MapObjectIndex::update()
+{
+    MapObject a, b;
+
+    MapObjectIndex index(10);
+    index.insert(&a, QRectF(0, 0, 5, 5));
+    index.insert(&b, QRectF(100, 100, 5, 5));
+
+    // Moving keeps the insertion order
+    index.update(&a, QRectF(98, 98, 5, 5));
+    QCOMPARE(index.at(QPointF(0, 0)), QList<MapObject*>());
+    QCOMPARE(index.at(QPointF(101, 101)), QList<MapObject*>() << &a << &b);
+
+    // Growing within the same cells only changes the bounds
+    index.update(&b, QRectF(100, 100, 9, 9));
+    QCOMPARE(index.at(QPointF(108, 108)), QList<MapObject*>() << &b);
+}
+
+void test_MapObjectIndex::largeObjects()
+{
+    MapObject small, large;
+
+    MapObjectIndex index(10);
+    index.insert(&small, QRectF(50, 50, 1, 1));
+    index.insert(&large, QRectF(0, 0, 1000, 1000));
+
+    QCOMPARE(index.at(QPointF(500, 500)), QList<MapObject*>() << &large);
+    QCOMPARE(index.at(QPointF(50, 50)), QList<MapObject*>() << &small << &large);
+
+    // Shrinking moves the object back into the grid
+    index.update(&large, QRectF(0, 0, 5, 5));
+    QCOMPARE(index.at(QPointF(500, 500)), QList<MapObject*>());
+    QCOMPARE(index.at(QPointF(2, 2)), QList<MapObject*>() << &large);
+}
+
+void test_MapObjectIndex::reorder()
+{
+    MapObject a, b, c, d;
+
+    MapObjectIndex index(10);
+    index.insert(&a, QRectF(0, 0, 5, 5));
+    index.insert(&b, QRectF(0, 0, 5, 5));
+    index.insert(&c, QRectF(0, 0, 5, 5));
+    index.insert(&d, QRectF(0, 0, 5, 5));
+
+    index.reorder(QList<MapObject*>() << &c << &d, nullptr, &a);
+    QCOMPARE(index.at(QPointF(1, 1)), QList<MapObject*>() << &c << &d << &a << &b);
+
+    index.reorder(QList<MapObject*>() << &c, &a, &b);
+    QCOMPARE(index.at(QPointF(1, 1)), QList<MapObject*>() << &d << &a << &c << &b);
+
+    index.reorder(QList<MapObject*>() << &d, &b, nullptr);
+    QCOMPARE(index.at(QPointF(1, 1)), QList<MapObject*>() << &a << &c << &b << &d);
+
+    // Repeatedly moving between the same neighbors runs out of precision
+    for (int i = 0; i < 2000; ++i) {
+        index.reorder(QList<MapObject*>() << &b, &a, &c);
+        index.reorder(QList<MapObject*>() << &c, &a, &b);
+    }
+    QCOMPARE(index.at(QPointF(1, 1)), QList<MapObject*>() << &a << &c << &b << &d);
+}
+
+void test_MapObjectIndex::boundingRect()
+{
+    MapObject a, b, line;
+
+    MapObjectIndex index(10);
+    QCOMPARE(index.boundingRect(), QRectF());
+
+    // Covers the occupied cells
+    index.insert(&a, QRectF(12, 12, 5, 5));
+    index.insert(&b, QRectF(35, 45, 0, 0));
+    QCOMPARE(index.boundingRect(), QRectF(10, 10, 30, 40));
+
+    // Large objects are included with their exact bounds, also without width
+    index.insert(&line, QRectF(-100, 0, 0, 2000));
+    QCOMPARE(index.boundingRect(), QRectF(-100, 0, 140, 2000));
+
+    index.remove(&line);
+    index.remove(&b);
+    QCOMPARE(index.boundingRect(), QRectF(10, 10, 10, 10));
+}
+
+void test_MapObjectIndex::objectGroupQueries()
+{
+    ObjectGroup objectGroup;
+    addRandomObjects(objectGroup, 2000, 1);
+
+    const QRectF rects[] = {
+        QRectF(0, 0, 100, 100),
+        QRectF(-2000, -2000, 500, 20000),
+        QRectF(3000, 4000, 0, 0),
+        QRectF(-5000, -5000, 20000, 20000)
+    };
+
+    for (const QRectF &rect : rects)
+        QCOMPARE(objectGroup.objectsInRect(rect), objectsInRectSlow(objectGroup, rect));
+}
+
+void test_MapObjectIndex::objectGroupFollowsChanges()
+{
+    ObjectGroup objectGroup;
+    addRandomObjects(objectGroup, 500, 2);
+
+    const QRectF rect(1000, 1000, 200, 200);
+    QCOMPARE(objectGroup.objectsInRect(rect), objectsInRectSlow(objectGroup, rect));
+
+    // Moving and resizing objects updates the index
+    for (int i = 0; i < objectGroup.objectCount(); i += 3) {
+        MapObject *object = objectGroup.objectAt(i);
+        object->setPosition(QPointF(1100 + i % 50, 1100));
+        object->setSize(10, 10);
+    }
+    QCOMPARE(objectGroup.objectsInRect(rect), objectsInRectSlow(objectGroup, rect));
+
+    // Adding, removing and reordering objects
+    MapObject *object = new MapObject(QString(), QString(), QPointF(1050, 1050), QSizeF());
+    objectGroup.addObject(object);
+    MapObject *first = objectGroup.objectAt(0);
+    objectGroup.removeObjectAt(0);
+    delete first;
+    objectGroup.moveObjects(10, 0, 20);
+    objectGroup.moveObjects(5, 400, 10);
+    objectGroup.insertObject(100, new MapObject(QString(), QString(), QPointF(1150, 1150), QSizeF(5, 5)));
+    QCOMPARE(objectGroup.objectsInRect(rect), objectsInRectSlow(objectGroup, rect));
+
+    objectGroup.removeObject(object);
+    QVERIFY(!objectGroup.objectsAt(QPointF(1050, 1050)).contains(object));
+    delete object;
+}
+
+void test_MapObjectIndex::rotatedObject()
+{
+    ObjectGroup objectGroup;
+
+    // Rotating by 90 degrees around the top-left corner makes the object
+    // extend to the left of its position.
+    MapObject *object = new MapObject(QString(), QString(), QPointF(100, 100), QSizeF(50, 10));
+    objectGroup.addObject(object);
+    QVERIFY(objectGroup.objectsAt(QPointF(95, 140)).isEmpty());
+
+    object->setRotation(90);
+    QCOMPARE(objectGroup.objectsAt(QPointF(95, 140)), QList<MapObject*>() << object);
+}
+
+void test_MapObjectIndex::benchmarkQuery()
+{
+    ObjectGroup objectGroup;
+    addRandomObjects(objectGroup, 200000, 3);
+    objectGroup.objectsAt(QPointF());   // builds the index
+
+    QBENCHMARK {
+        objectGroup.objectsInRect(QRectF(4000, 4000, 300, 300));
+    }
+}
+
+void test_MapObjectIndex::benchmarkLinearScan()
+{
+    ObjectGroup objectGroup;
+    addRandomObjects(objectGroup, 200000, 3);
+
+    QBENCHMARK {
+        objectsInRectSlow(objectGroup, QRectF(4000, 4000, 300, 300));
+    }
+}
+
+QTEST_MAIN(test_MapObjectIndex)
+#include "test_mapobjectindex.moc"
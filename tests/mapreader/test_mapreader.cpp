@@ -1,19 +1,70 @@
 #include "map.h"
 #include "mapobject.h"
 #include "objectgroup.h"
+#include "tile.h"
+#include "tileimageloader.h"
 #include "tilelayer.h"
+#include "mappedxmlfile.h"
 #include "mapreader.h"
+#include "mapwriter.h"
 
+#include <QBuffer>
+#include <QImage>
+#include <QImageWriter>
+#include <QTemporaryDir>
 #include <QtTest/QtTest>
 
 using namespace Tiled;
 
+/**
+ * Returns a map with a collection tileset, of which each tile uses one of
+ * the given embedded PNG images.
+ */
+static QByteArray collectionMap(const QVector<QByteArray> &images)
+{
+    QByteArray tmx =
+            "<map version=\"1.0\" orientation=\"orthogonal\" width=\"2\""
+            " height=\"2\" tilewidth=\"4\" tileheight=\"4\">\n"
+            " <tileset firstgid=\"1\" name=\"Collection\" tilewidth=\"4\""
+            " tileheight=\"4\">\n";
+
+    for (int i = 0; i < images.size(); ++i) {
+        tmx += "  <tile id=\"" + QByteArray::number(i) + "\">"
+               "<image format=\"png\"><data encoding=\"base64\">"
+               + images.at(i).toBase64() +
+               "</data></image></tile>\n";
+    }
+
+    tmx += " </tileset>\n"
+           "</map>\n";
+    return tmx;
+}
+
+static QByteArray pngImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "png");
+    return data;
+}
+
 class test_MapReader : public QObject
 {
     Q_OBJECT
 
 private slots:
     void loadMap();
+    void loadTileImages();
+    void deferImageLoading();
+    void loadTileImagesOnFirstUse();
+    void embeddedImageFormats_data();
+    void embeddedImageFormats();
+    void readMappedFile();
+    void readMappedFileErrors();
 };
 
 void test_MapReader::loadMap()
@@ -53,5 +104,249 @@ void test_MapReader::loadMap()
     QCOMPARE(mapObject->height(), qreal(64));
 }
 
+void test_MapReader::loadTileImages()
+{
+    QVector<QByteArray> images;
+    for (int i = 0; i < 16; ++i)
+        images.append(pngImage(4 + i, 4));
+
+    QByteArray tmx = collectionMap(images);
+    QBuffer buffer(&tmx);
+    buffer.open(QIODevice::ReadOnly);
+
+    MapReader reader;
+    QScopedPointer<Map> map(reader.readMap(&buffer));
+
+    QVERIFY(map);
+    QVERIFY(reader.pendingImages().isEmpty());
+
+    const SharedTileset tileset = map->tilesetAt(0);
+    QCOMPARE(tileset->tileCount(), images.size());
+
+    for (int i = 0; i < images.size(); ++i) {
+        const Tile *tile = tileset->findTile(i);
+        QVERIFY(tile->imageLoaded());
+        QCOMPARE(tile->size(), QSize(4 + i, 4));
+    }
+}
+
+void test_MapReader::deferImageLoading()
+{
+    QByteArray tmx = collectionMap(QVector<QByteArray>() << pngImage(4, 4)
+                                                         << pngImage(8, 8));
+    QBuffer buffer(&tmx);
+    buffer.open(QIODevice::ReadOnly);
+
+    MapReader reader;
+    reader.setImageLoadingEnabled(false);
+    QScopedPointer<Map> map(reader.readMap(&buffer));
+
+    QVERIFY(map);
+
+    const SharedTileset tileset = map->tilesetAt(0);
+    QVERIFY(!tileset->findTile(0)->imageLoaded());
+    QVERIFY(!tileset->findTile(1)->imageLoaded());
+
+    const QVector<MapReader::PendingImage> &pendingImages = reader.pendingImages();
+    QCOMPARE(pendingImages.size(), 2);
+    QCOMPARE(pendingImages.at(0).tileset, tileset.data());
+    QCOMPARE(pendingImages.at(1).tileId, 1);
+    QVERIFY(!pendingImages.at(1).imageLayer);
+    QVERIFY(pendingImages.at(1).reference.hasImage());
+}
+
+void test_MapReader::loadTileImagesOnFirstUse()
+{
+    QTemporaryDir dir;
+    QFile small(dir.path() + QLatin1String("/small.png"));
+    small.open(QIODevice::WriteOnly);
+    small.write(pngImage(4, 4));
+    small.close();
+    QFile large(dir.path() + QLatin1String("/large.png"));
+    large.open(QIODevice::WriteOnly);
+    large.write(pngImage(8, 6));
+    large.close();
+
+    // Only the size of the first image is specified
+    QByteArray tsx =
+            "<tileset name=\"Collection\" tilewidth=\"4\" tileheight=\"4\">\n"
+            " <tile id=\"0\"><image source=\"small.png\" width=\"4\" height=\"4\"/></tile>\n"
+            " <tile id=\"1\"><image source=\"large.png\"/></tile>\n"
+            " <tile id=\"2\"><image source=\"missing.png\"/></tile>\n"
+            "</tileset>\n";
+    QBuffer buffer(&tsx);
+    buffer.open(QIODevice::ReadOnly);
+
+    MapReader reader;
+    const SharedTileset tileset = reader.readTileset(&buffer, dir.path());
+    QVERIFY(tileset);
+    QVERIFY(reader.pendingImages().isEmpty());
+
+    Tile *smallTile = tileset->findTile(0);
+    Tile *largeTile = tileset->findTile(1);
+    Tile *missingTile = tileset->findTile(2);
+
+    // The images are not loaded yet, but their size is known
+    QVERIFY(smallTile->hasDeferredImage());
+    QVERIFY(largeTile->hasDeferredImage());
+    QCOMPARE(largeTile->size(), QSize(8, 6));
+    QCOMPARE(tileset->tileWidth(), 8);
+    QCOMPARE(tileset->tileHeight(), 6);
+    QVERIFY(!missingTile->imageLoaded());
+
+    const qint64 costBefore = TileImageLoader::totalCost();
+
+    QCOMPARE(largeTile->image().size(), QSize(8, 6));
+    QVERIFY(!largeTile->hasDeferredImage());
+    QVERIFY(smallTile->hasDeferredImage());
+    QCOMPARE(TileImageLoader::totalCost(), costBefore + 8 * 6 * largeTile->image().depth() / 8);
+
+    // Unused images are released when exceeding the budget, and loaded again
+    // on their next use
+    const qint64 maximumCost = TileImageLoader::maximumCost();
+    TileImageLoader::setMaximumCost(0);
+    QVERIFY(largeTile->hasDeferredImage());
+    QCOMPARE(TileImageLoader::totalCost(), costBefore);
+    TileImageLoader::setMaximumCost(maximumCost);
+
+    QVERIFY(!largeTile->image().isNull());
+}
+
+void test_MapReader::embeddedImageFormats_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QByteArray>("formatName");
+
+    const bool webp = QImageWriter::supportedImageFormats().contains("webp");
+
+    QTest::newRow("png") << int(EmbedPng) << QByteArray("png");
+    QTest::newRow("pixel data") << int(EmbedPixelData) << QByteArray("rgba-premultiplied");
+    QTest::newRow("webp") << int(EmbedWebP) << QByteArray(webp ? "webp" : "png");
+}
+
+void test_MapReader::embeddedImageFormats()
+{
+    QFETCH(int, format);
+    QFETCH(QByteArray, formatName);
+
+    QImage image(6, 4, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+    for (int x = 0; x < 6; ++x)
+        image.setPixel(x, x % 4, qRgb(x * 40, 255 - x * 40, 128));
+
+    Map map(Map::Orthogonal, 2, 2, 6, 4);
+    SharedTileset tileset = Tileset::create(QLatin1String("Collection"), 6, 4);
+    tileset->addTile(QPixmap::fromImage(image));
+    map.addTileset(tileset);
+
+    QByteArray tmx;
+    QBuffer buffer(&tmx);
+    buffer.open(QIODevice::WriteOnly);
+
+    MapWriter writer;
+    writer.setEmbeddedImageFormat(static_cast<EmbeddedImageFormat>(format));
+    writer.writeMap(&map, &buffer);
+    buffer.close();
+
+    QVERIFY(tmx.contains("format=\"" + formatName + "\""));
+
+    // The format is detected when reading
+    buffer.open(QIODevice::ReadOnly);
+    MapReader reader;
+    QScopedPointer<Map> readMap(reader.readMap(&buffer));
+    QVERIFY(readMap);
+
+    const Tile *tile = readMap->tilesetAt(0)->findTile(0);
+    QVERIFY(tile->imageLoaded());
+    QCOMPARE(tile->image().toImage().convertToFormat(QImage::Format_ARGB32),
+             image);
+}
+
+/**
+ * Returns a map with a base64 encoded layer, split over several lines, and
+ * an embedded image. The comment should not be mistaken for layer data.
+ */
+static QByteArray base64Map()
+{
+    QByteArray gids;
+    for (int i = 0; i < 4; ++i)
+        gids.append(char(1)).append(char(0)).append(char(0)).append(char(0));
+    const QByteArray base64 = gids.toBase64();
+
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           "<map version=\"1.0\" orientation=\"orthogonal\" width=\"2\""
+           " height=\"2\" tilewidth=\"4\" tileheight=\"4\">\n"
+           " <tileset firstgid=\"1\" name=\"Collection\" tilewidth=\"4\""
+           " tileheight=\"4\">\n"
+           "  <tile id=\"0\"><image format=\"png\"><data encoding=\"base64\">\n"
+           + pngImage(4, 4).toBase64() + "\n"
+           "  </data></image></tile>\n"
+           " </tileset>\n"
+           " <!-- <data encoding=\"base64\">AAAA</data> -->\n"
+           " <layer name=\"Ground\" width=\"2\" height=\"2\">\n"
+           "  <data encoding='base64'>\n"
+           "   " + base64.left(8) + "\n"
+           "   " + base64.mid(8) + "\n"
+           "  </data>\n"
+           " </layer>\n"
+           "</map>\n";
+}
+
+static QString writeFile(const QTemporaryDir &dir, const QByteArray &contents)
+{
+    const QString fileName = dir.path() + QLatin1String("/map.tmx");
+    QFile file(fileName);
+    file.open(QIODevice::WriteOnly);
+    file.write(contents);
+    return fileName;
+}
+
+void test_MapReader::readMappedFile()
+{
+    QTemporaryDir dir;
+    QByteArray tmx = base64Map();
+    const QString fileName = writeFile(dir, tmx);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    MappedXmlFile mappedFile(&file);
+    QVERIFY(mappedFile.isMapped());
+    QCOMPARE(mappedFile.payloadCount(), 2);
+
+    MapReader reader;
+    QScopedPointer<Map> map(reader.readMap(fileName));
+    QVERIFY2(map, qPrintable(reader.errorString()));
+
+    const TileLayer *layer = map->layerAt(0)->asTileLayer();
+    QVERIFY(layer);
+    for (int y = 0; y < 2; ++y)
+        for (int x = 0; x < 2; ++x)
+            QCOMPARE(layer->cellAt(x, y).tileId(), 0);
+
+    const Tile *tile = map->tilesetAt(0)->findTile(0);
+    QVERIFY(tile->imageLoaded());
+    QCOMPARE(tile->size(), QSize(4, 4));
+}
+
+void test_MapReader::readMappedFileErrors()
+{
+    // Line numbers are the same as when reading from the device
+    QByteArray tmx = base64Map();
+    tmx.replace("</map>", "<map>");
+
+    QTemporaryDir dir;
+    const QString fileName = writeFile(dir, tmx);
+
+    QBuffer buffer(&tmx);
+    buffer.open(QIODevice::ReadOnly);
+
+    MapReader deviceReader;
+    QVERIFY(!deviceReader.readMap(&buffer));
+
+    MapReader fileReader;
+    QVERIFY(!fileReader.readMap(fileName));
+    QCOMPARE(fileReader.errorString(), deviceReader.errorString());
+}
+
 QTEST_MAIN(test_MapReader)
 #include "test_mapreader.moc"
@@ -0,0 +1,211 @@
+#include "map.h"
+#include "staggeredrenderer.h"
+#include "terrain.h"
+#include "terrainfiller.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+/**
+ * Creates a tileset with two terrains and a tile for each combination of
+ * terrains at the corners. The id of each tile has one bit per corner, which
+ * is set when that corner has the second terrain.
+ */
+static SharedTileset createTerrainTileset()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("Terrain"), 32, 32);
+    tileset->addTerrain(QLatin1String("Grass"), 0);
+    tileset->addTerrain(QLatin1String("Water"), 15);
+
+    for (int id = 0; id < 16; ++id) {
+        Tile *tile = tileset->findOrCreateTile(id);
+        tile->setTerrain(makeTerrain((id >> 3) & 1,
+                                     (id >> 2) & 1,
+                                     (id >> 1) & 1,
+                                     id & 1));
+    }
+
+    return tileset;
+}
+
+static void fillLayer(TileLayer &layer, Tile *tile)
+{
+    for (int y = 0; y < layer.height(); ++y)
+        for (int x = 0; x < layer.width(); ++x)
+            layer.setCell(x, y, Cell(tile));
+}
+
+static QVector<TerrainFiller::Point> blockOfPoints(const QRect &rect)
+{
+    QVector<TerrainFiller::Point> points;
+    points.reserve(rect.width() * rect.height());
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        for (int x = rect.left(); x <= rect.right(); ++x)
+            points.append(QPoint(x, y));
+    return points;
+}
+
+class test_TerrainFiller : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void paintTile();
+    void paintCorner();
+    void timeBudget();
+    void staggered();
+
+    void benchmarkLargeArea();
+    void benchmarkRepeatedFill();
+
+private:
+    SharedTileset mTileset;
+};
+
+void test_TerrainFiller::initTestCase()
+{
+    mTileset = createTerrainTileset();
+}
+
+void test_TerrainFiller::paintTile()
+{
+    TileLayer layer(QString(), 0, 0, 10, 10);
+    fillLayer(layer, mTileset->tileAt(0));
+
+    TerrainFiller filler;
+    filler.begin(&layer, nullptr, mTileset->terrain(1), false,
+                 QVector<TerrainFiller::Point>() << QPoint(5, 5));
+
+    QVERIFY(filler.proceed());
+    QCOMPARE(filler.region(), QRegion(4, 4, 3, 3));
+
+    const SharedTileLayer stamp = filler.stamp();
+    QVERIFY(stamp);
+    QCOMPARE(stamp->bounds(), QRect(4, 4, 3, 3));
+
+    const int expected[3][3] = {
+        { 1, 3, 2 },
+        { 5, 15, 10 },
+        { 4, 12, 8 }
+    };
+
+    for (int y = 0; y < 3; ++y)
+        for (int x = 0; x < 3; ++x)
+            QCOMPARE(stamp->cellAt(x, y).tileId(), expected[y][x]);
+}
+
+void test_TerrainFiller::paintCorner()
+{
+    TileLayer layer(QString(), 0, 0, 10, 10);
+    fillLayer(layer, mTileset->tileAt(0));
+
+    // Painting the bottom-right corner of a tile affects the four tiles
+    // sharing that corner.
+    TerrainFiller filler;
+    filler.begin(&layer, nullptr, mTileset->terrain(1), true,
+                 QVector<TerrainFiller::Point>() << TerrainFiller::Point(QPoint(4, 4), 3));
+
+    QVERIFY(filler.proceed());
+    QCOMPARE(filler.region(), QRegion(4, 4, 2, 2));
+
+    const SharedTileLayer stamp = filler.stamp();
+    QCOMPARE(stamp->cellAt(0, 0).tileId(), 1);
+    QCOMPARE(stamp->cellAt(1, 0).tileId(), 2);
+    QCOMPARE(stamp->cellAt(0, 1).tileId(), 4);
+    QCOMPARE(stamp->cellAt(1, 1).tileId(), 8);
+}
+
+void test_TerrainFiller::timeBudget()
+{
+    TileLayer layer(QString(), 0, 0, 400, 400);
+    fillLayer(layer, mTileset->tileAt(0));
+
+    const QVector<TerrainFiller::Point> startPoints = blockOfPoints(QRect(50, 50, 300, 300));
+
+    TerrainFiller reference;
+    reference.begin(&layer, nullptr, mTileset->terrain(1), false, startPoints);
+    QVERIFY(reference.proceed());
+    QCOMPARE(reference.region(), QRegion(49, 49, 302, 302));
+
+    // A small budget spreads the work over several calls, but arrives at the
+    // same result.
+    TerrainFiller filler;
+    filler.begin(&layer, nullptr, mTileset->terrain(1), false, startPoints);
+    while (!filler.proceed(1))
+        QVERIFY(!filler.isFinished());
+
+    QCOMPARE(filler.region(), reference.region());
+
+    // Filling again reuses the scratch buffers without leaking state from
+    // the previous fill.
+    filler.begin(&layer, nullptr, mTileset->terrain(1), false,
+                 QVector<TerrainFiller::Point>() << QPoint(5, 5));
+    QVERIFY(filler.proceed());
+    QCOMPARE(filler.region(), QRegion(4, 4, 3, 3));
+}
+
+void test_TerrainFiller::staggered()
+{
+    Map map(Map::Staggered, 10, 10, 64, 32);
+    StaggeredRenderer renderer(&map);
+
+    TileLayer layer(QString(), 0, 0, 10, 10);
+    fillLayer(layer, mTileset->tileAt(0));
+
+    TerrainFiller filler;
+    filler.begin(&layer, &renderer, mTileset->terrain(1), false,
+                 QVector<TerrainFiller::Point>() << QPoint(5, 5));
+    QVERIFY(filler.proceed());
+
+    // The tile and its four diagonal neighbours on the staggered grid
+    const QRegion region = filler.region();
+    QVERIFY(region.contains(QPoint(5, 5)));
+    QVERIFY(region.contains(renderer.topLeft(5, 5)));
+    QVERIFY(region.contains(renderer.topRight(5, 5)));
+    QVERIFY(region.contains(renderer.bottomLeft(5, 5)));
+    QVERIFY(region.contains(renderer.bottomRight(5, 5)));
+}
+
+void test_TerrainFiller::benchmarkLargeArea()
+{
+    TileLayer layer(QString(), 0, 0, 1000, 1000);
+    fillLayer(layer, mTileset->tileAt(0));
+
+    const QVector<TerrainFiller::Point> startPoints = blockOfPoints(QRect(100, 100, 800, 800));
+    TerrainFiller filler;
+
+    QBENCHMARK {
+        filler.begin(&layer, nullptr, mTileset->terrain(1), false, startPoints);
+        filler.proceed();
+    }
+}
+
+void test_TerrainFiller::benchmarkRepeatedFill()
+{
+    // Simulates moving the brush over a large map, where each update only
+    // touches a few tiles.
+    TileLayer layer(QString(), 0, 0, 1000, 1000);
+    fillLayer(layer, mTileset->tileAt(0));
+
+    TerrainFiller filler;
+    int x = 0;
+
+    QBENCHMARK {
+        filler.begin(&layer, nullptr, mTileset->terrain(1), false,
+                     QVector<TerrainFiller::Point>() << QPoint(x, 500));
+        filler.proceed();
+        filler.stamp();
+        filler.region();
+        x = (x + 1) % layer.width();
+    }
+}
+
+QTEST_MAIN(test_TerrainFiller)
+#include "test_terrainfiller.moc"
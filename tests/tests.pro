@@ -1,4 +1,13 @@
 TEMPLATE=subdirs
 SUBDIRS = \
+    benchmarks \
+    imagecache \
+    jsonstreamreader \
+    jsonstreamwriter \
+    luatablewriter \
+    mapobjectindex \
     mapreader \
-    staggeredrenderer
+    staggeredrenderer \
+    terrainfiller \
+    tilemask \
+    tilesetcache
@@ -0,0 +1,167 @@
+#include "tilemask.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+/**
+ * Creates a noisy region, in which each tile within \a bounds is included
+ * with a chance of one in two.
+ */
+static QRegion randomRegion(const QRect &bounds, uint seed)
+{
+    qsrand(seed);
+
+    QRegion region;
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y)
+        for (int x = bounds.left(); x <= bounds.right(); ++x)
+            if (qrand() % 2)
+                region += QRect(x, y, 1, 1);
+
+    return region;
+}
+
+/**
+ * Like randomRegion(), but builds a mask directly, which is a lot faster for
+ * large areas.
+ */
+static TileMask randomMask(const QRect &bounds, uint seed)
+{
+    qsrand(seed);
+
+    TileMask mask;
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y)
+        for (int x = bounds.left(); x <= bounds.right(); ++x)
+            if (qrand() % 2)
+                mask.addSpan(y, x, x);
+
+    return mask;
+}
+
+class test_TileMask : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void empty();
+    void addSpan();
+    void regionConversion();
+    void contains();
+    void setOperations();
+    void translate();
+
+    void benchmarkMaskUnite();
+    void benchmarkRegionUnite();
+};
+
+void test_TileMask::empty()
+{
+    TileMask mask;
+    QVERIFY(mask.isEmpty());
+    QCOMPARE(mask.boundingRect(), QRect());
+    QCOMPARE(mask.toRegion(), QRegion());
+    QCOMPARE(mask.cellCount(), 0);
+
+    mask.addRect(QRect(2, 2, 3, 3));
+    mask.subtract(TileMask(QRect(0, 0, 10, 10)));
+    QVERIFY(mask.isEmpty());
+    QCOMPARE(mask, TileMask());
+}
+
+void test_TileMask::addSpan()
+{
+    TileMask mask;
+    mask.addSpan(1, 5, 6);
+    mask.addSpan(1, 0, 1);
+    mask.addSpan(1, 2, 4);     // joins both runs
+    mask.addSpan(-1, 3, 3);
+
+    QCOMPARE(mask.top(), -1);
+    QCOMPARE(mask.bottom(), 1);
+    QCOMPARE(mask.row(1).size(), 1);
+    QCOMPARE(mask.row(1).first().left, 0);
+    QCOMPARE(mask.row(1).first().right, 6);
+    QVERIFY(mask.row(0).isEmpty());
+    QCOMPARE(mask.boundingRect(), QRect(0, -1, 7, 3));
+    QCOMPARE(mask.cellCount(), 8);
+}
+
+void test_TileMask::regionConversion()
+{
+    const QRegion region = randomRegion(QRect(-10, -5, 40, 30), 1);
+    const TileMask mask(region);
+
+    QCOMPARE(mask.toRegion(), region);
+    QCOMPARE(mask.boundingRect(), region.boundingRect());
+
+    // Identical rows are merged into a single band
+    const QRegion rectangle(3, 4, 10, 20);
+    QCOMPARE(TileMask(rectangle).toRegion().rectCount(), 1);
+}
+
+void test_TileMask::contains()
+{
+    const QRegion region = randomRegion(QRect(0, 0, 20, 20), 2);
+    const TileMask mask(region);
+
+    for (int y = -1; y <= 20; ++y)
+        for (int x = -1; x <= 20; ++x)
+            QCOMPARE(mask.contains(x, y), region.contains(QPoint(x, y)));
+}
+
+void test_TileMask::setOperations()
+{
+    const QRegion a = randomRegion(QRect(0, 0, 30, 30), 3);
+    const QRegion b = randomRegion(QRect(10, 15, 30, 30), 4);
+    const TileMask maskA(a);
+    const TileMask maskB(b);
+
+    QCOMPARE(maskA.united(maskB).toRegion(), a.united(b));
+    QCOMPARE(maskA.intersected(maskB).toRegion(), a.intersected(b));
+    QCOMPARE(maskA.subtracted(maskB).toRegion(), a.subtracted(b));
+    QCOMPARE(maskB.subtracted(maskA).toRegion(), b.subtracted(a));
+    QCOMPARE(maskA.intersects(maskB), a.intersects(b));
+
+    QCOMPARE(maskA.united(maskB), TileMask(a.united(b)));
+
+    const TileMask disjoint(QRect(100, 100, 5, 5));
+    QVERIFY(!maskA.intersects(disjoint));
+    QVERIFY(maskA.intersected(disjoint).isEmpty());
+    QCOMPARE(maskA.subtracted(disjoint), maskA);
+}
+
+void test_TileMask::translate()
+{
+    const QRegion region = randomRegion(QRect(0, 0, 10, 10), 5);
+    const QPoint offset(-3, 7);
+
+    QCOMPARE(TileMask(region).translated(offset).toRegion(),
+             region.translated(offset));
+}
+
+void test_TileMask::benchmarkMaskUnite()
+{
+    const TileMask noise = randomMask(QRect(0, 0, 300, 300), 6);
+
+    QBENCHMARK {
+        TileMask mask;
+        for (int y = noise.top(); y <= noise.bottom(); ++y)
+            for (const TileMask::Span &span : noise.row(y))
+                mask += TileMask(QRect(span.left, y, span.width(), 1));
+    }
+}
+
+void test_TileMask::benchmarkRegionUnite()
+{
+    const TileMask noise = randomMask(QRect(0, 0, 300, 300), 6);
+
+    QBENCHMARK {
+        QRegion region;
+        for (int y = noise.top(); y <= noise.bottom(); ++y)
+            for (const TileMask::Span &span : noise.row(y))
+                region += QRect(span.left, y, span.width(), 1);
+    }
+}
+
+QTEST_MAIN(test_TileMask)
+#include "test_tilemask.moc"
@@ -0,0 +1,174 @@
+#include "imagecache.h"
+#include "mapreader.h"
+#include "tile.h"
+#include "tilesetcache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TilesetCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void disabledByDefault();
+    void storeAndLoad();
+    void deferImageLoading();
+    void invalidatedByChanges();
+
+private:
+    QString writeTileset(const QString &name);
+    QString cacheDirectory() const;
+
+    QTemporaryDir mDir;
+};
+
+/**
+ * Writes a tileset with two 32x32 tiles, the first one red and the second
+ * one blue, along with its image.
+ */
+QString test_TilesetCache::writeTileset(const QString &name)
+{
+    QImage image(64, 32, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    for (int y = 0; y < 32; ++y)
+        for (int x = 32; x < 64; ++x)
+            image.setPixel(x, y, qRgb(0, 0, 255));
+
+    const QDir dir(mDir.path());
+    image.save(dir.filePath(QLatin1String("tiles.png")), "png");
+
+    const QString fileName = dir.filePath(QLatin1String("tiles.tsx"));
+    QFile file(fileName);
+    file.open(QIODevice::WriteOnly);
+    file.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<tileset name=\"" + name.toUtf8() + "\" tilewidth=\"32\" tileheight=\"32\" tilecount=\"2\" columns=\"2\">\n"
+               " <image source=\"tiles.png\" width=\"64\" height=\"32\"/>\n"
+               " <tile id=\"1\" type=\"water\">\n"
+               "  <properties>\n"
+               "   <property name=\"depth\" type=\"int\" value=\"3\"/>\n"
+               "  </properties>\n"
+               " </tile>\n"
+               "</tileset>\n");
+    return fileName;
+}
+
+QString test_TilesetCache::cacheDirectory() const
+{
+    return QDir(mDir.path()).filePath(QLatin1String("cache"));
+}
+
+void test_TilesetCache::init()
+{
+    TilesetCache::setCacheDirectory(cacheDirectory());
+    ImageCache::clear();
+}
+
+void test_TilesetCache::cleanup()
+{
+    TilesetCache::clear();
+    TilesetCache::setCacheDirectory(QString());
+    ImageCache::clear();
+}
+
+void test_TilesetCache::disabledByDefault()
+{
+    TilesetCache::setCacheDirectory(QString());
+    QVERIFY(!TilesetCache::isEnabled());
+
+    const QString fileName = writeTileset(QLatin1String("Disabled"));
+
+    MapReader reader;
+    QVERIFY(reader.readTileset(fileName));
+    QVERIFY(!TilesetCache::load(fileName));
+    QVERIFY(!QDir(cacheDirectory()).exists());
+}
+
+void test_TilesetCache::storeAndLoad()
+{
+    const QString fileName = writeTileset(QLatin1String("Cached"));
+
+    // Reading the tileset the first time writes the cache entry
+    MapReader reader;
+    const SharedTileset original = reader.readTileset(fileName);
+    QVERIFY(original);
+    QCOMPARE(QDir(cacheDirectory()).entryList(QDir::Files).size(), 1);
+
+    ImageCache::clear();
+
+    const SharedTileset cached = TilesetCache::load(fileName);
+    QVERIFY(cached);
+    QCOMPARE(cached->name(), QLatin1String("Cached"));
+    QCOMPARE(cached->fileName(), fileName);
+    QCOMPARE(cached->tileCount(), 2);
+    QCOMPARE(cached->columnCount(), 2);
+    QCOMPARE(cached->imageSource(), original->imageSource());
+    QCOMPARE(cached->tileAt(1)->type(), QLatin1String("water"));
+    QCOMPARE(cached->tileAt(1)->property(QLatin1String("depth")), QVariant(3));
+
+    const QImage red = cached->tileAt(0)->image().toImage();
+    const QImage blue = cached->tileAt(1)->image().toImage();
+    QCOMPARE(red.size(), QSize(32, 32));
+    QCOMPARE(QColor(red.pixel(0, 0)), QColor(Qt::red));
+    QCOMPARE(QColor(blue.pixel(0, 0)), QColor(Qt::blue));
+
+    // The pixels were provided by the cache rather than by decoding the file
+    QCOMPARE(ImageCache::loadImage(original->imageSource()).format(),
+             QImage::Format_ARGB32_Premultiplied);
+}
+
+void test_TilesetCache::deferImageLoading()
+{
+    const QString fileName = writeTileset(QLatin1String("Deferred"));
+
+    // Without its images, the tileset is not stored
+    MapReader reader;
+    reader.setImageLoadingEnabled(false);
+    QVERIFY(reader.readTileset(fileName));
+    QVERIFY(!TilesetCache::load(fileName));
+
+    reader.setImageLoadingEnabled(true);
+    QVERIFY(reader.readTileset(fileName));
+
+    // A cache hit still reports the images to load when loading is deferred
+    reader.setImageLoadingEnabled(false);
+    const SharedTileset tileset = reader.readTileset(fileName);
+    QVERIFY(tileset);
+    QVERIFY(tileset->tileAt(0)->image().isNull());
+    QCOMPARE(reader.pendingImages().size(), 1);
+    QCOMPARE(reader.pendingImages().first().tileId, -1);
+    QCOMPARE(reader.pendingImages().first().reference.source, tileset->imageSource());
+}
+
+void test_TilesetCache::invalidatedByChanges()
+{
+    const QString fileName = writeTileset(QLatin1String("Before"));
+
+    MapReader reader;
+    QVERIFY(reader.readTileset(fileName));
+    QVERIFY(TilesetCache::load(fileName));
+
+    // A different file size is noticed, even within the same second
+    writeTileset(QLatin1String("Changed"));
+    QVERIFY(!TilesetCache::load(fileName));
+
+    // Reading the tileset again updates the entry
+    QCOMPARE(reader.readTileset(fileName)->name(), QLatin1String("Changed"));
+    QCOMPARE(TilesetCache::load(fileName)->name(), QLatin1String("Changed"));
+
+    // Changing the image also invalidates the entry
+    QImage image(64, 64, QImage::Format_ARGB32);
+    image.fill(Qt::green);
+    image.save(QDir(mDir.path()).filePath(QLatin1String("tiles.png")), "png");
+    QVERIFY(!TilesetCache::load(fileName));
+}
+
+QTEST_MAIN(test_TilesetCache)
+#include "test_tilesetcache.moc"